@@ -0,0 +1,123 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+/*
+ * Benchmark: encoding and decoding PDU's in big endian vs. host byte order.
+ *
+ * A ResponsePDU with 20 Counter64 varbinds (like the answer to a GetBulk
+ * request for ifHCInOctets and ifHCOutOctets of 10 interfaces) is
+ *
+ *  - serialized with ResponsePDU::serialize_to() into a reused
+ *    SegmentedBuffer, as done by UnixDomainConnector::do_send(), and
+ *  - parsed with PDU::parse_pdu(), as done for received PDU's,
+ *
+ * once in big endian format and once in the host's byte order (see
+ * MasterProxy::setNativeByteOrder()). One line is printed per byte order:
+ *
+ *   order=<big|native> serialize_ns=<t> parse_ns=<t>
+ *
+ * The times are per PDU. On big endian hosts, both lines measure the same
+ * code.
+ */
+
+#include <sys/time.h>
+#include <cstdio>
+
+#include <QSharedPointer>
+
+#include "ResponsePDU.hpp"
+#include "Counter64Variable.hpp"
+#include "SegmentedBuffer.hpp"
+
+using namespace agentxcpp;
+
+
+// Number of serialized resp. parsed PDU's per byte order
+static const long iterations = 200000;
+
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static unsigned long run(const ResponsePDU& response, bool big_endian)
+{
+    SegmentedBuffer buffer;
+    buffer.setBigEndian(big_endian);
+    unsigned long sum = 0;
+
+    // Serialize (the first PDU warms up the buffer)
+    response.serialize_to(buffer);
+    buffer.clear();
+    double start = now();
+    for(long i = 0; i < iterations; i++)
+    {
+        response.serialize_to(buffer);
+        sum += buffer.size();
+        buffer.clear();
+    }
+    double serialize_time = now() - start;
+
+    // Parse
+    response.serialize_to(buffer);
+    binary data = buffer.toBinary();
+    start = now();
+    for(long i = 0; i < iterations; i++)
+    {
+        QSharedPointer<PDU> pdu = PDU::parse_pdu(data);
+        sum += pdu->get_packetID();
+    }
+    double parse_time = now() - start;
+
+    printf("order=%s serialize_ns=%.1f parse_ns=%.1f\n",
+           big_endian ? "big" : "native",
+           serialize_time * 1e9 / iterations,
+           parse_time * 1e9 / iterations);
+
+    return sum;
+}
+
+int main()
+{
+    // Build the response
+    ResponsePDU response;
+    response.set_packetID(1);
+    for(quint32 column = 6; column <= 10; column += 4)
+    {
+        for(quint32 i = 1; i <= 10; i++)
+        {
+            Oid name("1.3.6.1.2.1.31.1.1.1");
+            name.push_back(column);
+            name.push_back(i);
+            response.varbindlist.push_back(Varbind(name,
+                    QSharedPointer<AbstractVariable>(
+                        new Counter64Variable(quint64(1000000007) * i))));
+        }
+    }
+
+    unsigned long sum = 0;
+    sum += run(response, true);
+    sum += run(response, host_big_endian);
+
+    // Use the sum, so that the loops cannot be optimized away
+    return sum == 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+/*
+ * Benchmark: round trip time and throughput of the connector backends.
+ *
+ * A local master agent stand-in (see master_standin.hpp) sends GetNext
+ * requests for a table row (10 SearchRanges) to a MasterProxy and waits
+ * for the responses. This is done for each backend (see
+ * MasterProxy::backend_t):
+ *
+ *  - once with one outstanding request at a time (window=1), measuring
+ *    the latency, and
+ *  - once with 32 outstanding requests (window=32), measuring the
+ *    throughput.
+ *
+ * One line is printed per backend and window:
+ *
+ *   backend=<name> window=<w> requests=<n> mean_us=<t> p50_us=<t>
+ *   p99_us=<t> requests_per_s=<r> lost=<n>
+ *
+ * The uring backend is skipped if the library was built without
+ * --with-io-uring or if io_uring is not available:
+ *
+ *   backend=uring skipped=unavailable
+ *
+ * Both the stand-in and the subagent run in this process, on different
+ * threads. For the embedded backend, the main thread runs a poll() loop
+ * instead of the Qt event loop.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cstdio>
+
+#include <QCoreApplication>
+#include <QSharedPointer>
+
+#include "MasterProxy.hpp"
+#include "GetNextPDU.hpp"
+#include "IntegerVariable.hpp"
+#include "master_standin.hpp"
+
+using namespace agentxcpp;
+
+
+// Number of requests per measurement
+static const long latency_requests = 20000;
+static const long throughput_requests = 100000;
+
+
+// The measurement, run in its own thread while the main thread runs the
+// Qt event loop (which is needed by the MasterProxy)
+struct Measurement
+{
+    const char* backend;
+    MasterStandin* master;
+    QSharedPointer<PDU> request;
+    volatile bool done;
+};
+
+static void report(const char* backend, int window, long requests,
+                   const MasterStandin::Result& r, long lost)
+{
+    printf("backend=%s window=%d requests=%ld mean_us=%.1f p50_us=%.1f "
+           "p99_us=%.1f requests_per_s=%.0f lost=%ld\n",
+           backend, window, requests, r.mean_us, r.p50_us, r.p99_us,
+           r.requests_per_s, lost);
+    fflush(stdout);
+}
+
+static void* measure(void* arg)
+{
+    Measurement* m = static_cast<Measurement*>(arg);
+
+    // Warm up
+    m->master->run(m->request, 1000, 1);
+
+    MasterStandin::Result r;
+    r = m->master->run(m->request, latency_requests, 1);
+    report(m->backend, 1, latency_requests, r, m->master->lost());
+    r = m->master->run(m->request, throughput_requests, 32);
+    report(m->backend, 32, throughput_requests, r, m->master->lost());
+
+    // Stop the event loop of the main thread
+    m->done = true;
+    QMetaObject::invokeMethod(QCoreApplication::instance(), "quit",
+                              Qt::QueuedConnection);
+    return 0;
+}
+
+static void run(const char* name, MasterProxy::backend_t backend,
+                MasterStandin& master, const std::string& path)
+{
+    MasterProxy proxy("agentXcpp connector benchmark", 5, Oid(), path,
+                      backend);
+    if(proxy.backend() != backend)
+    {
+        printf("backend=%s skipped=unavailable\n", name);
+        return;
+    }
+    if( ! proxy.is_connected() )
+    {
+        printf("backend=%s skipped=connect_failed\n", name);
+        return;
+    }
+
+    // A table with 10 columns of 100 rows below a private subtree
+    Oid subtree("1.3.6.1.4.1.42.99");
+    proxy.register_subtree(subtree);
+    QSharedPointer<AbstractVariable> v(new IntegerVariable(1));
+    for(quint32 column = 1; column <= 10; column++)
+    {
+        for(quint32 row = 1; row <= 100; row++)
+        {
+            Oid id(subtree);
+            id.push_back(column);
+            id.push_back(row);
+            proxy.add_variable(id, v);
+        }
+    }
+
+    // A GetNext request for one row (as sent by a table walk)
+    QSharedPointer<GetNextPDU> request(new GetNextPDU);
+    request->set_sessionID(MasterStandin::sessionID());
+    for(quint32 column = 1; column <= 10; column++)
+    {
+        Oid id(subtree);
+        id.push_back(column);
+        id.push_back(50);
+        request->get_sr().push_back(std::make_pair(id, Oid()));
+    }
+
+    Measurement m;
+    m.backend = name;
+    m.master = &master;
+    m.request = request;
+    m.done = false;
+    pthread_t thread;
+    pthread_create(&thread, 0, measure, &m);
+    if(backend == MasterProxy::embeddedBackend)
+    {
+        // The application's event loop
+        struct pollfd p;
+        p.fd = proxy.fileDescriptor();
+        p.events = POLLIN;
+        while( ! m.done )
+        {
+            // Look at m.done at least every 100ms
+            int timeout = proxy.processTimeout();
+            if(timeout == -1 || timeout > 100)
+            {
+                timeout = 100;
+            }
+            ::poll(&p, 1, timeout);
+            proxy.process();
+        }
+    }
+    else
+    {
+        QCoreApplication::exec();
+    }
+    pthread_join(thread, 0);
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    char path[64];
+    sprintf(path, "/tmp/agentxcpp-bench-%d", int(getpid()));
+    MasterStandin master(path);
+
+    run("qt", MasterProxy::qtBackend, master, path);
+    run("epoll", MasterProxy::epollBackend, master, path);
+    run("embedded", MasterProxy::embeddedBackend, master, path);
+    run("uring", MasterProxy::uringBackend, master, path);
+
+    return 0;
+}
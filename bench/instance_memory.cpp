@@ -0,0 +1,150 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+/*
+ * Benchmark: resident memory per registered instance.
+ *
+ * Compares two ways of serving N read-only Counter32 instances:
+ *
+ *  - map:     one Counter32Variable per instance, stored like
+ *             MasterProxy::add_variable() stores variables (a std::map from
+ *             the instance's Oid to a QSharedPointer<AbstractVariable>)
+ *  - compact: all instances in one CompactVariables store
+ *
+ * Each measurement runs in a child process of its own, so that memory freed
+ * by one measurement cannot be reused by the next one. For N in 10k, 100k
+ * and 1M, one line is printed:
+ *
+ *   instances=<n> map_bytes=<b> compact_bytes=<b>
+ *
+ * where <b> is the growth of the resident set size divided by n.
+ */
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+#include <QSharedPointer>
+
+#include "Oid.hpp"
+#include "Counter32Variable.hpp"
+#include "CompactVariables.hpp"
+
+using namespace agentxcpp;
+
+
+// The subtree containing the instances
+static const Oid subtree("1.3.6.1.4.1.42.1");
+
+
+// Get the resident set size of this process in bytes
+static long resident_bytes()
+{
+    long size = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if(f == 0)
+    {
+        return 0;
+    }
+    if(fscanf(f, "%ld %ld", &size, &resident) != 2)
+    {
+        resident = 0;
+    }
+    fclose(f);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Build the OID of instance i: <subtree>.<i>.0
+static Oid instance(long i)
+{
+    Oid name(subtree, i);
+    name.push_back(0);
+    return name;
+}
+
+static double measure_map(long n)
+{
+    long before = resident_bytes();
+    std::map< Oid, QSharedPointer<AbstractVariable> >* variables;
+    variables = new std::map< Oid, QSharedPointer<AbstractVariable> >;
+    for(long i = 0; i < n; i++)
+    {
+        (*variables)[instance(i)] =
+            QSharedPointer<AbstractVariable>(new Counter32Variable(i));
+    }
+    return double(resident_bytes() - before) / n;
+}
+
+static double measure_compact(long n)
+{
+    long before = resident_bytes();
+    CompactVariables* store = new CompactVariables(subtree);
+    store->reserve(n, 2 * n);
+    for(long i = 0; i < n; i++)
+    {
+        store->add(instance(i), ColumnarTable::Counter32, i);
+    }
+    store->count(); // sorts the store
+    return double(resident_bytes() - before) / n;
+}
+
+// Run a measurement in a child process and return its result
+static double run(double (*measure)(long), long n)
+{
+    int fds[2];
+    if(pipe(fds) != 0)
+    {
+        perror("pipe");
+        exit(1);
+    }
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        double result = measure(n);
+        if(write(fds[1], &result, sizeof(result)) != sizeof(result))
+        {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    double result = 0;
+    if(read(fds[0], &result, sizeof(result)) != sizeof(result))
+    {
+        result = -1;
+    }
+    waitpid(pid, 0, 0);
+    close(fds[0]);
+    close(fds[1]);
+    return result;
+}
+
+int main()
+{
+    static const long counts[] = { 10000, 100000, 1000000 };
+    for(unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        long n = counts[i];
+        printf("instances=%ld map_bytes=%.1f compact_bytes=%.1f\n",
+               n, run(measure_map, n), run(measure_compact, n));
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#include "master_standin.hpp"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <cstring>
+#include <algorithm>
+
+#include "ResponsePDU.hpp"
+#include "util.hpp"
+
+using namespace agentxcpp;
+
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+
+MasterStandin::MasterStandin(const std::string& path)
+: m_path(path),
+  m_fd(-1),
+  m_stop(false),
+  m_first_packetID(0),
+  m_completed(0),
+  m_lost(0)
+{
+    pthread_mutex_init(&m_mutex, 0);
+    pthread_cond_init(&m_cond, 0);
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(path.c_str());
+    m_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+    bind(m_listen, reinterpret_cast<struct sockaddr*>(&address),
+         sizeof(address));
+    listen(m_listen, 1);
+
+    pthread_create(&m_thread, 0, serve, this);
+}
+
+
+MasterStandin::~MasterStandin()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_stop = true;
+    pthread_mutex_unlock(&m_mutex);
+    pthread_join(m_thread, 0);
+
+    if(m_fd != -1) close(m_fd);
+    close(m_listen);
+    unlink(m_path.c_str());
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+
+void* MasterStandin::serve(void* self)
+{
+    static_cast<MasterStandin*>(self)->serve();
+    return 0;
+}
+
+
+void MasterStandin::serve()
+{
+    binary input;
+    while(true)
+    {
+        pthread_mutex_lock(&m_mutex);
+        bool stop = m_stop;
+        pthread_mutex_unlock(&m_mutex);
+        if(stop)
+        {
+            return;
+        }
+
+        // Wait for the subagent, then for its data (with a timeout, so
+        // that m_stop is noticed)
+        struct pollfd p;
+        p.fd = (m_fd == -1) ? m_listen : m_fd;
+        p.events = POLLIN;
+        if(poll(&p, 1, 100) != 1)
+        {
+            continue;
+        }
+        if(m_fd == -1)
+        {
+            int fd = accept(m_listen, 0, 0);
+            pthread_mutex_lock(&m_mutex);
+            m_fd = fd;
+            pthread_mutex_unlock(&m_mutex);
+            continue;
+        }
+
+        quint8 buf[65536];
+        ssize_t n = read(m_fd, buf, sizeof(buf));
+        if(n <= 0)
+        {
+            // Subagent gone: wait for the next one
+            pthread_mutex_lock(&m_mutex);
+            close(m_fd);
+            m_fd = -1;
+            pthread_mutex_unlock(&m_mutex);
+            input.clear();
+            continue;
+        }
+        input.append(buf, n);
+
+        // Handle the complete PDU's
+        size_t start = 0;
+        while(input.size() - start >= 20)
+        {
+            bool big_endian = ( input[start + 2] & (1<<4) ) ? true : false;
+            binary::const_iterator pos = input.begin() + start + 16;
+            quint32 length = 20 + read32(pos, big_endian);
+            if(input.size() - start < length)
+            {
+                break;
+            }
+            binary pdu;
+            pdu.assign(input, start, length);
+            handle(pdu);
+            start += length;
+        }
+        input.erase(0, start);
+    }
+}
+
+
+void MasterStandin::write_all(const binary& data)
+{
+    // (called with m_mutex locked)
+    size_t done = 0;
+    while(m_fd != -1 && done < data.size())
+    {
+        ssize_t n = write(m_fd, data.data() + done, data.size() - done);
+        if(n <= 0 && errno != EINTR)
+        {
+            return;
+        }
+        if(n > 0)
+        {
+            done += n;
+        }
+    }
+}
+
+
+void MasterStandin::handle(const binary& data)
+{
+    double arrival = now();
+    QSharedPointer<PDU> pdu;
+    try
+    {
+        pdu = PDU::parse_pdu(data);
+    }
+    catch(...)
+    {
+        // The stand-in doesn't parse all PDU types (e.g. agentx-Ping-PDU):
+        // answer them by header only
+    }
+
+    quint8 type = data[1];
+    if(type == PDU::agentxResponsePDU)
+    {
+        // The answer to a request sent by run()
+        pthread_mutex_lock(&m_mutex);
+        quint32 index = pdu->get_packetID() - m_first_packetID;
+        if(index < m_latency.size() && m_latency[index] < 0)
+        {
+            m_latency[index] = arrival - m_sent[index];
+            m_completed++;
+            pthread_cond_signal(&m_cond);
+        }
+        pthread_mutex_unlock(&m_mutex);
+        return;
+    }
+
+    // A request of the subagent: answer successfully
+    ResponsePDU response;
+    binary::const_iterator pos = data.begin() + 4;
+    bool big_endian = ( data[2] & (1<<4) ) ? true : false;
+    read32(pos, big_endian);                        // sessionID
+    response.set_transactionID(read32(pos, big_endian));
+    response.set_packetID(read32(pos, big_endian));
+    response.set_sessionID(sessionID());
+    response.set_error(ResponsePDU::noAgentXError);
+    response.set_index(0);
+    pthread_mutex_lock(&m_mutex);
+    write_all(response.serialize());
+    pthread_mutex_unlock(&m_mutex);
+}
+
+
+MasterStandin::Result MasterStandin::run(QSharedPointer<PDU> request,
+                                         long count, int window)
+{
+    // The request is serialized once; only the packetID is changed
+    binary data = request->serialize();
+
+    pthread_mutex_lock(&m_mutex);
+    m_first_packetID += 0x10000000;
+    m_completed = 0;
+    m_sent.assign(count, 0);
+    m_latency.assign(count, -1);
+
+    double start = now();
+    for(long i = 0; i < count; i++)
+    {
+        // Wait for a free slot in the window
+        while(i - m_completed >= window)
+        {
+            struct timespec t;
+            clock_gettime(CLOCK_REALTIME, &t);
+            t.tv_sec += 5;
+            if(pthread_cond_timedwait(&m_cond, &m_mutex, &t) == ETIMEDOUT)
+            {
+                // Give up on the outstanding requests
+                m_completed = i;
+            }
+        }
+
+        quint32 packetID = m_first_packetID + i;
+        data[12] = packetID >> 24;
+        data[13] = packetID >> 16;
+        data[14] = packetID >> 8;
+        data[15] = packetID;
+        m_sent[i] = now();
+        write_all(data);
+    }
+    while(m_completed < count)
+    {
+        struct timespec t;
+        clock_gettime(CLOCK_REALTIME, &t);
+        t.tv_sec += 5;
+        if(pthread_cond_timedwait(&m_cond, &m_mutex, &t) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    double time = now() - start;
+
+    // Evaluate the answered requests
+    std::vector<double> latency;
+    for(long i = 0; i < count; i++)
+    {
+        if(m_latency[i] >= 0)
+        {
+            latency.push_back(m_latency[i] * 1e6);
+        }
+    }
+    m_lost = count - latency.size();
+    m_latency.clear();
+    pthread_mutex_unlock(&m_mutex);
+
+    Result result;
+    memset(&result, 0, sizeof(result));
+    if( ! latency.empty() )
+    {
+        std::sort(latency.begin(), latency.end());
+        double sum = 0;
+        for(size_t i = 0; i < latency.size(); i++)
+        {
+            sum += latency[i];
+        }
+        result.mean_us = sum / latency.size();
+        result.p50_us = latency[latency.size() / 2];
+        result.p99_us = latency[latency.size() * 99 / 100];
+        result.requests_per_s = latency.size() / time;
+    }
+    return result;
+}
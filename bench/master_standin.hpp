@@ -0,0 +1,119 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+/*
+ * A minimal AgentX master agent for the benchmarks.
+ *
+ * The stand-in listens on a unix domain socket and accepts one subagent.
+ * It answers the PDU's sent by the subagent (Open, Register, Ping, ...)
+ * with a successful agentx-Response-PDU, assigning sessionID 1. run() then
+ * sends requests to the subagent and measures the time until their
+ * responses arrive.
+ *
+ * The stand-in uses plain sockets and threads, so that it doesn't depend
+ * on the connector being measured.
+ */
+
+#ifndef _MASTER_STANDIN_HPP_
+#define _MASTER_STANDIN_HPP_
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#include <QSharedPointer>
+
+#include "PDU.hpp"
+
+
+class MasterStandin
+{
+    public:
+        /**
+         * \brief The result of run().
+         */
+        struct Result
+        {
+            double mean_us;         // Mean round trip time
+            double p50_us;          // Median round trip time
+            double p99_us;          // 99th percentile of the round trip time
+            double requests_per_s;  // Completed requests per second
+        };
+
+        /**
+         * \brief Listen on the given socket and start serving.
+         *
+         * An existing socket file is removed first.
+         */
+        MasterStandin(const std::string& path);
+
+        /**
+         * \brief Stop serving and remove the socket file.
+         */
+        ~MasterStandin();
+
+        /**
+         * \brief The sessionID assigned to the subagent.
+         */
+        static quint32 sessionID() { return 1; }
+
+        /**
+         * \brief Send requests and measure their round trip time.
+         *
+         * The request is sent count times, with consecutive packetID's.
+         * At most window requests are outstanding at any time; a window of
+         * 1 measures the latency, larger windows the throughput.
+         *
+         * Returns when all responses arrived. Requests for which no
+         * response arrives within 5 seconds are counted as lost, and the
+         * result is computed from the others.
+         */
+        Result run(QSharedPointer<agentxcpp::PDU> request,
+                   long count, int window);
+
+        /**
+         * \brief The number of responses lost by the last run().
+         */
+        long lost() const { return m_lost; }
+
+    private:
+        static void* serve(void* self);
+        void serve();
+        void write_all(const agentxcpp::binary& data);
+        void handle(const agentxcpp::binary& data);
+
+        std::string m_path;
+        int m_listen;
+        int m_fd;
+        bool m_stop;
+        pthread_t m_thread;
+
+        // Protects the members below and writing to m_fd
+        pthread_mutex_t m_mutex;
+        pthread_cond_t m_cond;
+
+        // Measurement of run()
+        quint32 m_first_packetID;
+        long m_completed;
+        long m_lost;
+        std::vector<double> m_sent;       // Send time per request
+        std::vector<double> m_latency;    // Round trip time, or -1
+};
+
+#endif /* _MASTER_STANDIN_HPP_ */
@@ -0,0 +1,584 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+/*
+ * Benchmark suite: the hot paths of the library.
+ *
+ * Each case performs an operation repeatedly and measures the time and the
+ * heap allocations (counted by wrapping malloc() and friends) per
+ * operation. The cases are:
+ *
+ *  - serialize/<PDU>: PDU::serialize() for every PDU type. PDU's carrying
+ *                     varbinds or SearchRanges get 10 of them (5 for the
+ *                     agentx-Notify-PDU, 1 for the index PDU's), like the
+ *                     requests of a walk over a table.
+ *  - parse/<PDU>:     PDU::parse_pdu() of the same PDU's, except for those
+ *                     which are only sent by subagents and therefore not
+ *                     parsed by the library (agentx-Ping-PDU, the index
+ *                     PDU's and the AgentCaps PDU's)
+ *  - oid/...:         construction of an Oid from a string, parsing and
+ *                     serializing an OidVariable, comparison and
+ *                     Oid::contains()
+ *  - lookup/...:      lookup in a variables map as used by the MasterProxy
+ *                     (exact match for Get, upper_bound() for GetNext) with
+ *                     1000, 100000 and 1000000 variables
+ *  - dispatch/...:    a GetNext request parsed and passed to
+ *                     MasterProxy::handle_pdu(). This needs a running
+ *                     master agent to register with; without one the cases
+ *                     are reported as skipped. The responses are serialized
+ *                     and sent by the connector's thread; its allocations
+ *                     are counted as well.
+ *
+ * One line is printed per case:
+ *
+ *   case=<name> iterations=<n> ns_per_op=<t> allocs_per_op=<a> bytes_per_op=<b>
+ *
+ * or "case=<name> skipped=<reason>". The format is meant to be compared by
+ * scripts between releases; new keys are only appended. If an argument is
+ * given, only the cases whose names contain it are run.
+ */
+
+#include <sys/time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <QSharedPointer>
+
+#include "MasterProxy.hpp"
+#include "OpenPDU.hpp"
+#include "ClosePDU.hpp"
+#include "RegisterPDU.hpp"
+#include "UnregisterPDU.hpp"
+#include "GetPDU.hpp"
+#include "GetNextPDU.hpp"
+#include "GetBulkPDU.hpp"
+#include "TestSetPDU.hpp"
+#include "CommitSetPDU.hpp"
+#include "UndoSetPDU.hpp"
+#include "CleanupSetPDU.hpp"
+#include "NotifyPDU.hpp"
+#include "PingPDU.hpp"
+#include "IndexAllocatePDU.hpp"
+#include "IndexDeallocatePDU.hpp"
+#include "AddAgentCapsPDU.hpp"
+#include "RemoveAgentCapsPDU.hpp"
+#include "ResponsePDU.hpp"
+#include "IntegerVariable.hpp"
+#include "Counter64Variable.hpp"
+#include "OctetStringVariable.hpp"
+#include "OidVariable.hpp"
+
+using namespace agentxcpp;
+
+
+// Allocation counters (updated atomically, because the MasterProxy and its
+// connector run in different threads)
+static unsigned long allocations = 0;
+static unsigned long allocated_bytes = 0;
+
+// Wrap the allocation functions of glibc
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t n, size_t size);
+    void* __libc_realloc(void* p, size_t size);
+
+    void* malloc(size_t size)
+    {
+        __sync_fetch_and_add(&allocations, 1);
+        __sync_fetch_and_add(&allocated_bytes, size);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t n, size_t size)
+    {
+        __sync_fetch_and_add(&allocations, 1);
+        __sync_fetch_and_add(&allocated_bytes, n * size);
+        return __libc_calloc(n, size);
+    }
+
+    void* realloc(void* p, size_t size)
+    {
+        __sync_fetch_and_add(&allocations, 1);
+        __sync_fetch_and_add(&allocated_bytes, size);
+        return __libc_realloc(p, size);
+    }
+}
+
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+// The case filter (see above), or 0
+static const char* filter = 0;
+
+// Collects the results of the cases, so that the loops cannot be optimized
+// away
+static unsigned long sum = 0;
+
+// A case: performs the operation 'iterations' times and returns a value
+// depending on the results
+typedef unsigned long (*case_t)(long iterations);
+
+// Whether a case is selected by the filter
+static bool selected(const std::string& name)
+{
+    return filter == 0 || name.find(filter) != std::string::npos;
+}
+
+// Run a case and print its results
+static void run(const std::string& name, case_t fn, long iterations)
+{
+    if( ! selected(name) )
+    {
+        return;
+    }
+
+    // Warm up (e.g. the caches and the allocator)
+    sum += fn(iterations / 100 + 1);
+
+    unsigned long allocs = allocations;
+    unsigned long bytes = allocated_bytes;
+    double start = now();
+    sum += fn(iterations);
+    double time = now() - start;
+    allocs = allocations - allocs;
+    bytes = allocated_bytes - bytes;
+
+    printf("case=%s iterations=%ld ns_per_op=%.1f allocs_per_op=%.2f "
+           "bytes_per_op=%.1f\n",
+           name.c_str(), iterations, time * 1e9 / iterations,
+           double(allocs) / iterations, double(bytes) / iterations);
+}
+
+static void skip(const std::string& name, const char* reason)
+{
+    if(selected(name))
+    {
+        printf("case=%s skipped=%s\n", name.c_str(), reason);
+    }
+}
+
+
+//
+// PDU's
+//
+
+// The PDU of the current serialize case, and its serialized form for the
+// parse case
+static QSharedPointer<PDU> pdu;
+static binary serialized;
+
+static unsigned long serialize_pdu(long iterations)
+{
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        s += pdu->serialize().size();
+    }
+    return s;
+}
+
+static unsigned long parse_pdu(long iterations)
+{
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        s += PDU::parse_pdu(serialized)->get_packetID();
+    }
+    return s;
+}
+
+// The header of a PDU without payload, as sent by the master agent
+static binary header(PDU::type_t type)
+{
+    const quint8 h[20] = { 1, quint8(type), 0x10, 0,
+                           0, 0, 0, 1,      // sessionID
+                           0, 0, 0, 2,      // transactionID
+                           0, 0, 0, 3,      // packetID
+                           0, 0, 0, 0 };    // payload length
+    binary data;
+    data.append(h, sizeof(h));
+    return data;
+}
+
+// The name of the n'th instance of a table column (ifHCInOctets)
+static Oid instance(quint32 n)
+{
+    Oid name("1.3.6.1.2.1.31.1.1.1.6");
+    name.push_back(n);
+    return name;
+}
+
+static void run_pdu(const char* name, QSharedPointer<PDU> p,
+                    bool parsed = true)
+{
+    pdu = p;
+    pdu->set_packetID(3);
+    serialized = pdu->serialize();
+    run(std::string("serialize/") + name, serialize_pdu, 100000);
+    if(parsed)
+    {
+        run(std::string("parse/") + name, parse_pdu, 100000);
+    }
+}
+
+static void run_parsed_pdu(const char* name, PDU::type_t type)
+{
+    run_pdu(name, PDU::parse_pdu(header(type)));
+}
+
+static void pdu_cases()
+{
+    QSharedPointer<AbstractVariable> counter(
+            new Counter64Variable(quint64(1000000007)));
+    QSharedPointer<AbstractVariable> integer(new IntegerVariable(42));
+    QSharedPointer<AbstractVariable> string(
+            new OctetStringVariable("eth0"));
+
+    QSharedPointer<OpenPDU> open(new OpenPDU);
+    open->set_timeout(5);
+    open->set_id(Oid("1.3.6.1.4.1.42"));
+    open->set_descr(OctetStringVariable("microbench subagent"));
+    run_pdu("open", open);
+
+    run_pdu("close",
+            QSharedPointer<PDU>(new ClosePDU(1, ClosePDU::reasonShutdown)));
+
+    QSharedPointer<RegisterPDU> reg(new RegisterPDU);
+    reg->set_subtree(Oid("1.3.6.1.2.1.31.1.1.1"));
+    reg->set_priority(127);
+    reg->set_timeout(5);
+    run_pdu("register", reg);
+
+    QSharedPointer<UnregisterPDU> unreg(new UnregisterPDU);
+    unreg->set_subtree(Oid("1.3.6.1.2.1.31.1.1.1"));
+    unreg->set_priority(127);
+    run_pdu("unregister", unreg);
+
+    QSharedPointer<GetPDU> get(new GetPDU);
+    for(quint32 i = 1; i <= 10; i++)
+    {
+        get->get_sr().push_back(instance(i));
+    }
+    run_pdu("get", get);
+
+    QSharedPointer<GetNextPDU> getnext(new GetNextPDU);
+    for(quint32 i = 1; i <= 10; i++)
+    {
+        getnext->get_sr().push_back(std::make_pair(instance(i), Oid()));
+    }
+    run_pdu("getnext", getnext);
+
+    QSharedPointer<GetBulkPDU> getbulk(new GetBulkPDU);
+    getbulk->set_non_repeaters(0);
+    getbulk->set_max_repititions(10);
+    for(quint32 i = 1; i <= 10; i++)
+    {
+        getbulk->get_sr().push_back(std::make_pair(instance(i), Oid()));
+    }
+    run_pdu("getbulk", getbulk);
+
+    QSharedPointer<TestSetPDU> testset(new TestSetPDU);
+    for(quint32 i = 1; i <= 10; i++)
+    {
+        testset->get_vb().push_back(Varbind(instance(i), integer));
+    }
+    run_pdu("testset", testset);
+
+    run_parsed_pdu("commitset", PDU::agentxCommitSetPDU);
+    run_parsed_pdu("undoset", PDU::agentxUndoSetPDU);
+    run_parsed_pdu("cleanupset", PDU::agentxCleanupSetPDU);
+
+    QSharedPointer<NotifyPDU> notify(new NotifyPDU);
+    notify->get_vb().push_back(Varbind(Oid("1.3.6.1.2.1.1.3.0"), integer));
+    notify->get_vb().push_back(Varbind(Oid("1.3.6.1.6.3.1.1.4.1.0"),
+            QSharedPointer<AbstractVariable>(
+                new OidVariable(Oid("1.3.6.1.6.3.1.1.5.4")))));
+    for(quint32 i = 1; i <= 3; i++)
+    {
+        notify->get_vb().push_back(Varbind(instance(i), string));
+    }
+    run_pdu("notify", notify);
+
+    run_pdu("ping", QSharedPointer<PDU>(new PingPDU), false);
+
+    QSharedPointer<IndexAllocatePDU> allocate(new IndexAllocatePDU);
+    allocate->get_vb().push_back(Varbind(Oid("1.3.6.1.2.1.2.2.1.1"),
+                                         integer));
+    run_pdu("indexallocate", allocate, false);
+
+    QSharedPointer<IndexDeallocatePDU> deallocate(new IndexDeallocatePDU);
+    deallocate->get_vb().push_back(Varbind(Oid("1.3.6.1.2.1.2.2.1.1"),
+                                           integer));
+    run_pdu("indexdeallocate", deallocate, false);
+
+    run_pdu("addagentcaps",
+            QSharedPointer<PDU>(new AddAgentCapsPDU(
+                    Oid("1.3.6.1.4.1.42.1"),
+                    OctetStringVariable("microbench capabilities"))),
+            false);
+    run_pdu("removeagentcaps",
+            QSharedPointer<PDU>(new RemoveAgentCapsPDU(
+                    Oid("1.3.6.1.4.1.42.1"))),
+            false);
+
+    QSharedPointer<ResponsePDU> response(new ResponsePDU);
+    for(quint32 i = 1; i <= 10; i++)
+    {
+        response->varbindlist.push_back(Varbind(instance(i), counter));
+    }
+    run_pdu("response", response);
+
+    pdu.clear();
+}
+
+
+//
+// Oid's
+//
+
+static const std::string oid_string("1.3.6.1.2.1.31.1.1.1.6.1001");
+static Oid oid_a(oid_string);
+static Oid oid_b("1.3.6.1.2.1.31.1.1.1.6.1002");
+static Oid oid_prefix("1.3.6.1.2.1.31.1.1.1");
+
+static unsigned long oid_from_string(long iterations)
+{
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        s += Oid(oid_string).size();
+    }
+    return s;
+}
+
+static unsigned long oid_parse(long iterations)
+{
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        binary::const_iterator pos = serialized.begin();
+        s += OidVariable(pos, serialized.end(), true).value().size();
+    }
+    return s;
+}
+
+static unsigned long oid_serialize(long iterations)
+{
+    OidVariable v(oid_a);
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        s += v.serialize().size();
+    }
+    return s;
+}
+
+static unsigned long oid_compare(long iterations)
+{
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        s += (oid_a < oid_b) + (oid_a == oid_b);
+    }
+    return s;
+}
+
+static unsigned long oid_contains(long iterations)
+{
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        s += oid_prefix.contains(oid_a);
+    }
+    return s;
+}
+
+static void oid_cases()
+{
+    serialized = OidVariable(oid_a).serialize();
+    run("oid/from_string", oid_from_string, 1000000);
+    run("oid/parse", oid_parse, 1000000);
+    run("oid/serialize", oid_serialize, 1000000);
+    run("oid/compare", oid_compare, 10000000);
+    run("oid/contains", oid_contains, 10000000);
+}
+
+
+//
+// Variables map
+//
+
+// The variables map of the current case (like MasterProxy's)
+typedef std::map< Oid, QSharedPointer<AbstractVariable> > variables_t;
+static variables_t variables;
+
+// The OID's looked up, in random order
+static std::vector<Oid> keys;
+
+static unsigned long lookup_exact(long iterations)
+{
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        s += variables.find(keys[i % keys.size()]) != variables.end();
+    }
+    return s;
+}
+
+static unsigned long lookup_next(long iterations)
+{
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        s += variables.upper_bound(keys[i % keys.size()])
+             != variables.end();
+    }
+    return s;
+}
+
+static void lookup_cases(quint32 size)
+{
+    char name[64];
+    sprintf(name, "lookup/%u/", size);
+    if( ! selected(name) )
+    {
+        // Don't build the map
+        return;
+    }
+
+    // A table with 10 columns; all variables share one object to keep
+    // the memory footprint down
+    QSharedPointer<AbstractVariable> v(new IntegerVariable(1));
+    for(quint32 i = 0; i < size; i++)
+    {
+        Oid id("1.3.6.1.4.1.42.1.1");
+        id.push_back(i % 10 + 1);
+        id.push_back(i / 10 + 1);
+        variables[id] = v;
+    }
+    srand(1);
+    for(int i = 0; i < 4096; i++)
+    {
+        quint32 n = quint32(rand()) % size;
+        Oid id("1.3.6.1.4.1.42.1.1");
+        id.push_back(n % 10 + 1);
+        id.push_back(n / 10 + 1);
+        keys.push_back(id);
+    }
+
+    run(std::string(name) + "exact", lookup_exact, 1000000);
+    run(std::string(name) + "next", lookup_next, 1000000);
+
+    variables.clear();
+    keys.clear();
+}
+
+
+//
+// Dispatch
+//
+
+static MasterProxy* master = 0;
+
+static unsigned long dispatch(long iterations)
+{
+    unsigned long s = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        QSharedPointer<PDU> request = PDU::parse_pdu(serialized);
+        master->handle_pdu(request);
+        s += request->get_packetID();
+    }
+    return s;
+}
+
+static void dispatch_cases()
+{
+    if( ! selected("dispatch/") )
+    {
+        return;
+    }
+
+    MasterProxy proxy("agentXcpp microbenchmark");
+    if( ! proxy.is_connected() )
+    {
+        skip("dispatch/getnext", "no_master_agent");
+        return;
+    }
+    master = &proxy;
+
+    // A table with 10 columns of 100 rows below a private subtree
+    Oid subtree("1.3.6.1.4.1.42.99");
+    proxy.register_subtree(subtree);
+    QSharedPointer<AbstractVariable> v(new IntegerVariable(1));
+    for(quint32 column = 1; column <= 10; column++)
+    {
+        for(quint32 row = 1; row <= 100; row++)
+        {
+            Oid id(subtree);
+            id.push_back(column);
+            id.push_back(row);
+            proxy.add_variable(id, v);
+        }
+    }
+
+    // A GetNext request for one row (as sent by a table walk)
+    GetNextPDU request;
+    request.set_sessionID(proxy.get_sessionID());
+    for(quint32 column = 1; column <= 10; column++)
+    {
+        Oid id(subtree);
+        id.push_back(column);
+        id.push_back(50);
+        request.get_sr().push_back(std::make_pair(id, Oid()));
+    }
+    serialized = request.serialize();
+
+    run("dispatch/getnext", dispatch, 100000);
+
+    master = 0;
+}
+
+
+int main(int argc, char** argv)
+{
+    if(argc > 1)
+    {
+        filter = argv[1];
+    }
+
+    pdu_cases();
+    oid_cases();
+    lookup_cases(1000);
+    lookup_cases(100000);
+    lookup_cases(1000000);
+    dispatch_cases();
+
+    return sum == 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+/*
+ * Benchmark: heap allocations while a response PDU is serialized.
+ *
+ * A ResponsePDU with 10 Counter32 varbinds (like the answer to a Get
+ * request for 10 ifInOctets instances) is serialized repeatedly in two
+ * ways:
+ *
+ *  - binary:    ResponsePDU::serialize(), which builds the PDU from
+ *               temporary binary objects (the former way of sending PDU's)
+ *  - segmented: ResponsePDU::serialize_to() into a reused SegmentedBuffer,
+ *               as done by UnixDomainConnector::do_send()
+ *
+ * The heap allocations are counted by wrapping malloc() and friends. One
+ * line is printed per way:
+ *
+ *   path=<name> allocs_per_request=<n> bytes_per_request=<b>
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <QSharedPointer>
+
+#include "ResponsePDU.hpp"
+#include "Counter32Variable.hpp"
+#include "SegmentedBuffer.hpp"
+
+using namespace agentxcpp;
+
+
+// Number of serialized PDU's per way
+static const long iterations = 100000;
+
+// Allocation counters
+static unsigned long allocations = 0;
+static unsigned long allocated_bytes = 0;
+
+// Wrap the allocation functions of glibc
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t n, size_t size);
+    void* __libc_realloc(void* p, size_t size);
+
+    void* malloc(size_t size)
+    {
+        allocations++;
+        allocated_bytes += size;
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t n, size_t size)
+    {
+        allocations++;
+        allocated_bytes += n * size;
+        return __libc_calloc(n, size);
+    }
+
+    void* realloc(void* p, size_t size)
+    {
+        allocations++;
+        allocated_bytes += size;
+        return __libc_realloc(p, size);
+    }
+}
+
+static void report(const char* path, unsigned long allocs,
+                   unsigned long bytes)
+{
+    printf("path=%s allocs_per_request=%.2f bytes_per_request=%.1f\n",
+           path, double(allocs) / iterations, double(bytes) / iterations);
+}
+
+int main()
+{
+    // Build the response
+    ResponsePDU response;
+    for(quint32 i = 1; i <= 10; i++)
+    {
+        Oid name("1.3.6.1.2.1.2.2.1.10");
+        name.push_back(i);
+        response.varbindlist.push_back(Varbind(name,
+                QSharedPointer<AbstractVariable>(
+                    new Counter32Variable(1000 * i))));
+    }
+
+    // The former way
+    unsigned long allocs = allocations;
+    unsigned long bytes = allocated_bytes;
+    unsigned long sum = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        binary data = response.serialize();
+        sum += data.size();
+    }
+    report("binary", allocations - allocs, allocated_bytes - bytes);
+
+    // The segmented buffer (the first PDU warms up the buffer, as happens
+    // for the first PDU sent by a connector)
+    SegmentedBuffer buffer;
+    response.serialize_to(buffer);
+    buffer.clear();
+    allocs = allocations;
+    bytes = allocated_bytes;
+    for(long i = 0; i < iterations; i++)
+    {
+        response.serialize_to(buffer);
+        sum += buffer.size();
+        buffer.clear();
+    }
+    report("segmented", allocations - allocs, allocated_bytes - bytes);
+
+    // Use the sum, so that the loops cannot be optimized away
+    return sum == 0;
+}
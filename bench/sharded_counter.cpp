@@ -0,0 +1,140 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+/*
+ * Benchmark: update throughput of counters incremented concurrently by
+ * several threads.
+ *
+ * Compares a single atomic counter (all threads increment the same memory
+ * location) with a ShardedCounter (each thread increments its own shard).
+ * For each thread count from 1 to the number of online CPUs, one line is
+ * printed:
+ *
+ *   threads=<n> atomic_mops=<rate> sharded_mops=<rate>
+ *
+ * The rates are the total number of increments of all threads in millions
+ * per second. With a sharded counter, the rate should grow with the number
+ * of threads; with the atomic counter, it usually drops.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <cstdio>
+#include <cstdlib>
+
+#include "ShardedCounter.hpp"
+
+using namespace agentxcpp;
+
+
+// Increments per thread
+static const long iterations = 20000000;
+
+// The counters under test
+static quint64 atomic_counter = 0;
+static ShardedCounter* sharded_counter = 0;
+
+// Start barrier, so that all threads start at the same time
+static pthread_barrier_t barrier;
+
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void* run_atomic(void*)
+{
+    pthread_barrier_wait(&barrier);
+    for(long i = 0; i < iterations; i++)
+    {
+        __atomic_fetch_add(&atomic_counter, 1, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+static void* run_sharded(void*)
+{
+    pthread_barrier_wait(&barrier);
+    for(long i = 0; i < iterations; i++)
+    {
+        sharded_counter->add(1);
+    }
+    return 0;
+}
+
+/*
+ * Run 'function' in 'threads' threads and return the rate in millions of
+ * increments per second.
+ */
+static double measure(void* (*function)(void*), int threads)
+{
+    pthread_t* tids = new pthread_t[threads];
+    pthread_barrier_init(&barrier, 0, threads + 1);
+    for(int i = 0; i < threads; i++)
+    {
+        pthread_create(&tids[i], 0, function, 0);
+    }
+    double start = now();
+    pthread_barrier_wait(&barrier);
+    for(int i = 0; i < threads; i++)
+    {
+        pthread_join(tids[i], 0);
+    }
+    double elapsed = now() - start;
+    pthread_barrier_destroy(&barrier);
+    delete[] tids;
+
+    return threads * iterations / elapsed / 1e6;
+}
+
+int main()
+{
+    int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cpus < 1)
+    {
+        cpus = 1;
+    }
+
+    for(int threads = 1; threads <= cpus; threads++)
+    {
+        atomic_counter = 0;
+        double atomic_rate = measure(run_atomic, threads);
+
+        sharded_counter = new ShardedCounter;
+        double sharded_rate = measure(run_sharded, threads);
+
+        // Verify that no increment was lost
+        if(   atomic_counter != quint64(threads) * iterations
+           || sharded_counter->sum() != quint64(threads) * iterations )
+        {
+            fprintf(stderr, "counter mismatch\n");
+            return EXIT_FAILURE;
+        }
+        delete sharded_counter;
+
+        printf("threads=%d atomic_mops=%.1f sharded_mops=%.1f\n",
+               threads, atomic_rate, sharded_rate);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -22,6 +22,7 @@
 #include <QSharedPointer>
 
 #include "binary.hpp"
+#include "SegmentedBuffer.hpp"
 #include "Oid.hpp"
 
 namespace agentxcpp
@@ -243,6 +244,34 @@ namespace agentxcpp
              */
             virtual binary serialize() const = 0;
 
+            /**
+             * \internal
+             *
+             * \brief Serialize the variable into a segmented buffer.
+             *
+             * The default implementation appends the result of serialize().
+             * Variables holding large values may override this function to
+             * append their value without copying it.
+             *
+             * The buffer may use the host's byte order instead of big endian 
+             * (see MasterProxy::setNativeByteOrder()). The default 
+             * implementation is only correct for big endian buffers, because 
+             * serialize() always produces big endian. All variable types of 
+             * the library override this function and encode their numbers 
+             * with the buffer's write*() methods, and classes derived from 
+             * them inherit this. A class which overrides serialize() to 
+             * change the encoding must override serialize_to() as well.
+             *
+             * \param out The buffer to which the serialized form is
+             *            appended.
+             *
+             * \exception The function shall not throw.
+             */
+            virtual void serialize_to(SegmentedBuffer& out) const
+            {
+                out.append(serialize());
+            }
+
             /**
              * \brief Convert an INDEX variable to an Oid part.
              *
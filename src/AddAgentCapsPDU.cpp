@@ -39,7 +39,7 @@ AddAgentCapsPDU::AddAgentCapsPDU(binary::const_iterator& pos,
 
 
 
-binary AddAgentCapsPDU::serialize()
+binary AddAgentCapsPDU::serialize() const
 {
     binary serialized;
 
@@ -142,7 +142,7 @@ namespace agentxcpp
 	    /**
 	     * \brief Serialize the %PDU
 	     */
-	    virtual binary serialize();
+	    virtual binary serialize() const;
     };
 }
 
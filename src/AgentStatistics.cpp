@@ -0,0 +1,257 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#include <time.h>
+
+#include <QMutexLocker>
+
+#include "AgentStatistics.hpp"
+
+using namespace agentxcpp;
+using namespace std;
+
+
+LatencyHistogram::LatencyHistogram()
+: n(0),
+  total(0)
+{
+    for(int i = 0; i < bucket_count; i++)
+    {
+        buckets[i] = 0;
+    }
+}
+
+
+void LatencyHistogram::record(quint64 microseconds)
+{
+    // The bucket is the number of significant bits of the latency
+    int i = 0;
+    if(microseconds != 0)
+    {
+        i = 64 - __builtin_clzll(microseconds);
+        if(i >= bucket_count)
+        {
+            i = bucket_count - 1;
+        }
+    }
+
+    __atomic_fetch_add(&n, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&total, microseconds, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&buckets[i], 1, __ATOMIC_RELAXED);
+}
+
+
+AgentStatistics::AgentStatistics()
+: n_pdus_sent(0),
+  n_pdus_received(0),
+  n_bytes_sent(0),
+  n_bytes_received(0),
+  n_parse_errors(0),
+  n_connects(0),
+  n_send_queue(0),
+  n_receive_queue(0),
+  n_deadline_cutoffs(0),
+  time_to_service(0),
+  slow_threshold(100000)
+{
+    for(int i = 0; i < type_count; i++)
+    {
+        pdus[i].handled = 0;
+        pdus[i].errors = 0;
+    }
+}
+
+
+quint64 AgentStatistics::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+quint64 AgentStatistics::pdusHandled(PDU::type_t type) const
+{
+    if(type <= 0 || type >= type_count)
+    {
+        return 0;
+    }
+    return __atomic_load_n(&pdus[type].handled, __ATOMIC_RELAXED);
+}
+
+
+quint64 AgentStatistics::pduErrors(PDU::type_t type) const
+{
+    if(type <= 0 || type >= type_count)
+    {
+        return 0;
+    }
+    return __atomic_load_n(&pdus[type].errors, __ATOMIC_RELAXED);
+}
+
+
+const LatencyHistogram& AgentStatistics::pduLatency(PDU::type_t type) const
+{
+    if(type <= 0 || type >= type_count)
+    {
+        // Type 0 is unused and stays empty
+        return pdus[0].latency;
+    }
+    return pdus[type].latency;
+}
+
+
+void AgentStatistics::record_pdu(PDU::type_t type, quint64 microseconds,
+                                 bool error)
+{
+    if(type <= 0 || type >= type_count)
+    {
+        return;
+    }
+    __atomic_fetch_add(&pdus[type].handled, 1, __ATOMIC_RELAXED);
+    if(error)
+    {
+        __atomic_fetch_add(&pdus[type].errors, 1, __ATOMIC_RELAXED);
+    }
+    pdus[type].latency.record(microseconds);
+}
+
+
+void AgentStatistics::record_callback(const Oid& name, quint64 microseconds,
+                                      bool failed)
+{
+    quint64 threshold = slowCallbackThreshold();
+    if(threshold != 0 && microseconds >= threshold)
+    {
+        record_slow_callback(name, microseconds);
+    }
+
+    // The subtree containing name precedes name. Search backwards from the
+    // last subtree which is not greater than name; usually the first
+    // candidate is the right one.
+    map< Oid, QSharedPointer<SubtreeStatistics> >::const_iterator i;
+    i = subtree_stats.upper_bound(name);
+    while(i != subtree_stats.begin())
+    {
+        i--;
+        if(i->first.contains(name))
+        {
+            i->second->record(microseconds, failed);
+            return;
+        }
+    }
+}
+
+
+QList<Oid> AgentStatistics::subtrees() const
+{
+    QList<Oid> result;
+    map< Oid, QSharedPointer<SubtreeStatistics> >::const_iterator i;
+    for(i = subtree_stats.begin(); i != subtree_stats.end(); i++)
+    {
+        result.append(i->first);
+    }
+    return result;
+}
+
+
+QSharedPointer<SubtreeStatistics> AgentStatistics::subtree(
+        const Oid& oid) const
+{
+    map< Oid, QSharedPointer<SubtreeStatistics> >::const_iterator i;
+    i = subtree_stats.find(oid);
+    if(i == subtree_stats.end())
+    {
+        return QSharedPointer<SubtreeStatistics>();
+    }
+    return i->second;
+}
+
+
+void AgentStatistics::add_subtree(const Oid& oid)
+{
+    if(subtree_stats.find(oid) == subtree_stats.end())
+    {
+        subtree_stats[oid] =
+            QSharedPointer<SubtreeStatistics>(new SubtreeStatistics);
+    }
+}
+
+
+void AgentStatistics::remove_subtree(const Oid& oid)
+{
+    subtree_stats.erase(oid);
+}
+
+
+void AgentStatistics::record_slow_callback(const Oid& name,
+                                           quint64 microseconds)
+{
+    QMutexLocker locker(&slow_mutex);
+
+    map<Oid, SlowCallback>::iterator i = slow_log.find(name);
+    if(i == slow_log.end())
+    {
+        if(slow_log.size() >= static_cast<size_t>(slow_log_size))
+        {
+            // Log is full: replace the fastest entry, if it is faster than
+            // this callback
+            map<Oid, SlowCallback>::iterator fastest = slow_log.begin();
+            for(i = slow_log.begin(); i != slow_log.end(); i++)
+            {
+                if(i->second.maxLatency < fastest->second.maxLatency)
+                {
+                    fastest = i;
+                }
+            }
+            if(fastest->second.maxLatency >= microseconds)
+            {
+                return;
+            }
+            slow_log.erase(fastest);
+        }
+        SlowCallback entry;
+        entry.name = name;
+        entry.count = 0;
+        entry.maxLatency = 0;
+        entry.lastLatency = 0;
+        i = slow_log.insert(make_pair(name, entry)).first;
+    }
+
+    i->second.count++;
+    i->second.lastLatency = microseconds;
+    if(microseconds > i->second.maxLatency)
+    {
+        i->second.maxLatency = microseconds;
+    }
+}
+
+
+QList<SlowCallback> AgentStatistics::slowCallbacks() const
+{
+    QMutexLocker locker(&slow_mutex);
+
+    QList<SlowCallback> result;
+    map<Oid, SlowCallback>::const_iterator i;
+    for(i = slow_log.begin(); i != slow_log.end(); i++)
+    {
+        result.append(i->second);
+    }
+    return result;
+}
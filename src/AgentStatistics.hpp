@@ -0,0 +1,719 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#ifndef _AGENTSTATISTICS_HPP_
+#define _AGENTSTATISTICS_HPP_
+
+#include <map>
+
+#include <QtGlobal>
+#include <QSharedPointer>
+#include <QList>
+#include <QMutex>
+
+#include "Oid.hpp"
+#include "PDU.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \brief A histogram of latencies.
+     *
+     * The latencies are counted in buckets with exponentially growing
+     * widths: bucket 0 counts latencies below 1 microsecond, and bucket i
+     * (for i > 0) counts latencies from 2^(i-1) up to (but excluding) 2^i
+     * microseconds. The last bucket also counts all longer latencies.
+     *
+     * Recording is lock-free and may be done from any thread. Reading while
+     * recording is in progress may yield a count which doesn't match the
+     * sum of the buckets exactly.
+     */
+    class LatencyHistogram
+    {
+        public:
+            /**
+             * \brief The number of buckets.
+             */
+            static const int bucket_count = 28;
+
+            /**
+             * \brief Constructor.
+             *
+             * All counts are 0.
+             *
+             * \exception None.
+             */
+            LatencyHistogram();
+
+            /**
+             * \brief Record a latency.
+             *
+             * \param microseconds The latency.
+             *
+             * \exception None.
+             */
+            void record(quint64 microseconds);
+
+            /**
+             * \brief Get the number of recorded latencies.
+             *
+             * \exception None.
+             */
+            quint64 count() const
+            {
+                return __atomic_load_n(&n, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the sum of all recorded latencies in
+             *        microseconds.
+             *
+             * \exception None.
+             */
+            quint64 sum() const
+            {
+                return __atomic_load_n(&total, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the count of a bucket.
+             *
+             * \param i The bucket, 0 <= i < bucket_count.
+             *
+             * \exception None.
+             */
+            quint64 bucket(int i) const
+            {
+                return __atomic_load_n(&buckets[i], __ATOMIC_RELAXED);
+            }
+
+        private:
+            /**
+             * \brief See count().
+             */
+            quint64 n;
+
+            /**
+             * \brief See sum().
+             */
+            quint64 total;
+
+            /**
+             * \brief See bucket().
+             */
+            quint64 buckets[bucket_count];
+    };
+
+    /**
+     * \brief Statistics of the callbacks for a registered subtree.
+     *
+     * A callback is a call to a variable's handle_get() or handle_testset()
+     * method, or a Get request served by a SubtreeHandler. A callback fails
+     * if it throws an exception, or if handle_testset() doesn't return
+     * noError.
+     */
+    class SubtreeStatistics
+    {
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * \exception None.
+             */
+            SubtreeStatistics()
+            : n_callbacks(0),
+              n_failures(0)
+            {
+            }
+
+            /**
+             * \brief Get the number of callbacks.
+             *
+             * \exception None.
+             */
+            quint64 callbacks() const
+            {
+                return __atomic_load_n(&n_callbacks, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the number of failed callbacks.
+             *
+             * \exception None.
+             */
+            quint64 failures() const
+            {
+                return __atomic_load_n(&n_failures, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the latencies of the callbacks.
+             *
+             * \exception None.
+             */
+            const LatencyHistogram& latency() const
+            {
+                return histogram;
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Record a callback.
+             *
+             * \exception None.
+             */
+            void record(quint64 microseconds, bool failed)
+            {
+                __atomic_fetch_add(&n_callbacks, 1, __ATOMIC_RELAXED);
+                if(failed)
+                {
+                    __atomic_fetch_add(&n_failures, 1, __ATOMIC_RELAXED);
+                }
+                histogram.record(microseconds);
+            }
+
+        private:
+            /**
+             * \brief See callbacks().
+             */
+            quint64 n_callbacks;
+
+            /**
+             * \brief See failures().
+             */
+            quint64 n_failures;
+
+            /**
+             * \brief See latency().
+             */
+            LatencyHistogram histogram;
+    };
+
+    /**
+     * \brief An entry of the slow callback log.
+     *
+     * See AgentStatistics::slowCallbacks().
+     */
+    struct SlowCallback
+    {
+        /**
+         * \brief The OID passed to the callback.
+         */
+        Oid name;
+
+        /**
+         * \brief The number of slow callbacks for the OID.
+         */
+        quint64 count;
+
+        /**
+         * \brief The longest duration of a callback for the OID, in
+         *        microseconds.
+         */
+        quint64 maxLatency;
+
+        /**
+         * \brief The duration of the most recent slow callback for the
+         *        OID, in microseconds.
+         */
+        quint64 lastLatency;
+    };
+
+    /**
+     * \brief Runtime statistics of a subagent.
+     *
+     * The MasterProxy and its Connector count the PDU's they
+     * handle, the bytes they transfer and the time spent in the callbacks
+     * of the application. The statistics are obtained with
+     * MasterProxy::statistics(), and they can be exported as a MIB subtree
+     * with MasterProxy::exportStatistics().
+     *
+     * All counters start at 0 when the MasterProxy is created and are never
+     * reset. They are updated with atomic operations without locks, so
+     * that they can be read from any thread.
+     * Only the slow callback log (see slowCallbacks()) is protected by a
+     * mutex, which is locked for slow callbacks only.
+     *
+     * The per-subtree statistics are kept for each subtree registered with
+     * MasterProxy::register_subtree(). A callback is accounted to the
+     * registered subtree containing the OID of the variable (the longest
+     * one, if registrations are nested). Callbacks for OID's outside of all
+     * registered subtrees are not accounted per subtree. The set of
+     * subtrees must only be inspected from the thread which registers
+     * subtrees (usually the thread running the QApplication event loop).
+     */
+    class AgentStatistics
+    {
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * \exception None.
+             */
+            AgentStatistics();
+
+            /**
+             * \brief Get the number of received PDU's of a type.
+             *
+             * Only PDU's processed by the MasterProxy are counted, i.e.
+             * requests from the master agent, but no responses.
+             *
+             * \exception None.
+             */
+            quint64 pdusHandled(PDU::type_t type) const;
+
+            /**
+             * \brief Get the number of received PDU's of a type which were
+             *        answered with an error.
+             *
+             * \exception None.
+             */
+            quint64 pduErrors(PDU::type_t type) const;
+
+            /**
+             * \brief Get the processing times of the received PDU's of a
+             *        type.
+             *
+             * The time is measured from the beginning of the processing
+             * until the response is handed to the connector.
+             *
+             * \exception None.
+             */
+            const LatencyHistogram& pduLatency(PDU::type_t type) const;
+
+            /**
+             * \brief Get the number of PDU's sent to the master agent.
+             *
+             * \exception None.
+             */
+            quint64 pdusSent() const
+            {
+                return __atomic_load_n(&n_pdus_sent, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the number of PDU's received from the master
+             *        agent (including responses).
+             *
+             * \exception None.
+             */
+            quint64 pdusReceived() const
+            {
+                return __atomic_load_n(&n_pdus_received, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the number of bytes sent to the master agent.
+             *
+             * \exception None.
+             */
+            quint64 bytesSent() const
+            {
+                return __atomic_load_n(&n_bytes_sent, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the number of bytes received from the master
+             *        agent.
+             *
+             * \exception None.
+             */
+            quint64 bytesReceived() const
+            {
+                return __atomic_load_n(&n_bytes_received, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the number of received PDU's which could not be
+             *        parsed.
+             *
+             * \exception None.
+             */
+            quint64 parseErrors() const
+            {
+                return __atomic_load_n(&n_parse_errors, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the number of sessions opened with the master
+             *        agent.
+             *
+             * \exception None.
+             */
+            quint64 connects() const
+            {
+                return __atomic_load_n(&n_connects, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the number of sessions opened after the first
+             *        one.
+             *
+             * \exception None.
+             */
+            quint64 reconnects() const
+            {
+                quint64 n = connects();
+                return n ? n - 1 : 0;
+            }
+
+            /**
+             * \brief Get the number of PDU's waiting to be sent by the
+             *        connector.
+             *
+             * \exception None.
+             */
+            quint32 sendQueueDepth() const
+            {
+                return __atomic_load_n(&n_send_queue, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the number of received PDU's waiting to be
+             *        processed by the MasterProxy.
+             *
+             * \exception None.
+             */
+            quint32 receiveQueueDepth() const
+            {
+                return __atomic_load_n(&n_receive_queue, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the number of requests which were answered
+             *        before all varbinds were processed, because the
+             *        deadline of the request passed.
+             *
+             * See MasterProxy::setDeadlineCutoff().
+             *
+             * \exception None.
+             */
+            quint64 deadlineCutoffs() const
+            {
+                return __atomic_load_n(&n_deadline_cutoffs, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the time to full service of the last session, in
+             *        microseconds.
+             *
+             * This is the time from the beginning of MasterProxy::connect()
+             * until the session was opened and all registrations of the
+             * previous session were restored. It is 0 until the first
+             * session was opened.
+             *
+             * \exception None.
+             */
+            quint64 timeToService() const
+            {
+                return __atomic_load_n(&time_to_service, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Set the duration above which a callback is logged as
+             *        slow.
+             *
+             * The default is 100000 microseconds (100 milliseconds).
+             *
+             * \param microseconds The threshold. 0 disables the slow
+             *                     callback log.
+             *
+             * \exception None.
+             */
+            void setSlowCallbackThreshold(quint64 microseconds)
+            {
+                __atomic_store_n(&slow_threshold, microseconds,
+                                 __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the duration above which a callback is logged as
+             *        slow, in microseconds.
+             *
+             * \exception None.
+             */
+            quint64 slowCallbackThreshold() const
+            {
+                return __atomic_load_n(&slow_threshold, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief The maximum number of OID's in the slow callback log.
+             */
+            static const int slow_log_size = 64;
+
+            /**
+             * \brief Get the slow callback log.
+             *
+             * The log contains one entry per OID for which a callback took
+             * at least slowCallbackThreshold() microseconds, ordered by OID.
+             * It holds at most slow_log_size entries; when it is full, the
+             * entry with the shortest maxLatency is replaced by a slower
+             * callback for another OID.
+             *
+             * The log may be read from any thread.
+             *
+             * \exception None.
+             */
+            QList<SlowCallback> slowCallbacks() const;
+
+            /**
+             * \brief Get the subtrees for which statistics are kept.
+             *
+             * \exception None.
+             */
+            QList<Oid> subtrees() const;
+
+            /**
+             * \brief Get the statistics of a registered subtree.
+             *
+             * \return The statistics, or a NULL pointer if the subtree is
+             *         not registered.
+             *
+             * \exception None.
+             */
+            QSharedPointer<SubtreeStatistics> subtree(const Oid& oid) const;
+
+            /**
+             * \brief Get the current time of a monotonic clock in
+             *        microseconds.
+             *
+             * \exception None.
+             */
+            static quint64 now();
+
+            /**
+             * \internal
+             *
+             * \brief Record a handled PDU.
+             */
+            void record_pdu(PDU::type_t type, quint64 microseconds,
+                            bool error);
+
+            /**
+             * \internal
+             *
+             * \brief Record a callback for a variable.
+             */
+            void record_callback(const Oid& name, quint64 microseconds,
+                                 bool failed);
+
+            /**
+             * \internal
+             *
+             * \brief Record a request answered early because of its
+             *        deadline.
+             */
+            void record_deadline_cutoff()
+            {
+                __atomic_fetch_add(&n_deadline_cutoffs, 1, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Record a PDU sent to the master agent.
+             */
+            void record_sent(quint32 bytes)
+            {
+                __atomic_fetch_add(&n_pdus_sent, 1, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&n_bytes_sent, bytes, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Record a PDU received from the master agent.
+             */
+            void record_received(quint32 bytes)
+            {
+                __atomic_fetch_add(&n_pdus_received, 1, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&n_bytes_received, bytes,
+                                   __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Record a PDU which could not be parsed.
+             */
+            void record_parse_error()
+            {
+                __atomic_fetch_add(&n_parse_errors, 1, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Record an opened session.
+             */
+            void record_connect()
+            {
+                __atomic_fetch_add(&n_connects, 1, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Record the time to full service of a session.
+             */
+            void record_time_to_service(quint64 microseconds)
+            {
+                __atomic_store_n(&time_to_service, microseconds,
+                                 __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Change the send queue depth.
+             */
+            void add_send_queue(int delta)
+            {
+                __atomic_fetch_add(&n_send_queue, delta, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Change the receive queue depth.
+             */
+            void add_receive_queue(int delta)
+            {
+                __atomic_fetch_add(&n_receive_queue, delta,
+                                   __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Start keeping statistics for a subtree.
+             *
+             * If statistics are kept already, nothing happens.
+             */
+            void add_subtree(const Oid& oid);
+
+            /**
+             * \internal
+             *
+             * \brief Stop keeping statistics for a subtree.
+             */
+            void remove_subtree(const Oid& oid);
+
+        private:
+            /**
+             * \brief Number of PDU types (RFC 2741, 6.1. "AgentX PDU
+             *        Header"), plus 1 for the unused type 0.
+             */
+            static const int type_count = 19;
+
+            /**
+             * \brief Statistics for one PDU type.
+             */
+            struct PduStatistics
+            {
+                quint64 handled;
+                quint64 errors;
+                LatencyHistogram latency;
+            };
+
+            /**
+             * \brief Statistics per PDU type, indexed by the type.
+             */
+            PduStatistics pdus[type_count];
+
+            /**
+             * \brief See pdusSent().
+             */
+            quint64 n_pdus_sent;
+
+            /**
+             * \brief See pdusReceived().
+             */
+            quint64 n_pdus_received;
+
+            /**
+             * \brief See bytesSent().
+             */
+            quint64 n_bytes_sent;
+
+            /**
+             * \brief See bytesReceived().
+             */
+            quint64 n_bytes_received;
+
+            /**
+             * \brief See parseErrors().
+             */
+            quint64 n_parse_errors;
+
+            /**
+             * \brief See connects().
+             */
+            quint64 n_connects;
+
+            /**
+             * \brief See sendQueueDepth().
+             */
+            quint32 n_send_queue;
+
+            /**
+             * \brief See receiveQueueDepth().
+             */
+            quint32 n_receive_queue;
+
+            /**
+             * \brief See deadlineCutoffs().
+             */
+            quint64 n_deadline_cutoffs;
+
+            /**
+             * \brief See timeToService().
+             */
+            quint64 time_to_service;
+
+            /**
+             * \brief The statistics of the registered subtrees.
+             */
+            std::map< Oid, QSharedPointer<SubtreeStatistics> > subtree_stats;
+
+            /**
+             * \brief See slowCallbackThreshold().
+             */
+            quint64 slow_threshold;
+
+            /**
+             * \brief The slow callback log (see slowCallbacks()).
+             */
+            std::map<Oid, SlowCallback> slow_log;
+
+            /**
+             * \brief Protects slow_log.
+             */
+            mutable QMutex slow_mutex;
+
+            /**
+             * \brief Add a slow callback to the log.
+             */
+            void record_slow_callback(const Oid& name, quint64 microseconds);
+    };
+}
+
+#endif /* _AGENTSTATISTICS_HPP_ */
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#include <cstring>
+
+#include "ByteArrayVariable.hpp"
+#include "util.hpp"
+
+using namespace agentxcpp;
+
+
+/**
+ * \brief Get the number of padding bytes following a value of the given size.
+ */
+static int padding(int size)
+{
+    return (4 - size % 4) % 4;
+}
+
+
+binary ByteArrayVariable::serialize() const
+{
+    binary serialized;
+
+    // encode size (big endian)
+    write32(serialized, v.size());
+
+    // encode value
+    serialized.append(reinterpret_cast<const quint8*>(v.constData()),
+                      v.size());
+
+    // Padding bytes
+    serialized.append(padding(v.size()), 0);
+
+    return serialized;
+}
+
+
+void ByteArrayVariable::serialize_to(SegmentedBuffer& out) const
+{
+    // encode size (in the buffer's byte order)
+    out.write32(v.size());
+
+    // reference the value
+    out.append(v);
+
+    // Padding bytes
+    int pad = padding(v.size());
+    if(pad)
+    {
+        memset(out.allocate(pad), 0, pad);
+    }
+}
+
+
+Oid ByteArrayVariable::toOid() const
+{
+    Oid oid;
+    if(t != OctetString)
+    {
+        // Opaque values are not allowed as INDEX
+        return oid;
+    }
+
+    // Store string length and string
+    oid.push_back(v.size());
+    for(int i = 0; i < v.size(); i++)
+    {
+        oid.push_back(static_cast<quint8>(v.at(i)));
+    }
+    return oid;
+}
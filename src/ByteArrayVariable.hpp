@@ -0,0 +1,220 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#ifndef _BYTEARRAYVARIABLE_HPP_
+#define _BYTEARRAYVARIABLE_HPP_
+
+#include <QtGlobal>
+#include <QByteArray>
+
+#include "AbstractVariable.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \brief An OctetString or Opaque variable holding its value in a
+     *        QByteArray.
+     *
+     * OctetStringVariable and OpaqueVariable store their value in a binary
+     * object, which is copied when the value is set, when it is read, and
+     * when the variable is serialized. For large values such as
+     * configuration blobs or long descriptions, these copies are
+     * expensive.
+     *
+     * A ByteArrayVariable holds its value in a QByteArray. As QByteArray is
+     * implicitly shared, setting and reading the value only copies a
+     * pointer, and several variables can share the same buffer. When a
+     * response is sent to the master agent, the buffer is handed to the
+     * socket without being copied. Memory owned by the application can be
+     * wrapped with QByteArray::fromRawData(), which doesn't copy either (the
+     * memory must then stay valid and unmodified as long as the variable
+     * uses it).
+     *
+     * The variable is read-only; Set requests are refused with notWritable.
+     * To update the value before a Get request is answered, a derived
+     * class may override perform_get() and call setValue() from there.
+     */
+    class ByteArrayVariable : public AbstractVariable
+    {
+        public:
+            /**
+             * \brief The SNMP types which the variable may have.
+             *
+             * The numeric values are the type codes of RFC 2741, 5.4.
+             * "Value Representation".
+             */
+            enum type_t
+            {
+                OctetString = 4,
+                Opaque = 68
+            };
+
+            /**
+             * \brief Constructor.
+             *
+             * \param value The initial value.
+             *
+             * \param type The SNMP type of the variable.
+             *
+             * \exception None.
+             */
+            ByteArrayVariable(const QByteArray& value = QByteArray(),
+                              type_t type = OctetString)
+            : v(value),
+              t(type)
+            {
+            }
+
+            /**
+             * \brief Set the value.
+             *
+             * The buffer is shared, not copied.
+             *
+             * \exception None.
+             */
+            void setValue(const QByteArray& value)
+            {
+                v = value;
+            }
+
+            /**
+             * \brief Get the value.
+             *
+             * The buffer is shared, not copied.
+             *
+             * \exception None.
+             */
+            QByteArray value() const
+            {
+                return v;
+            }
+
+            /**
+             * \brief Get the SNMP type of the variable.
+             *
+             * \exception None.
+             */
+            type_t type() const
+            {
+                return t;
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Encode the object as described in RFC 2741, section
+             *        5.4.
+             *
+             * This copies the value; the connectors use serialize_to()
+             * instead.
+             */
+            binary serialize() const;
+
+            /**
+             * \internal
+             *
+             * \brief Encode the object without copying the value.
+             *
+             * The length and the padding are copied into the buffer, the
+             * value is referenced.
+             */
+            virtual void serialize_to(SegmentedBuffer& out) const;
+
+            /**
+             * \brief Convert the value to an OID.
+             *
+             * OctetString values are converted like
+             * OctetStringVariable::toOid() does. Opaque values cannot be
+             * converted; the null Oid is returned for them.
+             */
+            virtual Oid toOid() const;
+
+            /**
+             * \internal
+             *
+             * \copydoc agentxcpp::ScalarVariable::handle_get()
+             */
+            virtual void handle_get()
+            {
+                perform_get();
+            }
+
+            /**
+             * \copydoc agentxcpp::ScalarVariable::perform_get()
+             */
+            virtual void perform_get()
+            {
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Refuse Set requests.
+             *
+             * \return notWritable.
+             */
+            virtual testset_result_t handle_testset(
+                    QSharedPointer<AbstractVariable>)
+            {
+                return notWritable;
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Does nothing, since Set requests are refused.
+             */
+            virtual void handle_cleanupset()
+            {
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Does nothing, since Set requests are refused.
+             */
+            virtual bool handle_commitset()
+            {
+                return false;
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Does nothing, since Set requests are refused.
+             */
+            virtual bool handle_undoset()
+            {
+                return false;
+            }
+
+        private:
+            /**
+             * \brief The value.
+             */
+            QByteArray v;
+
+            /**
+             * \brief The SNMP type.
+             */
+            type_t t;
+    };
+}
+
+#endif /* _BYTEARRAYVARIABLE_HPP_ */
@@ -0,0 +1,571 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#include <algorithm>
+
+#include "ColumnarTable.hpp"
+#include "IntegerVariable.hpp"
+#include "Counter32Variable.hpp"
+#include "Counter64Variable.hpp"
+#include "Gauge32Variable.hpp"
+#include "TimeTicksVariable.hpp"
+#include "IpAddressVariable.hpp"
+#include "SharedVariable.hpp"
+#include "exceptions.hpp"
+
+using namespace agentxcpp;
+using namespace std;
+
+
+/**
+ * \brief Get the subids of an OID starting at a given position.
+ */
+static Oid suffix(const Oid& oid, int pos)
+{
+    Oid result;
+    for(int i = pos; i < oid.size(); i++)
+    {
+        result.push_back(oid[i]);
+    }
+    return result;
+}
+
+
+/**
+ * \brief Orders (index, slot) pairs by their index.
+ */
+static bool index_less(const pair<Oid, quint32>& a,
+                       const pair<Oid, quint32>& b)
+{
+    return a.first < b.first;
+}
+
+
+/**
+ * \brief Insert zero values into a column.
+ *
+ * \param values The values of the column.
+ *
+ * \param added For each row of the enlarged table, whether it is a new row
+ *              (which gets a zero value) or an existing row (which gets
+ *              the next value of values).
+ */
+template<class T>
+static void merge_zeros(vector<T>& values, const vector<bool>& added)
+{
+    vector<T> merged;
+    merged.reserve(added.size());
+    typename vector<T>::const_iterator v = values.begin();
+    for(size_t i = 0; i < added.size(); i++)
+    {
+        merged.push_back(added[i] ? T(0) : *v++);
+    }
+    values.swap(merged);
+}
+
+
+ColumnarTable::ColumnarTable(Oid oid, quint32 entry_subid)
+: myOid(oid),
+  myEntryOid(oid, entry_subid)
+{
+}
+
+
+int ColumnarTable::find_row(const Oid& index) const
+{
+    vector<Oid>::const_iterator i;
+    i = lower_bound(rows.begin(), rows.end(), index);
+    if(i == rows.end() || *i != index)
+    {
+        // Row not found
+        return -1;
+    }
+    return i - rows.begin();
+}
+
+
+void ColumnarTable::addColumn(quint32 subid, column_type_t type)
+{
+    Column column;
+    column.type = type;
+    column.offset = 0;
+
+    // Allocate zero values for the existing rows
+    switch(type)
+    {
+        case Integer:
+        case IpAddress:
+        case Counter32:
+        case Gauge32:
+        case TimeTicks:
+            column.values32.resize(rows.size(), 0);
+            break;
+        case Counter64:
+            column.values64.resize(rows.size(), 0);
+            break;
+        default:
+            // Not a plain numeric type
+            throw(inval_param());
+    }
+
+    columns[subid] = column;
+}
+
+
+void ColumnarTable::addSharedColumn(quint32 subid, column_type_t type,
+                                    QSharedPointer<SharedStatsRegion> region,
+                                    quint32 offset)
+{
+    switch(type)
+    {
+        case Integer:
+        case Counter32:
+        case Gauge32:
+        case TimeTicks:
+        case Counter64:
+            break;
+        default:
+            // Not supported for shared columns
+            throw(inval_param());
+    }
+    if(! region)
+    {
+        throw(inval_param());
+    }
+
+    Column column;
+    column.type = type;
+    column.region = region;
+    column.offset = offset;
+
+    columns[subid] = column;
+}
+
+
+bool ColumnarTable::addRow(const Oid& index, quint32 first_slot)
+{
+    if(index.empty())
+    {
+        // A row needs an index
+        return false;
+    }
+
+    // Find the position of the new row
+    vector<Oid>::iterator i = lower_bound(rows.begin(), rows.end(), index);
+    if(i != rows.end() && *i == index)
+    {
+        // Row exists already
+        return false;
+    }
+    int pos = i - rows.begin();
+
+    // Insert the index and a zero value in each column
+    rows.insert(i, index);
+    row_slots.insert(row_slots.begin() + pos, first_slot);
+    map<quint32, Column>::iterator c;
+    for(c = columns.begin(); c != columns.end(); c++)
+    {
+        if(c->second.region)
+        {
+            // Shared column: no local values
+            continue;
+        }
+        if(c->second.type == Counter64)
+        {
+            c->second.values64.insert(c->second.values64.begin() + pos, 0);
+        }
+        else
+        {
+            c->second.values32.insert(c->second.values32.begin() + pos, 0);
+        }
+    }
+
+    return true;
+}
+
+
+int ColumnarTable::addRows(const vector<Oid>& indexes,
+                           const vector<quint32>& first_slots)
+{
+    // Sort the new rows. The sort is stable, so that the first of several
+    // equal indexes is kept.
+    vector< pair<Oid, quint32> > sorted;
+    sorted.reserve(indexes.size());
+    for(size_t i = 0; i < indexes.size(); i++)
+    {
+        if(indexes[i].empty())
+        {
+            // A row needs an index
+            continue;
+        }
+        quint32 slot = (i < first_slots.size()) ? first_slots[i] : 0;
+        sorted.push_back(make_pair(indexes[i], slot));
+    }
+    stable_sort(sorted.begin(), sorted.end(), index_less);
+
+    // Merge the new rows with the existing ones
+    vector<Oid> merged_rows;
+    vector<quint32> merged_slots;
+    vector<bool> added;
+    merged_rows.reserve(rows.size() + sorted.size());
+    merged_slots.reserve(rows.size() + sorted.size());
+    added.reserve(rows.size() + sorted.size());
+    size_t r = 0;
+    size_t s = 0;
+    while(r < rows.size() || s < sorted.size())
+    {
+        if(   s == sorted.size()
+           || (r < rows.size() && rows[r] < sorted[s].first) )
+        {
+            // Existing row
+            merged_rows.push_back(rows[r]);
+            merged_slots.push_back(row_slots[r]);
+            added.push_back(false);
+            r++;
+        }
+        else if(   (r < rows.size() && rows[r] == sorted[s].first)
+                || (! merged_rows.empty()
+                    && merged_rows.back() == sorted[s].first) )
+        {
+            // Row exists already, or was given twice
+            s++;
+        }
+        else
+        {
+            // New row
+            merged_rows.push_back(sorted[s].first);
+            merged_slots.push_back(sorted[s].second);
+            added.push_back(true);
+            s++;
+        }
+    }
+    int count = merged_rows.size() - rows.size();
+    if(count == 0)
+    {
+        return 0;
+    }
+
+    // Insert zero values for the new rows in each column
+    map<quint32, Column>::iterator c;
+    for(c = columns.begin(); c != columns.end(); c++)
+    {
+        if(c->second.region)
+        {
+            // Shared column: no local values
+            continue;
+        }
+        if(c->second.type == Counter64)
+        {
+            merge_zeros(c->second.values64, added);
+        }
+        else
+        {
+            merge_zeros(c->second.values32, added);
+        }
+    }
+    rows.swap(merged_rows);
+    row_slots.swap(merged_slots);
+
+    return count;
+}
+
+
+bool ColumnarTable::removeRow(const Oid& index)
+{
+    int pos = find_row(index);
+    if(pos == -1)
+    {
+        // Row not found
+        return false;
+    }
+
+    // Remove the index and the row's value from each column
+    rows.erase(rows.begin() + pos);
+    row_slots.erase(row_slots.begin() + pos);
+    map<quint32, Column>::iterator c;
+    for(c = columns.begin(); c != columns.end(); c++)
+    {
+        if(c->second.region)
+        {
+            // Shared column: no local values
+            continue;
+        }
+        if(c->second.type == Counter64)
+        {
+            c->second.values64.erase(c->second.values64.begin() + pos);
+        }
+        else
+        {
+            c->second.values32.erase(c->second.values32.begin() + pos);
+        }
+    }
+
+    return true;
+}
+
+
+void ColumnarTable::clear()
+{
+    rows.clear();
+    row_slots.clear();
+    map<quint32, Column>::iterator c;
+    for(c = columns.begin(); c != columns.end(); c++)
+    {
+        c->second.values32.clear();
+        c->second.values64.clear();
+    }
+}
+
+
+bool ColumnarTable::setValue(const Oid& index, quint32 column, quint64 value)
+{
+    map<quint32, Column>::iterator c = columns.find(column);
+    if(c == columns.end() || c->second.region)
+    {
+        // No such column, or shared column
+        return false;
+    }
+    int pos = find_row(index);
+    if(pos == -1)
+    {
+        // No such row
+        return false;
+    }
+
+    if(c->second.type == Counter64)
+    {
+        c->second.values64[pos] = value;
+    }
+    else
+    {
+        c->second.values32[pos] = static_cast<quint32>(value);
+    }
+
+    return true;
+}
+
+
+quint64 ColumnarTable::value(const Oid& index, quint32 column) const
+{
+    map<quint32, Column>::const_iterator c = columns.find(column);
+    if(c == columns.end())
+    {
+        // No such column
+        return 0;
+    }
+    int pos = find_row(index);
+    if(pos == -1)
+    {
+        // No such row
+        return 0;
+    }
+
+    if(c->second.region)
+    {
+        quint64 v;
+        if(! c->second.region->read(row_slots[pos] + c->second.offset, 1, &v))
+        {
+            // Value cannot be read
+            return 0;
+        }
+        return v;
+    }
+    if(c->second.type == Counter64)
+    {
+        return c->second.values64[pos];
+    }
+    else
+    {
+        return c->second.values32[pos];
+    }
+}
+
+
+QSharedPointer<AbstractVariable> ColumnarTable::cell(const Column& column,
+                                                     int row) const
+{
+    if(column.region)
+    {
+        // The value is read when handle_get() is called
+        QSharedPointer<SharedStatsRegion> region = column.region;
+        quint32 slot = row_slots[row] + column.offset;
+        switch(column.type)
+        {
+            case Integer:
+                return QSharedPointer<AbstractVariable>(
+                        new SharedIntegerVariable(region, slot));
+            case Counter32:
+                return QSharedPointer<AbstractVariable>(
+                        new SharedCounter32Variable(region, slot));
+            case Gauge32:
+                return QSharedPointer<AbstractVariable>(
+                        new SharedGauge32Variable(region, slot));
+            case TimeTicks:
+                return QSharedPointer<AbstractVariable>(
+                        new SharedTimeTicksVariable(region, slot));
+            case Counter64:
+            default:
+                return QSharedPointer<AbstractVariable>(
+                        new SharedCounter64Variable(region, slot));
+        }
+    }
+
+    quint32 v = 0;
+    if(column.type != Counter64)
+    {
+        v = column.values32[row];
+    }
+
+    switch(column.type)
+    {
+        case Integer:
+            return QSharedPointer<AbstractVariable>(
+                    new IntegerVariable(static_cast<qint32>(v)));
+        case Counter32:
+            return QSharedPointer<AbstractVariable>(new Counter32Variable(v));
+        case TimeTicks:
+            return QSharedPointer<AbstractVariable>(new TimeTicksVariable(v));
+        case IpAddress:
+            return QSharedPointer<AbstractVariable>(
+                    new IpAddressVariable(v >> 24 & 0xff,
+                                          v >> 16 & 0xff,
+                                          v >> 8 & 0xff,
+                                          v >> 0 & 0xff));
+        case Gauge32:
+        {
+            QSharedPointer<Gauge32Variable> gauge(new Gauge32Variable);
+            gauge->setValue(v);
+            return gauge;
+        }
+        case Counter64:
+        default:
+            return QSharedPointer<AbstractVariable>(
+                    new Counter64Variable(column.values64[row]));
+    }
+}
+
+
+Varbind ColumnarTable::get(const Oid& name)
+{
+    // The name must have the form <entryOid>.<column>.<index> with a
+    // non-empty index
+    if(    ! myEntryOid.contains(name)
+        || name.size() < myEntryOid.size() + 2 )
+    {
+        return Varbind(name, Varbind::noSuchObject);
+    }
+
+    // Find column
+    map<quint32, Column>::const_iterator c;
+    c = columns.find(name[myEntryOid.size()]);
+    if(c == columns.end())
+    {
+        // Unknown column
+        return Varbind(name, Varbind::noSuchObject);
+    }
+
+    // Find row
+    Oid index = suffix(name, myEntryOid.size() + 1);
+    int pos = find_row(index);
+    if(pos == -1)
+    {
+        // Known column, but unknown row
+        return Varbind(name, Varbind::noSuchInstance);
+    }
+
+    // Update the value (reads shared columns)
+    QSharedPointer<AbstractVariable> var = cell(c->second, pos);
+    var->handle_get();
+    return Varbind(name, var);
+}
+
+
+bool ColumnarTable::next(const Oid& start,
+                         const Oid& /* ending_oid */,
+                         Oid& name,
+                         QSharedPointer<AbstractVariable>& var)
+{
+    if(rows.empty())
+    {
+        // No cells at all
+        return false;
+    }
+
+    // Determine the first candidate column and the position of the first
+    // candidate row within that column
+    map<quint32, Column>::const_iterator c;
+    vector<Oid>::const_iterator r = rows.begin();
+    if(start < myEntryOid)
+    {
+        // start precedes the whole table: first cell is the answer
+        c = columns.begin();
+    }
+    else if(myEntryOid.contains(start))
+    {
+        if(start.size() == myEntryOid.size())
+        {
+            // start is the entry OID itself: first cell is the answer
+            c = columns.begin();
+        }
+        else
+        {
+            quint32 column = start[myEntryOid.size()];
+            c = columns.lower_bound(column);
+            if(c != columns.end() && c->first == column)
+            {
+                // start lies within an existing column: search the row
+                Oid index = suffix(start, myEntryOid.size() + 1);
+                if(start.include())
+                {
+                    r = lower_bound(rows.begin(), rows.end(), index);
+                }
+                else
+                {
+                    r = upper_bound(rows.begin(), rows.end(), index);
+                }
+                if(r == rows.end())
+                {
+                    // No more rows in this column: go to the first row of
+                    // the next column
+                    c++;
+                    r = rows.begin();
+                }
+            }
+        }
+    }
+    else
+    {
+        // start is behind the whole table
+        return false;
+    }
+
+    if(c == columns.end())
+    {
+        // No column left
+        return false;
+    }
+
+    int pos = r - rows.begin();
+    name = myEntryOid;
+    name.push_back(c->first);
+    name += rows[pos];
+    var = cell(c->second, pos);
+
+    return true;
+}
@@ -0,0 +1,411 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#ifndef _COLUMNARTABLE_HPP_
+#define _COLUMNARTABLE_HPP_
+
+#include <map>
+#include <vector>
+
+#include <QtGlobal>
+#include <QSharedPointer>
+
+#include "Oid.hpp"
+#include "AbstractVariable.hpp"
+#include "Varbind.hpp"
+#include "SubtreeHandler.hpp"
+#include "SharedStatsRegion.hpp"
+
+
+namespace agentxcpp
+{
+
+/**
+ * \brief An SNMP table which stores its values column by column.
+ *
+ * The \agentxcpp{Table} class expands each TableEntry into one variable
+ * object per column and adds all of them to the MasterProxy. This is
+ * flexible, but expensive for large tables: a table with 100000 rows and 20
+ * columns results in two million variable objects.
+ *
+ * The ColumnarTable is an alternative for tables whose columns all have a
+ * plain numeric type (Integer, Counter32, Counter64, Gauge32, TimeTicks or
+ * IpAddress). Each column is stored as a contiguous array holding one value
+ * per row. The rows are kept sorted by their index (which is an Oid, see \ref
+ * how_tables_work), and a row is located by binary search over the sorted
+ * index. No variable objects are created for the cells; the table is a
+ * SubtreeHandler which is added to the MasterProxy as a whole, using
+ * MasterProxy::add_table(), and the MasterProxy asks the table directly when
+ * a Get, GetNext or GetBulk request concerns the table's subtree.
+ *
+ * The OID's of the cells are built as described in \ref how_tables_work:
+ *
+ *   \<tableOid\>.\<entrySubOid\>.\<column\>.\<indexOid\>
+ *
+ * A ColumnarTable is set up by adding the columns, followed by adding rows
+ * and setting values:
+ * \code
+ * QSharedPointer<ColumnarTable> table(new ColumnarTable(ifTable_oid));
+ * table->addColumn(1, ColumnarTable::Integer);    // ifIndex
+ * table->addColumn(10, ColumnarTable::Counter32); // ifInOctets
+ * master.add_table(table);
+ *
+ * Oid row;
+ * row.push_back(1);
+ * table->addRow(row);
+ * table->setValue(row, 1, 1);
+ * table->setValue(row, 10, 12345);
+ * \endcode
+ *
+ * Columns can also be backed by a shared statistics region which is written
+ * by another process (see SharedStatsProducer). Such a column is added with
+ * addSharedColumn(), and each row is given the number of its first slot in
+ * the region when it is added. The cell of a row in a shared column is read
+ * from slot \<firstSlot\>+\<offset\> when it is requested, where \<offset\>
+ * is given to addSharedColumn(). If the producer publishes one block of
+ * slots per row, e.g. [packets, bytes, errors], the columns are added with
+ * the offsets 0, 1 and 2, and each row with the first slot of its block:
+ * \code
+ * QSharedPointer<SharedStatsRegion> region(
+ *         new SharedStatsRegion("/myapp-stats"));
+ * table->addSharedColumn(2, ColumnarTable::Counter64, region, 0);
+ * table->addSharedColumn(3, ColumnarTable::Counter64, region, 1);
+ * table->addSharedColumn(4, ColumnarTable::Counter64, region, 2);
+ * table->addRow(row, 3 * row_number);
+ * \endcode
+ *
+ * The cells are read-only; Set requests for them are refused with
+ * notWritable.
+ *
+ * Because the columns are contiguous arrays, addRow() and removeRow() move
+ * all rows behind the affected one in every column, i.e. they cost
+ * O(rows * columns). Adding rows in ascending index order avoids this, as
+ * each row is then appended. To load many rows in arbitrary order, use
+ * addRows(), which sorts them and merges them into the table in a single
+ * pass.
+ *
+ * \note The table is not protected against concurrent access. Like for the
+ *       other variable types, values should be changed from within the
+ *       thread running the QApplication event loop.
+ */
+class ColumnarTable : public SubtreeHandler
+{
+    public:
+        /**
+         * \brief The types which a column may have.
+         *
+         * The numeric values are the type codes of RFC 2741, 5.4. "Value
+         * Representation".
+         */
+        enum column_type_t
+        {
+            Integer = 2,
+            IpAddress = 64,
+            Counter32 = 65,
+            Gauge32 = 66,
+            TimeTicks = 67,
+            Counter64 = 70
+        };
+
+        /**
+         * \brief Constructor.
+         *
+         * Create an empty table without columns.
+         *
+         * \param oid The table's OID.
+         *
+         * \param entry_subid The \<entrySubOid\> of the table's entries (see
+         *                    \ref how_tables_work). This is 1 for almost
+         *                    every MIB.
+         *
+         * \exception None.
+         */
+        ColumnarTable(Oid oid, quint32 entry_subid = 1);
+
+        /**
+         * \brief Get the table's OID.
+         *
+         * \exception None.
+         */
+        Oid oid() const
+        {
+            return myOid;
+        }
+
+        /**
+         * \brief Add a column to the table.
+         *
+         * If the table already contains rows, the new column is filled with
+         * zero values for all of them. If a column with the same subid
+         * exists, it is replaced (and its values are reset to zero).
+         *
+         * \param subid The \<column\> part of the cells OID's.
+         *
+         * \param type The type of the column.
+         *
+         * \exception inval_param If the type is unknown.
+         */
+        void addColumn(quint32 subid, column_type_t type);
+
+        /**
+         * \brief Add a column whose values are read from a shared
+         *        statistics region.
+         *
+         * The value of a cell is read from the slot \<firstSlot\>+offset
+         * of the region, where \<firstSlot\> is the slot given for the row
+         * to addRow(). If a column with the same subid exists, it is
+         * replaced.
+         *
+         * \param subid The \<column\> part of the cells OID's.
+         *
+         * \param type The type of the column. IpAddress is not supported.
+         *
+         * \param region The region containing the values.
+         *
+         * \param offset The offset of the column's slot relative to the
+         *               first slot of a row.
+         *
+         * \exception inval_param If the type is unknown or IpAddress, or if
+         *                        region is NULL.
+         */
+        void addSharedColumn(quint32 subid, column_type_t type,
+                             QSharedPointer<SharedStatsRegion> region,
+                             quint32 offset);
+
+        /**
+         * \brief Add a row.
+         *
+         * All cells of the new row are zero, except for shared columns
+         * (see addSharedColumn()).
+         *
+         * \param index The index of the row, i.e. the concatenated index
+         *              values as described in \ref how_tables_work.
+         *
+         * \param first_slot The first slot of the row in the shared
+         *                   statistics region. Only used by shared columns.
+         *
+         * \return true on success, false if a row with this index already
+         *         exists or if the index is empty.
+         *
+         * \exception None.
+         */
+        bool addRow(const Oid& index, quint32 first_slot = 0);
+
+        /**
+         * \brief Add many rows at once.
+         *
+         * Like calling addRow() for each index, but the rows are sorted
+         * once and merged into the table in a single pass. This costs
+         * O(n log n + rows * columns) instead of O(n * rows * columns) for
+         * n rows added in arbitrary order.
+         *
+         * \param indexes The indexes of the rows. Empty indexes and
+         *                indexes of existing rows are skipped. If an index
+         *                appears several times, only the first occurrence
+         *                is added.
+         *
+         * \param first_slots The first slot of each row in the shared
+         *                    statistics region (parallel to indexes). Rows
+         *                    without an entry get slot 0.
+         *
+         * \return The number of rows added.
+         *
+         * \exception None.
+         */
+        int addRows(const std::vector<Oid>& indexes,
+                    const std::vector<quint32>& first_slots
+                        = std::vector<quint32>());
+
+        /**
+         * \brief Remove a row.
+         *
+         * \param index The index of the row to remove.
+         *
+         * \return true on success, false if the row does not exist.
+         *
+         * \exception None.
+         */
+        bool removeRow(const Oid& index);
+
+        /**
+         * \brief Remove all rows.
+         *
+         * The columns are kept.
+         *
+         * \exception None.
+         */
+        void clear();
+
+        /**
+         * \brief Check whether a row exists.
+         *
+         * \exception None.
+         */
+        bool containsRow(const Oid& index) const
+        {
+            return find_row(index) != -1;
+        }
+
+        /**
+         * \brief Get the number of rows.
+         *
+         * \exception None.
+         */
+        int rowCount() const
+        {
+            return static_cast<int>(rows.size());
+        }
+
+        /**
+         * \brief Set the value of a cell.
+         *
+         * The value is truncated to the width of the column. Integer cells
+         * store the two's complement of negative values. IpAddress cells
+         * store the address as a 32-bit number with the first octet in the
+         * most significant byte.
+         *
+         * \param index The row index.
+         *
+         * \param column The column subid.
+         *
+         * \param value The new value.
+         *
+         * \return true on success, false if the row or the column does not
+         *         exist, or if the column is a shared column.
+         *
+         * \exception None.
+         */
+        bool setValue(const Oid& index, quint32 column, quint64 value);
+
+        /**
+         * \brief Get the value of a cell.
+         *
+         * \param index The row index.
+         *
+         * \param column The column subid.
+         *
+         * \return The value, or 0 if the row or the column does not exist
+         *         (or, for shared columns, if the value cannot be read).
+         *
+         * \exception None.
+         */
+        quint64 value(const Oid& index, quint32 column) const;
+
+        /**
+         * \internal
+         *
+         * \brief Serve a Get request for a cell.
+         *
+         * \param name The requested OID, which must be contained in the
+         *             subtree of the table.
+         *
+         * \return A varbind with the requested value, or with
+         *         Varbind::noSuchObject resp. Varbind::noSuchInstance if
+         *         the cell does not exist (see RFC 2741, 7.2.3.1).
+         *
+         * \exception generic_error If the value of a shared column cannot
+         *                          be read.
+         */
+        virtual Varbind get(const Oid& name);
+
+        /**
+         * \internal
+         *
+         * \brief Find the first cell following an OID.
+         *
+         * The cells are ordered as required by SNMP, i.e. column by column,
+         * and within each column row by row. See SubtreeHandler::next() for
+         * the parameters.
+         *
+         * \exception None.
+         */
+        virtual bool next(const Oid& starting_oid,
+                          const Oid& ending_oid,
+                          Oid& name,
+                          QSharedPointer<AbstractVariable>& var);
+
+    private:
+        /**
+         * \brief A column of the table.
+         *
+         * Depending on the column type, the values are held in values32 or
+         * in values64. The other vector stays empty. Both vectors are
+         * parallel to ColumnarTable::rows.
+         *
+         * For shared columns, region is set and both vectors stay empty.
+         */
+        struct Column
+        {
+            column_type_t type;
+            std::vector<quint32> values32;
+            std::vector<quint64> values64;
+            QSharedPointer<SharedStatsRegion> region;
+            quint32 offset;
+        };
+
+        /**
+         * \brief The table's OID.
+         */
+        Oid myOid;
+
+        /**
+         * \brief The table's OID with the \<entrySubOid\> appended.
+         *
+         * This is the common prefix of all cells.
+         */
+        Oid myEntryOid;
+
+        /**
+         * \brief The sorted row indexes.
+         *
+         * Position i in this vector corresponds to position i in the value
+         * vectors of each column.
+         */
+        std::vector<Oid> rows;
+
+        /**
+         * \brief The first slot of each row in the shared statistics
+         *        region (parallel to rows).
+         */
+        std::vector<quint32> row_slots;
+
+        /**
+         * \brief The columns, accessed by their subid.
+         */
+        std::map<quint32, Column> columns;
+
+        /**
+         * \brief Find the position of a row.
+         *
+         * \return The position, or -1 if the row does not exist.
+         */
+        int find_row(const Oid& index) const;
+
+        /**
+         * \brief Create a value object for a cell.
+         *
+         * The object is only used to build the response to the master
+         * agent. It is not stored by the table.
+         */
+        QSharedPointer<AbstractVariable> cell(const Column& column,
+                                              int row) const;
+};
+
+} /* namespace agentxcpp */
+#endif /* _COLUMNARTABLE_HPP_ */
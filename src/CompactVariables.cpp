@@ -0,0 +1,423 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#include <algorithm>
+
+#include "CompactVariables.hpp"
+#include "IntegerVariable.hpp"
+#include "Counter32Variable.hpp"
+#include "Counter64Variable.hpp"
+#include "Gauge32Variable.hpp"
+#include "TimeTicksVariable.hpp"
+#include "IpAddressVariable.hpp"
+#include "exceptions.hpp"
+
+using namespace agentxcpp;
+using namespace std;
+
+
+/**
+ * \brief Compare two sequences of subids like Oid::operator<() does.
+ *
+ * \return A negative value if a is less than b, 0 if both are equal, and a
+ *         positive value if a is greater than b.
+ */
+static int compare(const quint32* a, int alen, const quint32* b, int blen)
+{
+    int len = min(alen, blen);
+    for(int i = 0; i < len; i++)
+    {
+        if(a[i] != b[i])
+        {
+            return (a[i] < b[i]) ? -1 : 1;
+        }
+    }
+    // The shorter sequence is less than the other
+    return alen - blen;
+}
+
+
+bool CompactVariables::EntryLess::operator()(const Entry& a,
+                                             const Entry& b) const
+{
+    const quint32* p = &(*pool)[0];
+    return compare(p + a.offset, a.length, p + b.offset, b.length) < 0;
+}
+
+
+CompactVariables::CompactVariables(const Oid& oid)
+: myOid(oid),
+  sorted_count(0),
+  garbage(0)
+{
+}
+
+
+void CompactVariables::reserve(int count, int subids)
+{
+    entries.reserve(count);
+    pool.reserve(subids);
+}
+
+
+bool CompactVariables::add(const Oid& name,
+                           ColumnarTable::column_type_t type,
+                           quint64 value)
+{
+    switch(type)
+    {
+        case ColumnarTable::Integer:
+        case ColumnarTable::IpAddress:
+        case ColumnarTable::Counter32:
+        case ColumnarTable::Gauge32:
+        case ColumnarTable::TimeTicks:
+            value = static_cast<quint32>(value);
+            break;
+        case ColumnarTable::Counter64:
+            break;
+        default:
+            // Not a plain numeric type
+            throw(inval_param());
+    }
+
+    if(    ! myOid.contains(name)
+        || name.size() == myOid.size()
+        || name.size() - myOid.size() > 255 )
+    {
+        // Not within the subtree, or too long
+        return false;
+    }
+
+    Entry entry;
+    entry.offset = pool.size();
+    entry.length = name.size() - myOid.size();
+    entry.type = type;
+    entry.value = value;
+    pool.insert(pool.end(), name.begin() + myOid.size(), name.end());
+
+    // Entries added in ascending order keep the vector sorted, so that
+    // sort() has nothing to do
+    bool in_order = (sorted_count == entries.size());
+    if(in_order && ! entries.empty())
+    {
+        const Entry& last = entries.back();
+        in_order = compare(&pool[last.offset], last.length,
+                           &pool[entry.offset], entry.length) < 0;
+    }
+    entries.push_back(entry);
+    if(in_order)
+    {
+        sorted_count = entries.size();
+    }
+
+    return true;
+}
+
+
+void CompactVariables::sort() const
+{
+    if(sorted_count == entries.size())
+    {
+        // Nothing added since the last sort
+        return;
+    }
+
+    // Sort the new entries and merge them with the old ones. Both
+    // algorithms are stable, so that entries with the same OID stay in the
+    // order they were added.
+    EntryLess less;
+    less.pool = &pool;
+    stable_sort(entries.begin() + sorted_count, entries.end(), less);
+    inplace_merge(entries.begin(), entries.begin() + sorted_count,
+                  entries.end(), less);
+
+    // Drop replaced entries, i.e. all but the last of equal entries
+    size_t w = 0;
+    for(size_t r = 0; r < entries.size(); r++)
+    {
+        if(r + 1 < entries.size() && ! less(entries[r], entries[r + 1]))
+        {
+            garbage += entries[r].length;
+            continue;
+        }
+        entries[w++] = entries[r];
+    }
+    entries.resize(w);
+    sorted_count = entries.size();
+
+    // Compact the pool if it is mostly unused
+    if(garbage > pool.size() / 2)
+    {
+        vector<quint32> compacted;
+        compacted.reserve(pool.size() - garbage);
+        vector<Entry>::iterator i;
+        for(i = entries.begin(); i != entries.end(); i++)
+        {
+            quint32 offset = compacted.size();
+            compacted.insert(compacted.end(),
+                             pool.begin() + i->offset,
+                             pool.begin() + i->offset + i->length);
+            i->offset = offset;
+        }
+        pool.swap(compacted);
+        garbage = 0;
+    }
+}
+
+
+size_t CompactVariables::search(const Oid& name, int pos,
+                                bool inclusive) const
+{
+    const quint32* key = name.constData() + pos;
+    int keylen = name.size() - pos;
+
+    // Binary search for the first entry not less than (resp. greater than)
+    // the key
+    size_t first = 0;
+    size_t count = entries.size();
+    while(count > 0)
+    {
+        size_t step = count / 2;
+        const Entry& e = entries[first + step];
+        int c = compare(&pool[e.offset], e.length, key, keylen);
+        if(c < 0 || (c == 0 && ! inclusive))
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+    return first;
+}
+
+
+int CompactVariables::find(const Oid& name) const
+{
+    if(! myOid.contains(name) || name.size() == myOid.size())
+    {
+        // Not within the subtree
+        return -1;
+    }
+
+    sort();
+    size_t pos = search(name, myOid.size(), true);
+    if(pos == entries.size())
+    {
+        return -1;
+    }
+    const Entry& e = entries[pos];
+    if(compare(&pool[e.offset], e.length,
+               name.constData() + myOid.size(),
+               name.size() - myOid.size()) != 0)
+    {
+        return -1;
+    }
+    return pos;
+}
+
+
+bool CompactVariables::has_object(const Oid& name) const
+{
+    if(! myOid.contains(name) || name.size() <= myOid.size() + 1)
+    {
+        // The object would be the subtree itself (or lie outside of it)
+        return false;
+    }
+
+    // The object's OID is the name without its last subid
+    Oid object = name;
+    object.resize(object.size() - 1);
+    int length = object.size() - myOid.size();
+
+    // The first entry not less than the object lies within it, if any does
+    sort();
+    size_t pos = search(object, myOid.size(), true);
+    if(pos == entries.size())
+    {
+        return false;
+    }
+    const Entry& e = entries[pos];
+    return e.length >= length
+        && compare(&pool[e.offset], length,
+                   object.constData() + myOid.size(), length) == 0;
+}
+
+
+bool CompactVariables::remove(const Oid& name)
+{
+    int pos = find(name);
+    if(pos == -1)
+    {
+        // No such instance
+        return false;
+    }
+
+    // The subids stay in the pool until it is compacted
+    garbage += entries[pos].length;
+    entries.erase(entries.begin() + pos);
+    sorted_count--;
+
+    return true;
+}
+
+
+void CompactVariables::clear()
+{
+    entries.clear();
+    pool.clear();
+    sorted_count = 0;
+    garbage = 0;
+}
+
+
+int CompactVariables::count() const
+{
+    sort();
+    return static_cast<int>(entries.size());
+}
+
+
+bool CompactVariables::setValue(const Oid& name, quint64 value)
+{
+    int pos = find(name);
+    if(pos == -1)
+    {
+        // No such instance
+        return false;
+    }
+
+    if(entries[pos].type != ColumnarTable::Counter64)
+    {
+        value = static_cast<quint32>(value);
+    }
+    entries[pos].value = value;
+
+    return true;
+}
+
+
+quint64 CompactVariables::value(const Oid& name) const
+{
+    int pos = find(name);
+    if(pos == -1)
+    {
+        // No such instance
+        return 0;
+    }
+    return entries[pos].value;
+}
+
+
+QSharedPointer<AbstractVariable> CompactVariables::variable(
+        const Entry& entry) const
+{
+    quint32 v = static_cast<quint32>(entry.value);
+
+    switch(entry.type)
+    {
+        case ColumnarTable::Integer:
+            return QSharedPointer<AbstractVariable>(
+                    new IntegerVariable(static_cast<qint32>(v)));
+        case ColumnarTable::Counter32:
+            return QSharedPointer<AbstractVariable>(new Counter32Variable(v));
+        case ColumnarTable::Gauge32:
+            return QSharedPointer<AbstractVariable>(new Gauge32Variable(v));
+        case ColumnarTable::TimeTicks:
+            return QSharedPointer<AbstractVariable>(new TimeTicksVariable(v));
+        case ColumnarTable::IpAddress:
+            return QSharedPointer<AbstractVariable>(
+                    new IpAddressVariable(v >> 24 & 0xff,
+                                          v >> 16 & 0xff,
+                                          v >> 8 & 0xff,
+                                          v >> 0 & 0xff));
+        case ColumnarTable::Counter64:
+        default:
+            return QSharedPointer<AbstractVariable>(
+                    new Counter64Variable(entry.value));
+    }
+}
+
+
+Varbind CompactVariables::get(const Oid& name)
+{
+    int pos = find(name);
+    if(pos == -1)
+    {
+        if(has_object(name))
+        {
+            // Known object, but unknown instance
+            return Varbind(name, Varbind::noSuchInstance);
+        }
+        // Unknown object
+        return Varbind(name, Varbind::noSuchObject);
+    }
+    return Varbind(name, variable(entries[pos]));
+}
+
+
+bool CompactVariables::next(const Oid& start,
+                            const Oid& /* ending_oid */,
+                            Oid& name,
+                            QSharedPointer<AbstractVariable>& var)
+{
+    sort();
+
+    size_t pos;
+    if(start < myOid)
+    {
+        // start precedes the subtree: first instance is the answer
+        pos = 0;
+    }
+    else if(myOid.contains(start))
+    {
+        if(start.size() == myOid.size())
+        {
+            // start is the subtree's OID: first instance is the answer
+            pos = 0;
+        }
+        else
+        {
+            pos = search(start, myOid.size(), start.include());
+        }
+    }
+    else
+    {
+        // start is behind the subtree
+        return false;
+    }
+
+    if(pos == entries.size())
+    {
+        // No instance left
+        return false;
+    }
+
+    const Entry& e = entries[pos];
+    name = myOid;
+    for(int i = 0; i < e.length; i++)
+    {
+        name.push_back(pool[e.offset + i]);
+    }
+    var = variable(e);
+
+    return true;
+}
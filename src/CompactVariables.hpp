@@ -0,0 +1,318 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#ifndef _COMPACTVARIABLES_HPP_
+#define _COMPACTVARIABLES_HPP_
+
+#include <vector>
+
+#include <QtGlobal>
+#include <QSharedPointer>
+
+#include "Oid.hpp"
+#include "AbstractVariable.hpp"
+#include "Varbind.hpp"
+#include "SubtreeHandler.hpp"
+#include "ColumnarTable.hpp"
+
+
+namespace agentxcpp
+{
+
+/**
+ * \brief A compact store for many read-mostly scalar variables.
+ *
+ * Each variable added with MasterProxy::add_variable() costs a node of the
+ * MasterProxy's variable map, the heap-allocated subids of its Oid, the
+ * control block of its QSharedPointer and the variable object itself. For
+ * agents serving hundreds of thousands of instances, this overhead dominates
+ * the memory footprint.
+ *
+ * The CompactVariables class stores the instances of a subtree in a single
+ * sorted array. Each instance needs 16 bytes plus 4 bytes per subid of its
+ * OID (relative to the subtree's OID). The subids of all instances are kept
+ * in one shared pool (the benchmark bench/instance_memory.cpp reports the
+ * resident bytes per instance of both approaches). Variable objects are
+ * only created temporarily while a request is answered, like for the
+ * ColumnarTable. The store is a SubtreeHandler which is added to the
+ * MasterProxy as a whole:
+ * \code
+ * QSharedPointer<CompactVariables> store(new CompactVariables(subtree));
+ * store->add(Oid(subtree, "1.0"), ColumnarTable::Counter32, 0);
+ * store->add(Oid(subtree, "2.0"), ColumnarTable::Gauge32, 42);
+ * master.add_subtree_handler(store->oid(), store);
+ * \endcode
+ *
+ * The instances must have a plain numeric type (see
+ * ColumnarTable::column_type_t). They are read-only; Set requests for them
+ * are refused with notWritable.
+ *
+ * Adding an instance is cheap: it is appended to the array, which is sorted
+ * when the store is accessed the next time. Thus, bulk-loading many
+ * instances costs O(n log n) in total. Changing a value needs a binary
+ * search. Removing an instance is O(n) and therefore should be rare.
+ *
+ * \note The store is not protected against concurrent access. Like for the
+ *       other variable types, values should be changed from within the
+ *       thread running the QApplication event loop.
+ */
+class CompactVariables : public SubtreeHandler
+{
+    public:
+        /**
+         * \brief Constructor.
+         *
+         * Create an empty store.
+         *
+         * \param oid The OID of the subtree containing the instances.
+         *
+         * \exception None.
+         */
+        CompactVariables(const Oid& oid);
+
+        /**
+         * \brief Get the OID of the subtree.
+         *
+         * \exception None.
+         */
+        Oid oid() const
+        {
+            return myOid;
+        }
+
+        /**
+         * \brief Reserve memory in advance.
+         *
+         * Avoids reallocations (and the temporary doubling of memory)
+         * while a known number of instances is added.
+         *
+         * \param count The expected number of instances.
+         *
+         * \param subids The expected total number of subids of the
+         *               instances' OID's, relative to the subtree's OID.
+         *
+         * \exception None.
+         */
+        void reserve(int count, int subids);
+
+        /**
+         * \brief Add an instance.
+         *
+         * If an instance with the same OID exists, it is replaced.
+         *
+         * \param name The OID of the instance. It must lie within the
+         *             subtree and have at most 255 subids more than the
+         *             subtree's OID.
+         *
+         * \param type The type of the instance.
+         *
+         * \param value The initial value (see setValue()).
+         *
+         * \return true on success, false if the name does not lie within
+         *         the subtree or is too long.
+         *
+         * \exception inval_param If the type is unknown.
+         */
+        bool add(const Oid& name, ColumnarTable::column_type_t type,
+                 quint64 value = 0);
+
+        /**
+         * \brief Remove an instance.
+         *
+         * \return true on success, false if the instance does not exist.
+         *
+         * \exception None.
+         */
+        bool remove(const Oid& name);
+
+        /**
+         * \brief Remove all instances.
+         *
+         * \exception None.
+         */
+        void clear();
+
+        /**
+         * \brief Check whether an instance exists.
+         *
+         * \exception None.
+         */
+        bool contains(const Oid& name) const
+        {
+            return find(name) != -1;
+        }
+
+        /**
+         * \brief Get the number of instances.
+         *
+         * \exception None.
+         */
+        int count() const;
+
+        /**
+         * \brief Set the value of an instance.
+         *
+         * The value is truncated to the width of the instance's type, as
+         * described for ColumnarTable::setValue().
+         *
+         * \return true on success, false if the instance does not exist.
+         *
+         * \exception None.
+         */
+        bool setValue(const Oid& name, quint64 value);
+
+        /**
+         * \brief Get the value of an instance.
+         *
+         * \return The value, or 0 if the instance does not exist.
+         *
+         * \exception None.
+         */
+        quint64 value(const Oid& name) const;
+
+        /**
+         * \internal
+         *
+         * \brief Serve a Get request for an instance.
+         *
+         * \return A varbind with the requested value. If the instance
+         *         does not exist, the varbind has Varbind::noSuchInstance
+         *         if an instance of the same object exists (see
+         *         has_object()), and Varbind::noSuchObject otherwise.
+         *
+         * \exception None.
+         */
+        virtual Varbind get(const Oid& name);
+
+        /**
+         * \internal
+         *
+         * \brief Find the first instance following an OID.
+         *
+         * See SubtreeHandler::next() for the parameters.
+         *
+         * \exception None.
+         */
+        virtual bool next(const Oid& starting_oid,
+                          const Oid& ending_oid,
+                          Oid& name,
+                          QSharedPointer<AbstractVariable>& var);
+
+    private:
+        /**
+         * \brief An instance.
+         *
+         * The subids of the instance's OID, without the subtree's OID, are
+         * pool[offset] to pool[offset+length-1]. The value is stored with
+         * 64 bits regardless of the type.
+         */
+        struct Entry
+        {
+            quint32 offset;
+            quint8 length;
+            quint8 type;
+            quint64 value;
+        };
+
+        /**
+         * \brief Orders entries by the subids they refer to.
+         */
+        struct EntryLess
+        {
+            const std::vector<quint32>* pool;
+            bool operator()(const Entry& a, const Entry& b) const;
+        };
+
+        /**
+         * \brief The OID of the subtree.
+         */
+        Oid myOid;
+
+        /**
+         * \brief The instances.
+         *
+         * The vector is sorted by OID, except for the entries starting at
+         * position sorted_count, which were added since the last sort.
+         */
+        mutable std::vector<Entry> entries;
+
+        /**
+         * \brief The subids of all instances.
+         */
+        mutable std::vector<quint32> pool;
+
+        /**
+         * \brief The number of sorted entries at the beginning of entries.
+         */
+        mutable std::size_t sorted_count;
+
+        /**
+         * \brief The number of unused subids in the pool.
+         *
+         * Subids become unused when an instance is removed or replaced.
+         */
+        mutable std::size_t garbage;
+
+        /**
+         * \brief Sort the entries and drop replaced ones.
+         *
+         * The pool is compacted if more than half of it is unused.
+         */
+        void sort() const;
+
+        /**
+         * \brief Find the first entry which is not less than (or, if
+         *        inclusive is false, greater than) the suffix of name
+         *        starting at position pos.
+         *
+         * The entries must be sorted.
+         */
+        std::size_t search(const Oid& name, int pos, bool inclusive) const;
+
+        /**
+         * \brief Find the position of an instance.
+         *
+         * \return The position, or -1 if the instance does not exist.
+         */
+        int find(const Oid& name) const;
+
+        /**
+         * \brief Check whether an OID lies within an object which has
+         *        instances.
+         *
+         * The store does not know the objects of its instances. The
+         * object of an OID is taken to be the OID without its last subid
+         * (e.g. the scalar object of a ".0" instance, or the column of a
+         * table with a single index subid), and it exists if an instance
+         * lies within it. An object which would be the subtree itself
+         * does not exist.
+         */
+        bool has_object(const Oid& name) const;
+
+        /**
+         * \brief Create a value object for an instance.
+         *
+         * The object is only used to build the response to the master
+         * agent. It is not stored.
+         */
+        QSharedPointer<AbstractVariable> variable(const Entry& entry) const;
+};
+
+} /* namespace agentxcpp */
+#endif /* _COMPACTVARIABLES_HPP_ */
@@ -0,0 +1,295 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#include "Connector.hpp"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <errno.h>
+#include <cstring>
+#include <vector>
+
+#include <QMutexLocker>
+
+#include "Trace.hpp"
+
+using namespace agentxcpp;
+
+
+Connector::Connector(unsigned timeout)
+: QObject(),
+  m_timeout(timeout),
+  m_stats(0)
+{
+    // We want to deliver this type within a signal:
+    qRegisterMetaType< QSharedPointer<PDU> >("QSharedPointer<PDU>");
+}
+
+
+Connector::~Connector()
+{
+}
+
+
+bool Connector::dispatch(const binary& buf)
+{
+    // Parse PDU
+    QSharedPointer<PDU> pdu;
+    try
+    {
+        pdu = PDU::parse_pdu(buf);
+    }
+    catch(version_error)
+    {
+        if(m_stats) m_stats->record_parse_error();
+        return false;
+    }
+    catch(parse_error)
+    {
+        if(m_stats) m_stats->record_parse_error();
+        return false;
+    }
+    AGENTXCPP_TRACE(parsed, pdu->get_packetID(), pdu->get_transactionID(),
+                    buf[1], trace_varbind_count(*pdu));
+
+    // Special case: ResponsePDU's
+    QSharedPointer<ResponsePDU> response;
+    response = qSharedPointerDynamicCast<ResponsePDU>(pdu);
+    if(response)
+    {
+        m_response_mutex.lock();
+        // Was a response
+        std::map< quint32, QSharedPointer<ResponsePDU> >::iterator i;
+        i = this->m_responses.find( response->get_packetID() );
+        if(i != this->m_responses.end())
+        {
+            // Someone is waiting for this response
+            i->second = response;
+            m_response_mutex.unlock();
+            m_response_arrived.wakeAll();
+        }
+        else
+        {
+            // Nobody was waiting for the response
+            // -> ignore it
+            m_response_mutex.unlock();
+        }
+    }
+    else
+    {
+        // Was not a Response
+        // -> pass it on (the MasterProxy decrements the queue depth)
+        if(m_stats) m_stats->add_receive_queue(1);
+        deliver(pdu);
+    }
+
+    return true;
+}
+
+
+void Connector::deliver(QSharedPointer<PDU> pdu)
+{
+    emit pduArrived(pdu);
+}
+
+
+bool Connector::poll(unsigned)
+{
+    return false;
+}
+
+
+bool Connector::wait_for_response(unsigned timeout)
+{
+    if(file_descriptor() == -1)
+    {
+        // The I/O thread wakes us
+        return m_response_arrived.wait(&m_response_mutex, timeout);
+    }
+
+    // Nobody else reads the socket: do it ourselves. dispatch() needs
+    // the mutex.
+    m_response_mutex.unlock();
+    bool received = poll(timeout);
+    m_response_mutex.lock();
+    return received;
+}
+
+
+void Connector::wake_waiters()
+{
+    m_response_mutex.lock();
+    m_response_arrived.wakeAll();
+    m_response_mutex.unlock();
+}
+
+
+void Connector::write_segments(int fd, const SegmentedBuffer& data,
+                               int& segment, int& offset)
+{
+    while(segment < data.count())
+    {
+        // Collect the remaining segments (at most IOV_MAX)
+        std::vector<struct iovec> iov;
+        for(int i = segment; i < data.count() &&
+                    iov.size() < static_cast<size_t>(IOV_MAX); i++)
+        {
+            const SegmentedBuffer::Segment& s = data.segment(i);
+            struct iovec v;
+            v.iov_base = const_cast<char*>(s.data);
+            v.iov_len = s.size;
+            if(i == segment)
+            {
+                v.iov_base = static_cast<char*>(v.iov_base) + offset;
+                v.iov_len -= offset;
+            }
+            iov.push_back(v);
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov[0];
+        msg.msg_iovlen = iov.size();
+        ssize_t written;
+        do
+        {
+            written = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        }
+        while(written == -1 && errno == EINTR);
+        if(written <= 0)
+        {
+            // Socket buffer full (or error)
+            return;
+        }
+
+        // Skip the written bytes
+        while(written > 0)
+        {
+            int left = data.segment(segment).size - offset;
+            if(written < left)
+            {
+                offset += written;
+                written = 0;
+            }
+            else
+            {
+                written -= left;
+                segment++;
+                offset = 0;
+            }
+        }
+        if(segment < data.count() && offset != 0)
+        {
+            // Partial write: the socket buffer is full
+            return;
+        }
+    }
+}
+
+
+QSharedPointer<ResponsePDU> Connector::request(QSharedPointer<PDU> pdu)
+{
+    m_response_mutex.lock();
+    m_responses[pdu->get_packetID()] = QSharedPointer<ResponsePDU>();
+    send(pdu);
+
+    while ( ! (m_responses[pdu->get_packetID()]) )
+    {
+        if(! is_connected())
+        {
+            // The response will never arrive
+            m_responses.erase(pdu->get_packetID());
+            m_response_mutex.unlock();
+            throw(disconnected());
+        }
+        if(! wait_for_response(m_timeout)
+           && ! m_responses[pdu->get_packetID()])
+        {
+            m_responses.erase(pdu->get_packetID());
+            m_response_mutex.unlock();
+            throw(timeout_error());
+        }
+    }
+
+    QSharedPointer<ResponsePDU> response = m_responses[pdu->get_packetID()];
+    m_responses.erase(m_responses.find(pdu->get_packetID()));
+    m_response_mutex.unlock();
+
+    return response;
+}
+
+
+
+QList< QSharedPointer<ResponsePDU> >
+Connector::request_batch(const QList< QSharedPointer<PDU> >& pdus)
+{
+    QMutexLocker locker(&m_response_mutex);
+
+    // Send all PDU's
+    for(int i = 0; i < pdus.size(); i++)
+    {
+        m_responses[pdus[i]->get_packetID()] = QSharedPointer<ResponsePDU>();
+        send(pdus[i]);
+    }
+
+    // Wait for the responses. They usually arrive in order, so the search
+    // for the first missing response continues where it stopped last time.
+    int missing = 0;
+    while(missing < pdus.size())
+    {
+        if(m_responses[pdus[missing]->get_packetID()])
+        {
+            missing++;
+            continue;
+        }
+        if(! is_connected())
+        {
+            // The responses will never arrive
+            for(int i = 0; i < pdus.size(); i++)
+            {
+                m_responses.erase(pdus[i]->get_packetID());
+            }
+            throw(disconnected());
+        }
+        if(! wait_for_response(m_timeout)
+           && ! m_responses[pdus[missing]->get_packetID()])
+        {
+            // No progress: give up
+            for(int i = 0; i < pdus.size(); i++)
+            {
+                m_responses.erase(pdus[i]->get_packetID());
+            }
+            throw(timeout_error());
+        }
+    }
+
+    // Collect the responses
+    QList< QSharedPointer<ResponsePDU> > result;
+    for(int i = 0; i < pdus.size(); i++)
+    {
+        std::map< quint32, QSharedPointer<ResponsePDU> >::iterator r;
+        r = m_responses.find(pdus[i]->get_packetID());
+        result.append(r->second);
+        m_responses.erase(r);
+    }
+
+    return result;
+}
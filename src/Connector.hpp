@@ -0,0 +1,434 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#ifndef _CONNECTOR_HPP_
+#define _CONNECTOR_HPP_
+
+#include <map>
+
+#include <QSharedPointer>
+#include <QObject>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QList>
+
+#include "PDU.hpp"
+#include "ResponsePDU.hpp"
+#include "SegmentedBuffer.hpp"
+#include "AgentStatistics.hpp"
+
+
+namespace agentxcpp
+{
+    /**
+     * \internal
+     *
+     * \brief The interface of the classes connecting a MasterProxy to the 
+     *        master agent.
+     *
+     * A connector transports %PDU's over a unix domain socket. The 
+     * MasterProxy uses the following services:
+     * - Methods to connect and disconnect, and a method to obtain the 
+     *   current state,
+     * - The pduArrived() signal, which is emitted for each arriving %PDU 
+     *   except ResponsePDU's,
+     * - A request service which sends a PDU and then blocks until the 
+     *   corresponding ResponsePDU arrived (request() and request_batch()),
+     * - A send service which just sends a PDU,
+     * - Keepalive and automatic reconnect.
+     *
+     * The backends differ in how the socket is driven: 
+     * UnixDomainConnector uses a QLocalSocket in a thread running a Qt 
+     * event loop, while EpollConnector uses a non-blocking socket and 
+     * epoll, either in its own I/O thread or driven by the application.
+     *
+     * \par Sending and Receiving PDU's
+     *
+     * This class implements the request service for all backends. Received 
+     * %PDU's are passed to dispatch() by the backend. ResponsePDU's are 
+     * transmitted to the waiting threads via the m_responses map, which 
+     * assigns a packetID a ResponsePDU. Each time a request is sent, an 
+     * entry is added to the map with the packetID of the request and a 
+     * NULL ResponsePDU (i.e. a NULL pointer). This entry indicates that a 
+     * ResponsePDU with the same packetID is awaited. dispatch() then adds 
+     * the ResponsePDU to the map, when it arrived. However, when a 
+     * ResponsePDU arrives which is \e not awaited, it is discarded. All 
+     * other %PDU's are forwarded using the pduArrived() signal.
+     */
+    class Connector : public QObject
+    {
+        Q_OBJECT
+
+        protected:
+	    /**
+	     * \brief The timeout in milliseconds.
+	     */
+	    unsigned m_timeout;
+
+            /**
+             * \brief The statistics to update, or 0.
+             */
+            AgentStatistics* m_stats;
+
+            /**
+             * \brief Parse a received %PDU and pass it on.
+             *
+             * ResponsePDU's are handed to the thread waiting for them (or 
+             * discarded if nobody waits), all other %PDU's are passed to 
+             * deliver().
+             *
+             * \param buf The %PDU, including its header.
+             *
+             * \return false if the %PDU could not be parsed. The caller 
+             *         should stop processing the received data then.
+             */
+            bool dispatch(const binary& buf);
+
+            /**
+             * \brief Wake all threads waiting in request() or 
+             *        request_batch().
+             *
+             * Called by the backends when the connection is lost, so that 
+             * the waiting threads notice it.
+             */
+            void wake_waiters();
+
+            /**
+             * \brief Write a serialized %PDU to a non-blocking socket.
+             *
+             * The segments of data are written in as few sendmsg() calls as 
+             * possible (i.e. one, unless there are more than IOV_MAX 
+             * segments), starting at the given position. The position is 
+             * advanced behind the written bytes. Writing stops when the 
+             * socket buffer is full or an error occurs.
+             *
+             * \param fd The socket.
+             *
+             * \param data The %PDU.
+             *
+             * \param segment The segment of the first byte not yet written.
+             *
+             * \param offset The offset of that byte within its segment.
+             */
+            static void write_segments(int fd, const SegmentedBuffer& data,
+                                       int& segment, int& offset);
+
+            /**
+             * \brief Pass a received %PDU (except ResponsePDU's) on.
+             *
+             * Called by dispatch(). This implementation emits 
+             * pduArrived().
+             */
+            virtual void deliver(QSharedPointer<PDU> pdu);
+
+            /**
+             * \brief Read from the socket while request() or 
+             *        request_batch() wait for responses.
+             *
+             * Only called for connectors driven by the application (see 
+             * file_descriptor()), because nobody else reads the socket 
+             * while the application's thread waits. Received %PDU's are 
+             * passed to dispatch().
+             *
+             * \param timeout The maximum time to wait for data, in 
+             *                milliseconds.
+             *
+             * \return false if nothing happened within the timeout.
+             */
+            virtual bool poll(unsigned timeout);
+
+        private:
+            /**
+             * \brief Storage for ResponsePDU's.
+             *
+             * This map contains entries with packetID as key and 
+             * %ResponsePDU's as values. An entry with a NULL pointer value 
+             * means that a %ResponsePDU with the given packetID is awaited.
+             *
+             * This member is protected by m_response_mutex.
+             */
+	    std::map< quint32, QSharedPointer<ResponsePDU> > m_responses;
+
+            /**
+             * \brief Used to protect m_responses and for m_response_arrived.
+             */
+	    QMutex m_response_mutex;
+
+            /**
+             * \brief A waitcondition to inform waiters of ResponsePDU's.
+             *
+             * The m_response_mutex is used for synchronization.
+             */
+	    QWaitCondition m_response_arrived;
+
+            /**
+             * \brief Wait until a ResponsePDU arrived.
+             *
+             * Waits on m_response_arrived or, for connectors driven by the 
+             * application, reads from the socket using poll(). Must be 
+             * called with m_response_mutex locked.
+             *
+             * \return false if nothing arrived within the timeout.
+             */
+            bool wait_for_response(unsigned timeout);
+
+	signals:
+	    /**
+	     * \brief Emitted when a PDU arrived.
+             *
+             * This signal is emitted once for every arrived PDU, except for 
+             * %ResponsePDU's.
+	     */
+	    void pduArrived(QSharedPointer<PDU>);
+
+	    /**
+	     * \brief Emitted when the connection to the master agent was 
+	     *        lost.
+	     */
+	    void connectionLost();
+
+	    /**
+	     * \brief Emitted when the socket was connected again by the 
+	     *        automatic reconnect.
+	     *
+	     * The receiver is expected to open a new session. If that fails, 
+	     * it calls reconnectFailed().
+	     */
+	    void reconnected();
+
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * \param timeout The timeout, in milliseconds, used for 
+             *                connecting, disconnecting, sending and 
+             *                receiving %PDU's.
+             */
+            Connector(unsigned timeout);
+
+            /**
+             * \brief Destructor.
+             */
+            virtual ~Connector();
+
+            /**
+             * \brief Set the statistics to be updated by the connector.
+             *
+             * The connector counts the PDU's and bytes it transfers, the 
+             * PDU's which could not be parsed and the length of its queues.  
+             * This function must be called before the connector is 
+             * connected.
+             *
+             * \param stats The statistics, or 0 to disable counting. They 
+             *              must live longer than the connector.
+             */
+            void setStatistics(AgentStatistics* stats)
+            {
+                m_stats = stats;
+            }
+
+            /**
+             * \brief Connect to the remote entity.
+             *
+             * This function connects to the remote entity and starts receiving
+             * %PDU's.  If the object is already connected, the function does
+             * nothing.
+             *
+             * For the attempt to connect, the configured timeout is used.
+             *
+             * \return True on success (i.e. if the object is in connected
+             *         state), false otherwise.
+             */
+            virtual bool connect() = 0;
+
+            /**
+             * \brief Disconnect from the remote entity.
+             *
+             * Stops receiving %PDU's and disconnects the remote entity. The 
+             * object will be in disconnected state after this method.
+             */
+            virtual void disconnect() = 0;
+
+            /**
+	     * \brief Find out whether the object is currently connected.
+	     *
+	     * \return True if the object is connected, false otherwise.
+	     */
+	    virtual bool is_connected() = 0;
+
+            /**
+             * \brief Send a %PDU.
+             *
+             * The function may return before the PDU is actually sent. 
+             * PDU's sent while the connector is disconnected are discarded.
+             */
+	    virtual void send(QSharedPointer<PDU> pdu) = 0;
+
+            /**
+             * \brief Send a PDU and wait for the response.
+             *
+             * This method adds an entry to m_responses to indicate that a 
+             * ResponsePDU is awaited and sends the %PDU. Then, it waits 
+             * until that ResponsePDU arrives and returns it (it is removed 
+             * from m_responses).
+             *
+             * \exception disconnected If the connector is not connected, or 
+             *                         if the connection is lost while 
+             *                         waiting.
+             *
+             * \exception timeout_error If no response arrives for the 
+             *                          timeout given to the constructor.
+             */
+	    QSharedPointer<ResponsePDU> request(QSharedPointer<PDU> pdu);
+
+            /**
+             * \brief Send several PDU's and wait for all responses.
+             *
+             * Unlike calling request() for each %PDU, all PDU's are sent at 
+             * once, so that the master agent can process them while the 
+             * responses of the first ones travel back (pipelining). The 
+             * method returns when all responses arrived.
+             *
+             * \param pdus The PDU's to send. Their packetID's must be 
+             *             distinct.
+             *
+             * \return The responses, in the order of the PDU's.
+             *
+             * \exception disconnected See request().
+             *
+             * \exception timeout_error If no response arrives for the timeout 
+             *                          given to the constructor while 
+             *                          responses are outstanding.
+             */
+	    QList< QSharedPointer<ResponsePDU> >
+	    request_batch(const QList< QSharedPointer<PDU> >& pdus);
+
+            /**
+             * \brief Start sending PingPDU's to detect a dead master agent.
+             *
+             * When nothing was received from the master agent for the 
+             * given interval, a PingPDU is sent (RFC 2741, 7.1.11. 
+             * "Processing the agentx-Ping-PDU"). If nothing is received 
+             * within the given timeout after that, the master agent is 
+             * regarded as dead and the connection as lost (see 
+             * connectionLost()). A dead master agent is thus detected 
+             * within interval + timeout milliseconds.
+             *
+             * This function returns immediately.
+             *
+             * \param sessionID The session to ping.
+             *
+             * \param interval The idle time before a PingPDU is sent, in 
+             *                 milliseconds.
+             *
+             * \param timeout The time to wait for an answer, in 
+             *                milliseconds.
+             */
+            virtual void startKeepalive(quint32 sessionID,
+                                        unsigned interval,
+                                        unsigned timeout) = 0;
+
+            /**
+             * \brief Stop sending PingPDU's.
+             */
+            virtual void stopKeepalive() = 0;
+
+            /**
+             * \brief Reconnect automatically after a connection loss.
+             *
+             * If enabled, the connector tries to reconnect the socket after 
+             * a connection loss, first after min_delay milliseconds. The 
+             * delay is doubled after each failed attempt, up to max_delay 
+             * milliseconds. When the socket is connected, reconnected() is 
+             * emitted. Automatic reconnect is disabled by default.
+             *
+             * \param enabled Whether to reconnect automatically.
+             *
+             * \param min_delay The delay before the first attempt.
+             *
+             * \param max_delay The maximum delay between two attempts.
+             */
+            virtual void setAutoReconnect(bool enabled,
+                                          unsigned min_delay,
+                                          unsigned max_delay) = 0;
+
+            /**
+             * \brief Set the byte order of the sent PDU's.
+             *
+             * The OpenPDU and the ResponsePDU's are encoded in the given 
+             * byte order; the other PDU's always use big endian. By 
+             * default, big endian is used.
+             *
+             * \param big_endian Whether to use big endian.
+             */
+            virtual void setByteOrder(bool big_endian) = 0;
+
+            /**
+             * \brief Report that a new session could not be opened after 
+             *        reconnected() was emitted.
+             *
+             * The socket is closed again and the next reconnect attempt is 
+             * scheduled with the doubled delay.
+             */
+            virtual void reconnectFailed() = 0;
+
+            /**
+             * \brief The file descriptor to watch, if the connector is 
+             *        driven by the application.
+             *
+             * Such a connector has no I/O thread. Instead, the application 
+             * waits until the file descriptor becomes readable (or until 
+             * process_timeout() expired) and then calls process(). All 
+             * signals are then emitted in the application's thread.
+             *
+             * \return The file descriptor, or -1 if the connector runs its 
+             *         own I/O (which is the default).
+             */
+            virtual int file_descriptor()
+            {
+                return -1;
+            }
+
+            /**
+             * \brief The time after which process() must be called even if 
+             *        the file descriptor is not readable.
+             *
+             * \return The time in milliseconds, or -1 if no timer is 
+             *         pending.
+             */
+            virtual int process_timeout()
+            {
+                return -1;
+            }
+
+            /**
+             * \brief Perform the pending I/O without blocking.
+             *
+             * Only needed for connectors driven by the application (see 
+             * file_descriptor()).
+             */
+            virtual void process()
+            {
+            }
+    };
+
+}
+
+#endif /* _CONNECTOR_HPP_ */
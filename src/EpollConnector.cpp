@@ -0,0 +1,764 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#include "EpollConnector.hpp"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+
+#include <QMutexLocker>
+
+#include "util.hpp"
+#include "PingPDU.hpp"
+#include "Trace.hpp"
+
+using namespace agentxcpp;
+
+
+// The size of the chunks read from the socket
+static const size_t read_chunk = 4096;
+
+
+EpollConnector::EpollConnector(const std::string& unix_domain_socket,
+                               unsigned timeout,
+                               bool embedded)
+: Connector(timeout),
+  m_fd(-1),
+  m_stop(false),
+  m_filename(unix_domain_socket),
+  m_is_connected(false),
+  m_reset_input(false),
+  m_keepalive_interval(0),
+  m_keepalive_timeout(0),
+  m_keepalive_session(0),
+  m_ping_outstanding(false),
+  m_keepalive_due(0),
+  m_auto_reconnect(false),
+  m_backoff_min(1000),
+  m_backoff_max(60000),
+  m_backoff(1000),
+  m_reconnect_due(0),
+  m_loop(*this),
+  m_embedded(embedded),
+  m_waiting(0)
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(m_epoll == -1 || m_wakeup == -1)
+    {
+        if(m_epoll != -1) ::close(m_epoll);
+        if(m_wakeup != -1) ::close(m_wakeup);
+        throw(network_error());
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = m_wakeup;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &ev);
+}
+
+
+EpollConnector::~EpollConnector()
+{
+    stop_loop();
+
+    ::close(m_wakeup);
+    ::close(m_epoll);
+}
+
+
+void EpollConnector::stop_loop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stop = true;
+        m_is_connected = false;
+        close_socket();
+    }
+    if(! m_embedded)
+    {
+        wake();
+        m_loop.wait();
+    }
+}
+
+
+void EpollConnector::wake()
+{
+    quint64 one = 1;
+    ssize_t result = ::write(m_wakeup, &one, sizeof(one));
+    (void)result; // The counter can't overflow in practice
+}
+
+
+bool EpollConnector::open_socket()
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(m_filename.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    strcpy(address.sun_path, m_filename.c_str());
+
+    m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(m_fd == -1)
+    {
+        return false;
+    }
+
+    // Connect, waiting up to m_timeout if the master agent doesn't accept 
+    // the connection immediately
+    int result = ::connect(m_fd, reinterpret_cast<struct sockaddr*>(&address),
+                           sizeof(address));
+    if(result == -1 && (errno == EINPROGRESS || errno == EAGAIN))
+    {
+        struct pollfd p;
+        p.fd = m_fd;
+        p.events = POLLOUT;
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if(::poll(&p, 1, m_timeout) == 1
+           && getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0
+           && error == 0)
+        {
+            result = 0;
+        }
+    }
+    if(result == -1)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_pending.clear();
+    m_reset_input = true;
+    socket_opened();
+
+    return true;
+}
+
+
+void EpollConnector::socket_opened()
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.fd = m_fd;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_fd, &ev);
+}
+
+
+void EpollConnector::socket_closing()
+{
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, m_fd, 0);
+}
+
+
+void EpollConnector::close_socket()
+{
+    if(m_fd != -1)
+    {
+        socket_closing();
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_pending.clear();
+    m_keepalive_due = 0;
+    m_ping_outstanding = false;
+}
+
+
+void EpollConnector::update_events()
+{
+    if(m_fd == -1)
+    {
+        return;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    if( ! m_pending.empty() )
+    {
+        ev.events |= EPOLLOUT;
+    }
+    ev.data.fd = m_fd;
+    epoll_ctl(m_epoll, EPOLL_CTL_MOD, m_fd, &ev);
+}
+
+
+bool EpollConnector::connect()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if(m_is_connected)
+        {
+            return true;
+        }
+        close_socket();
+        if( ! open_socket() )
+        {
+            return false;
+        }
+        m_is_connected = true;
+        m_reconnect_due = 0;
+        if(m_keepalive_interval != 0)
+        {
+            m_keepalive_due = AgentStatistics::now()
+                              + quint64(m_keepalive_interval) * 1000;
+        }
+
+        // Does nothing if the thread is already running
+        if(! m_embedded)
+        {
+            m_loop.start();
+        }
+    }
+
+    // The I/O thread must wait for the new socket
+    wake();
+    return true;
+}
+
+
+void EpollConnector::disconnect()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_is_connected = false;
+        m_reconnect_due = 0;
+        close_socket();
+    }
+    wake();
+    wake_waiters();
+}
+
+
+bool EpollConnector::is_connected()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_is_connected;
+}
+
+
+void EpollConnector::send(QSharedPointer<PDU> pdu)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // The buffer is reused for each PDU (see m_send_buffer)
+    SegmentedBuffer& data = m_send_buffer;
+    pdu->serialize_to(data);
+    if(m_stats)
+    {
+        m_stats->record_sent(data.size());
+    }
+    AGENTXCPP_TRACE(serialized, pdu->get_packetID(), pdu->get_transactionID(),
+                    data.segment(0).data[1], trace_varbind_count(*pdu));
+    if(m_fd == -1)
+    {
+        // Not connected: discard the PDU
+        data.clear();
+        return;
+    }
+
+    // Write the segments directly to the socket. This is only done while 
+    // no data is pending; otherwise the data would overtake the pending 
+    // data.
+    int segment = 0;
+    int offset = 0;
+    bool was_pending = ! m_pending.empty();
+    if( ! was_pending )
+    {
+        write_segments(m_fd, data, segment, offset);
+    }
+
+    // Keep the rest until the socket is writable
+    for(; segment < data.count(); segment++)
+    {
+        const SegmentedBuffer::Segment& s = data.segment(segment);
+        m_pending.append(reinterpret_cast<const quint8*>(s.data) + offset,
+                         s.size - offset);
+        offset = 0;
+    }
+    AGENTXCPP_TRACE(written, pdu->get_packetID(), pdu->get_transactionID(),
+                    data.segment(0).data[1], trace_varbind_count(*pdu));
+    data.clear();
+
+    if( ! was_pending && ! m_pending.empty() )
+    {
+        // Let the I/O thread write the rest
+        update_events();
+    }
+}
+
+
+void EpollConnector::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while( m_fd != -1 && ! m_pending.empty() )
+    {
+        ssize_t written = ::send(m_fd, m_pending.data(), m_pending.size(),
+                                 MSG_NOSIGNAL);
+        if(written == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if(written <= 0)
+        {
+            // Socket buffer full (or error, which is detected by 
+            // receive())
+            break;
+        }
+        m_pending.erase(0, written);
+    }
+    update_events();
+}
+
+
+bool EpollConnector::begin_receive()
+{
+    if(m_reset_input)
+    {
+        // New connection: forget the data of the old one
+        m_input.clear();
+        m_reset_input = false;
+    }
+    if(m_fd == -1)
+    {
+        return false;
+    }
+
+    // The master agent is alive: the next PingPDU is due after the
+    // keepalive interval
+    if(m_keepalive_interval != 0)
+    {
+        m_ping_outstanding = false;
+        m_keepalive_due = AgentStatistics::now()
+                          + quint64(m_keepalive_interval) * 1000;
+    }
+    return true;
+}
+
+
+void EpollConnector::receive()
+{
+    bool lost = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if(! begin_receive())
+        {
+            return;
+        }
+
+        // Read everything available
+        while(true)
+        {
+            size_t size = m_input.size();
+            m_input.resize(size + read_chunk);
+            ssize_t n = ::read(m_fd, &m_input[size], read_chunk);
+            if(n > 0)
+            {
+                m_input.resize(size + n);
+                if(static_cast<size_t>(n) < read_chunk)
+                {
+                    // Nothing more available
+                    break;
+                }
+                continue;
+            }
+            m_input.resize(size);
+            if(n == -1 && errno == EINTR)
+            {
+                continue;
+            }
+            if(n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+
+            // Connection closed by the master agent, or error
+            lost = true;
+            break;
+        }
+    }
+
+    process_input(lost);
+}
+
+
+void EpollConnector::process_input(bool lost)
+{
+    AGENTXCPP_TRACE(receive, 0, 0, 0, m_input.size());
+
+    // Dispatch the complete PDU's (without holding m_mutex, see above)
+    size_t start = 0;
+    while(m_input.size() - start >= 20)
+    {
+        // Extract endianness flag and payload length
+        bool big_endian = ( m_input[start + 2] & (1<<4) ) ? true : false;
+        binary::const_iterator pos = m_input.begin() + start + 16;
+        quint32 payload_length = read32(pos, big_endian);
+        if( payload_length % 4 != 0 )
+        {
+            // payload length must be a multiple of 4!
+            // See RFC 2741, 6.1. "AgentX PDU Header"
+            // We don't know where next PDU starts within the byte stream,
+            // therefore we give up the connection.
+            m_input.clear();
+            start = 0;
+            lost = true;
+            break;
+        }
+        if(m_input.size() - start < 20 + payload_length)
+        {
+            // Payload did not completely arrive
+            break;
+        }
+
+        binary buf;
+        buf.assign(m_input, start, 20 + payload_length);
+        start += 20 + payload_length;
+        if(m_stats)
+        {
+            m_stats->record_received(buf.size());
+        }
+        if( ! dispatch(buf) )
+        {
+            // Skip the rest of the received data
+            start = m_input.size();
+            break;
+        }
+    }
+    m_input.erase(0, start);
+
+    if(lost)
+    {
+        connection_lost();
+    }
+}
+
+
+void EpollConnector::connection_lost()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if(! m_is_connected)
+        {
+            // Deliberate disconnect, or loss already handled
+            close_socket();
+            return;
+        }
+        m_is_connected = false;
+        close_socket();
+        if(m_auto_reconnect)
+        {
+            m_backoff = m_backoff_min;
+            m_reconnect_due = AgentStatistics::now()
+                              + quint64(m_backoff) * 1000;
+        }
+    }
+
+    // Wake threads waiting for responses. They notice that the connection
+    // is lost.
+    wake_waiters();
+
+    emit connectionLost();
+}
+
+
+void EpollConnector::keepalive()
+{
+    QSharedPointer<PingPDU> ping;
+    {
+        QMutexLocker locker(&m_mutex);
+        if(m_ping_outstanding)
+        {
+            // Nothing received since the last PingPDU was sent
+            locker.unlock();
+            connection_lost();
+            return;
+        }
+        ping = QSharedPointer<PingPDU>(new PingPDU);
+        ping->set_sessionID(m_keepalive_session);
+        m_ping_outstanding = true;
+        m_keepalive_due = AgentStatistics::now()
+                          + quint64(m_keepalive_timeout) * 1000;
+    }
+
+    // Send PingPDU (takes m_mutex)
+    send(ping);
+}
+
+
+void EpollConnector::schedule_reconnect()
+{
+    if(! m_auto_reconnect)
+    {
+        m_reconnect_due = 0;
+        return;
+    }
+    m_backoff = (m_backoff > m_backoff_max / 2) ? m_backoff_max
+                                                 : m_backoff * 2;
+    m_reconnect_due = AgentStatistics::now() + quint64(m_backoff) * 1000;
+}
+
+
+void EpollConnector::reconnect()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_reconnect_due = 0;
+        if(! m_auto_reconnect || m_is_connected)
+        {
+            return;
+        }
+
+        // Try to connect (blocks this thread only)
+        close_socket();
+        if( ! open_socket() )
+        {
+            schedule_reconnect();
+            return;
+        }
+        m_is_connected = true;
+    }
+
+    emit reconnected();
+}
+
+
+int EpollConnector::next_timeout()
+{
+    QMutexLocker locker(&m_mutex);
+    quint64 due = 0;
+    if(m_keepalive_due != 0)
+    {
+        due = m_keepalive_due;
+    }
+    if(m_reconnect_due != 0 && (due == 0 || m_reconnect_due < due))
+    {
+        due = m_reconnect_due;
+    }
+    if(due == 0)
+    {
+        return -1;
+    }
+    quint64 now = AgentStatistics::now();
+    return (due <= now) ? 0 : int((due - now + 999) / 1000);
+}
+
+
+bool EpollConnector::run_once(int timeout)
+{
+    const int max_events = 4;
+    struct epoll_event events[max_events];
+
+    int n = epoll_wait(m_epoll, events, max_events, timeout);
+    for(int i = 0; i < n; i++)
+    {
+        if(events[i].data.fd == m_wakeup)
+        {
+            // Reset the eventfd; the loop re-reads the configuration
+            quint64 value;
+            ssize_t result = ::read(m_wakeup, &value, sizeof(value));
+            (void)result;
+            continue;
+        }
+        if(events[i].events & EPOLLOUT)
+        {
+            flush();
+        }
+        if(events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+        {
+            receive();
+        }
+    }
+
+    run_timers();
+
+    return n > 0;
+}
+
+
+void EpollConnector::run_timers()
+{
+    quint64 now = AgentStatistics::now();
+    bool keepalive_due;
+    bool reconnect_due;
+    {
+        QMutexLocker locker(&m_mutex);
+        keepalive_due = m_keepalive_due != 0 && m_keepalive_due <= now;
+        reconnect_due = m_reconnect_due != 0 && m_reconnect_due <= now;
+    }
+    if(keepalive_due)
+    {
+        keepalive();
+    }
+    if(reconnect_due)
+    {
+        reconnect();
+    }
+}
+
+
+void EpollConnector::run()
+{
+    while(true)
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            if(m_stop)
+            {
+                return;
+            }
+        }
+        run_once(next_timeout());
+    }
+}
+
+
+int EpollConnector::file_descriptor()
+{
+    return m_embedded ? m_epoll : -1;
+}
+
+
+int EpollConnector::process_timeout()
+{
+    if(! m_deferred.isEmpty())
+    {
+        // The deferred PDU's are waiting
+        return 0;
+    }
+    return next_timeout();
+}
+
+
+void EpollConnector::process()
+{
+    run_once(0);
+
+    // Emit the PDU's received while a request was waiting, unless we are
+    // called by such a request
+    while(m_waiting == 0 && ! m_deferred.isEmpty())
+    {
+        emit pduArrived(m_deferred.takeFirst());
+    }
+}
+
+
+void EpollConnector::deliver(QSharedPointer<PDU> pdu)
+{
+    if(! m_embedded)
+    {
+        Connector::deliver(pdu);
+        return;
+    }
+
+    // Emitted by process() after the data was processed, see
+    // "Embedded Mode"
+    m_deferred.append(pdu);
+    if(m_waiting != 0)
+    {
+        // Make sure the application calls process() after the request
+        wake();
+    }
+}
+
+
+bool EpollConnector::poll(unsigned timeout)
+{
+    m_waiting++;
+    bool happened = run_once(timeout);
+    m_waiting--;
+    return happened;
+}
+
+
+void EpollConnector::startKeepalive(quint32 sessionID,
+                                    unsigned interval, unsigned timeout)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_keepalive_session = sessionID;
+        m_keepalive_interval = interval;
+        m_keepalive_timeout = timeout;
+        m_ping_outstanding = false;
+        if(interval != 0 && m_is_connected)
+        {
+            m_keepalive_due = AgentStatistics::now()
+                              + quint64(interval) * 1000;
+        }
+        else
+        {
+            m_keepalive_due = 0;
+        }
+    }
+    wake();
+}
+
+
+void EpollConnector::stopKeepalive()
+{
+    startKeepalive(0, 0, 0);
+}
+
+
+void EpollConnector::setAutoReconnect(bool enabled,
+                                      unsigned min_delay,
+                                      unsigned max_delay)
+{
+    QMutexLocker locker(&m_mutex);
+    m_auto_reconnect = enabled;
+    m_backoff_min = (min_delay == 0) ? 1 : min_delay;
+    m_backoff_max = (max_delay < m_backoff_min) ? m_backoff_min : max_delay;
+    if(! enabled)
+    {
+        m_reconnect_due = 0;
+    }
+}
+
+
+void EpollConnector::setByteOrder(bool big_endian)
+{
+    // Kept by m_send_buffer.clear()
+    QMutexLocker locker(&m_mutex);
+    m_send_buffer.setBigEndian(big_endian);
+}
+
+
+void EpollConnector::reconnectFailed()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_is_connected = false;
+        close_socket();
+        schedule_reconnect();
+    }
+    wake();
+}
@@ -0,0 +1,489 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#ifndef _EPOLLCONNECTOR_HPP_
+#define _EPOLLCONNECTOR_HPP_
+
+#include <string>
+
+#include <QThread>
+#include <QMutex>
+#include <QList>
+
+#include "Connector.hpp"
+
+
+namespace agentxcpp
+{
+    /**
+     * \internal
+     *
+     * \brief Connect to a unix domain socket using epoll.
+     *
+     * This class implements the Connector interface with a non-blocking 
+     * socket and epoll, without QLocalSocket and without a Qt event loop:
+     *
+     * - %PDU's are written to the socket directly from the thread calling 
+     *   send() (or request()). Only if the socket buffer is full, the rest 
+     *   is buffered and written by the I/O thread when the socket becomes 
+     *   writable.
+     * - An I/O thread waits in epoll_wait() for incoming data. It reads all 
+     *   available data in as few read() calls as possible into a buffer 
+     *   and passes the complete %PDU's to Connector::dispatch(). 
+     *   ResponsePDU's thus wake the requesting thread directly.
+     * - Connecting and disconnecting is done in the calling thread.
+     * - The keepalive and the automatic reconnect are driven by the 
+     *   timeout of epoll_wait().
+     *
+     * The %PDU's emitted with pduArrived() are still delivered to the 
+     * MasterProxy through a queued signal, because the MasterProxy 
+     * processes them in its own thread.
+     *
+     * \par Embedded Mode
+     *
+     * If the connector is created without an I/O thread, the application 
+     * drives it from its own event loop: it waits until the epoll instance 
+     * (see file_descriptor()) becomes readable or process_timeout() 
+     * expired, and then calls process(), which does one non-blocking 
+     * iteration of the loop. The signals are then emitted in the 
+     * application's thread, so that a MasterProxy living in that thread 
+     * handles the requests inline. The epoll instance is handed out 
+     * instead of the socket, because it stays the same when the socket is 
+     * reconnected.
+     *
+     * While request() or request_batch() wait for a response, they read 
+     * the socket themselves (see poll()). %PDU's other than ResponsePDU's 
+     * received meanwhile are kept in m_deferred and emitted by the next 
+     * process(), so that the MasterProxy never handles a request while it 
+     * waits for a response itself.
+     *
+     * \par Derived Classes
+     *
+     * Derived classes may replace the system calls used for the I/O (see 
+     * UringConnector). They override run_once(), send(), socket_opened() 
+     * and socket_closing(), and reuse the connection handling, the 
+     * keepalive and the reconnect of this class. The I/O thread is started 
+     * by the first connect(), so that it uses the overridden methods.
+     *
+     * \par Locking
+     *
+     * m_mutex protects the socket, the connection state, the send buffers 
+     * and the configuration. It is never held while dispatch() is called, 
+     * because dispatch() takes the response mutex of the Connector, which 
+     * is held by request() while it calls send(). Only the I/O thread 
+     * (or, in embedded mode, the application's thread) accesses m_input.
+     */
+    class EpollConnector : public Connector
+    {
+        protected:
+            /**
+             * \brief The socket, or -1 if not connected.
+             */
+            int m_fd;
+
+            /**
+             * \brief An eventfd which wakes the I/O thread, e.g. to apply 
+             *        a changed configuration.
+             */
+            int m_wakeup;
+
+            /**
+             * \brief Set by stop_loop() to stop the I/O thread.
+             */
+            bool m_stop;
+
+            /**
+             * \brief The received data not yet dispatched.
+             *
+             * Only accessed by the I/O thread.
+             */
+            binary m_input;
+
+            /**
+             * \brief The buffer into which send() serializes the PDU's.
+             *
+             * It is cleared after each PDU, but keeps its memory. Protected by 
+             * m_mutex.
+             */
+            SegmentedBuffer m_send_buffer;
+
+            /**
+             * \brief Protects the members (see \ref EpollConnector 
+             *        "Locking").
+             */
+            QMutex m_mutex;
+
+            /**
+             * \brief One iteration of the loop.
+             *
+             * Waits for events, handles them and runs the due timers. 
+             * Called by the I/O thread, or by process() and poll() in 
+             * embedded mode.
+             *
+             * \param timeout The maximum time to wait for events, in 
+             *                milliseconds, or -1 to wait forever.
+             *
+             * \return false if no event occurred.
+             */
+            virtual bool run_once(int timeout);
+
+            /**
+             * \brief The time until the next timer is due.
+             *
+             * \return The time in milliseconds, or -1 if no timer is 
+             *         pending.
+             */
+            int next_timeout();
+
+            /**
+             * \brief Wake the I/O thread.
+             */
+            void wake();
+
+            /**
+             * \brief Handle the loss of the connection.
+             *
+             * Closes the socket, wakes all threads waiting in request() or 
+             * request_batch(), emits connectionLost() and schedules a 
+             * reconnect attempt if enabled. Does nothing if the connector 
+             * is not connected. Called by the I/O thread.
+             */
+            void connection_lost();
+
+            /**
+             * \brief Stop the I/O thread and close the socket.
+             *
+             * Called by the destructor. Derived classes call it in their 
+             * destructor, because the I/O thread uses their members. It 
+             * may be called more than once.
+             */
+            void stop_loop();
+
+            /**
+             * \brief Start processing received data.
+             *
+             * Discards the data of a previous connection and restarts the 
+             * keepalive interval. Must be called with m_mutex locked before 
+             * data is appended to m_input.
+             *
+             * \return false if the socket is closed; the data must be 
+             *         dropped then.
+             */
+            bool begin_receive();
+
+            /**
+             * \brief Dispatch the complete %PDU's in m_input.
+             *
+             * Must be called without m_mutex locked (see \ref 
+             * EpollConnector "Locking").
+             *
+             * \param lost Whether the connection was closed by the master 
+             *             agent. connection_lost() is called then.
+             */
+            void process_input(bool lost);
+
+            /**
+             * \brief Run the due keepalive and reconnect timers.
+             *
+             * Called after each iteration of the loop.
+             */
+            void run_timers();
+
+            /**
+             * \brief Called when the socket was connected.
+             *
+             * This implementation adds the socket to the epoll instance. 
+             * Called with m_mutex locked.
+             */
+            virtual void socket_opened();
+
+            /**
+             * \brief Called before the socket is closed.
+             *
+             * This implementation removes the socket from the epoll 
+             * instance. Called with m_mutex locked.
+             */
+            virtual void socket_closing();
+
+        private:
+            /**
+             * \brief The I/O thread; runs EpollConnector::run().
+             */
+            class Loop : public QThread
+            {
+                public:
+                    /**
+                     * \brief Constructor.
+                     */
+                    Loop(EpollConnector& c) : connector(c) {}
+
+                protected:
+                    /**
+                     * \brief Run the loop of the connector.
+                     */
+                    virtual void run()
+                    {
+                        connector.run();
+                    }
+
+                private:
+                    /**
+                     * \brief The connector.
+                     */
+                    EpollConnector& connector;
+            };
+
+            /**
+             * \brief The path of the unix domain socket.
+             */
+            std::string m_filename;
+
+            /**
+             * \brief The epoll instance.
+             */
+            int m_epoll;
+
+            /**
+             * \brief Whether the object is currently connected.
+             */
+            bool m_is_connected;
+
+            /**
+             * \brief Set by connect() to make the I/O thread discard data 
+             *        received on a previous connection.
+             */
+            bool m_reset_input;
+
+            /**
+             * \brief Data which could not be written yet because the 
+             *        socket buffer was full.
+             */
+            binary m_pending;
+
+            /**
+             * \brief The keepalive interval in milliseconds, or 0 if the
+             *        keepalive is disabled.
+             */
+            unsigned m_keepalive_interval;
+
+            /**
+             * \brief The time to wait for the response to a PingPDU, in
+             *        milliseconds.
+             */
+            unsigned m_keepalive_timeout;
+
+            /**
+             * \brief The sessionID put into the PingPDU's.
+             */
+            quint32 m_keepalive_session;
+
+            /**
+             * \brief Whether a PingPDU was sent and nothing was received
+             *        since.
+             */
+            bool m_ping_outstanding;
+
+            /**
+             * \brief When the keepalive is due (see 
+             *        AgentStatistics::now()), or 0.
+             */
+            quint64 m_keepalive_due;
+
+            /**
+             * \brief Whether to reconnect automatically.
+             */
+            bool m_auto_reconnect;
+
+            /**
+             * \brief The delay before the first reconnect attempt, in
+             *        milliseconds.
+             */
+            unsigned m_backoff_min;
+
+            /**
+             * \brief The maximum delay between two reconnect attempts, in
+             *        milliseconds.
+             */
+            unsigned m_backoff_max;
+
+            /**
+             * \brief The delay before the next reconnect attempt, in
+             *        milliseconds.
+             */
+            unsigned m_backoff;
+
+            /**
+             * \brief When the next reconnect attempt is due (see 
+             *        AgentStatistics::now()), or 0.
+             */
+            quint64 m_reconnect_due;
+
+            /**
+             * \brief The I/O thread.
+             */
+            Loop m_loop;
+
+            /**
+             * \brief Whether the connector is driven by the application 
+             *        (see \ref EpollConnector "Embedded Mode").
+             */
+            bool m_embedded;
+
+            /**
+             * \brief The number of request() or request_batch() calls 
+             *        currently reading the socket in embedded mode.
+             */
+            int m_waiting;
+
+            /**
+             * \brief The %PDU's received while m_waiting was not 0, not yet 
+             *        emitted.
+             *
+             * Only used in embedded mode.
+             */
+            QList< QSharedPointer<PDU> > m_deferred;
+
+            /**
+             * \brief The main loop of the I/O thread.
+             */
+            void run();
+
+            /**
+             * \brief Open and connect the socket.
+             *
+             * Waits up to m_timeout milliseconds for the connection. Must be 
+             * called with m_mutex locked.
+             *
+             * \return true on success.
+             */
+            bool open_socket();
+
+            /**
+             * \brief Close the socket, discarding unsent data.
+             *
+             * Must be called with m_mutex locked.
+             */
+            void close_socket();
+
+            /**
+             * \brief Select the events epoll waits for.
+             *
+             * EPOLLOUT is only requested while m_pending is not empty. 
+             * Must be called with m_mutex locked.
+             */
+            void update_events();
+
+            /**
+             * \brief Read the available data and dispatch the complete 
+             *        %PDU's.
+             *
+             * Called by the I/O thread.
+             */
+            void receive();
+
+            /**
+             * \brief Write m_pending.
+             *
+             * Called by the I/O thread when the socket is writable.
+             */
+            void flush();
+
+            /**
+             * \brief Send a PingPDU, or detect a dead master agent.
+             *
+             * Called by the I/O thread when the keepalive is due.
+             */
+            void keepalive();
+
+            /**
+             * \brief Try to reconnect the socket.
+             *
+             * Called by the I/O thread when a reconnect attempt is due. On 
+             * success, reconnected() is emitted. Otherwise the next attempt 
+             * is scheduled.
+             */
+            void reconnect();
+
+            /**
+             * \brief Schedule the next reconnect attempt, doubling the
+             *        delay (up to m_backoff_max).
+             *
+             * Must be called with m_mutex locked.
+             */
+            void schedule_reconnect();
+
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * This constructor initializes the connector object to be in
+             * disconnected state. The I/O thread is started by connect(), 
+             * unless the connector is used in embedded mode.
+             *
+             * \param unix_domain_socket The path to the unix_domain_socket.
+             *
+             * \param timeout The timeout, in milliseconds, used for for
+             *                connecting and for waiting for responses.
+             *
+             * \param embedded Whether the application drives the 
+             *                 connector (see \ref EpollConnector 
+             *                 "Embedded Mode").
+             *
+             * \exception network_error If the epoll instance cannot be 
+             *                          created.
+             */
+            EpollConnector(const std::string& unix_domain_socket
+                                              = "/var/agentx/master",
+                           unsigned timeout = 1000,
+                           bool embedded = false);
+
+            /**
+             * \brief Destructor.
+             *
+             * Stops the I/O thread and closes the socket.
+             */
+            virtual ~EpollConnector();
+
+            // The Connector interface (documented there)
+            virtual bool connect();
+            virtual void disconnect();
+            virtual bool is_connected();
+            virtual void send(QSharedPointer<PDU> pdu);
+            virtual void startKeepalive(quint32 sessionID,
+                                        unsigned interval, unsigned timeout);
+            virtual void stopKeepalive();
+            virtual void setAutoReconnect(bool enabled,
+                                          unsigned min_delay,
+                                          unsigned max_delay);
+            virtual void setByteOrder(bool big_endian);
+            virtual void reconnectFailed();
+            virtual int file_descriptor();
+            virtual int process_timeout();
+            virtual void process();
+
+        protected:
+            // Hooks of the Connector (documented there)
+            virtual void deliver(QSharedPointer<PDU> pdu);
+            virtual bool poll(unsigned timeout);
+    };
+
+}
+
+#endif /* _EPOLLCONNECTOR_HPP_ */
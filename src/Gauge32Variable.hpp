@@ -22,7 +22,7 @@
 
 #include <QtGlobal>
 
-#include "AbstractVariable.hpp"
+#include "ScalarVariable.hpp"
 #include "exceptions.hpp"
 
 namespace agentxcpp
@@ -30,174 +30,32 @@ namespace agentxcpp
     /**
      * \brief Represents a Gauge32 as described in RFC 2741
      */
-    class Gauge32Variable : public AbstractVariable
+    class Gauge32Variable : public ScalarVariable<Gauge32Variable, quint32>
     {
-	protected:
-	    /**
-	     * \brief The value.
-	     *
-	     * According to RFC 2578, Gauge32 is a non-negative 32-bit 
-	     * number.
-	     */
-	    quint32 v;
-
-	private:
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::new_value
-             */
-            QSharedPointer<Gauge32Variable> new_value;
-
-
-	public:
-
-	    /**
-             * \brief Default Constructor.
-	     *
-	     * The value after creation is 0.
-	     */
-	    Gauge32Variable()
-   	    : v(0)
-	    {
-	    }
-
-	    /**
-	     * \internal
-             *
-             * \copydoc agentxcpp::IntegerVariable::IntegerVariable(binary::const_iterator&, const binary::const_iterator&, bool)
-	     *
-	     */
-	    Gauge32Variable(binary::const_iterator& pos,
-		    const binary::const_iterator& end,
-		    bool big_endian=true);
-
-	    /**
-	     * \internal
-	     *
-	     * \brief Encode the object as described in RFC 2741, section 5.4
-	     *
-	     * This function uses big endian.
-	     */
-	    virtual binary serialize() const;
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::setValue()
-             */
-            void setValue(quint32 _value)
-            {
-                v = _value;
-            }
-
-            /**
-             * \brief Get the current value.
-             *
-             * \return The value.
-             */
-            quint32 value()
-            {
-                return v;
-            }
-
-            /**
-             * \internal
-             *
-             * \copydoc agentxcpp::IntegerVariable::handle_get()
-             */
-            virtual void handle_get()
-            {
-                perform_get();
-            }
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::perform_get()
-             */
-            virtual void perform_get()
-            {
-            }
-
-            /**
-             * \internal
-             *
-             * \copydoc agentxcpp::IntegerVariable::handle_testset()
-             */
-            virtual testset_result_t handle_testset(QSharedPointer<AbstractVariable> _v)
-            {
-                new_value = qSharedPointerDynamicCast<Gauge32Variable>(_v);
-                if (new_value)
-                {
-                    // Type matches variable
-                    return perform_testset(new_value->value());
-                }
-                else
-                {
-                    // Wrong type
-                    return wrongType;
-                }
-
-            }
+        public:
 
             /**
-             * \brief Handle a TestSet request.
+             * \brief Constructor.
              *
-             * \copydoc agentxcpp::IntegerVariable::perform_testset()
-             */
-            virtual testset_result_t perform_testset(quint32 _v)
-            {
-                return noAccess;
-            }
-
-            /**
-             * \internal
-             *
-             * \copydoc agentxcpp::IntegerVariable::handle_cleanupset()
-             */
-            virtual void handle_cleanupset()
-            {
-                perform_cleanupset(new_value->value());
-            }
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::perform_cleanupset()
-             */
-            virtual void perform_cleanupset(quint32 _v)
-            {
-                return;
-            }
-
-            /**
-             * \internal
+             * \param _value The initial value (0 by default).
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_commitset()
-             */
-            virtual bool handle_commitset()
-            {
-                return perform_commitset(new_value->value());
-            }
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::perform_commitset()
+             * \exception None.
              */
-            virtual bool perform_commitset(quint32 _v)
+            Gauge32Variable(quint32 _value = 0)
+            : ScalarVariable<Gauge32Variable, quint32>(_value)
             {
-                return false;
             }
 
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_undoset()
-             */
-            virtual bool handle_undoset()
-            {
-                return perform_undoset(new_value->value());
-            }
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::perform_undoset()
+             * \copydoc agentxcpp::ScalarVariable::ScalarVariable(binary::const_iterator&, const binary::const_iterator&, bool)
              */
-            virtual bool perform_undoset(quint32 _v)
+            Gauge32Variable(binary::const_iterator& pos,
+                            const binary::const_iterator& end,
+                            bool big_endian=true)
+            : ScalarVariable<Gauge32Variable, quint32>(pos, end, big_endian)
             {
-                return false;
             }
 
             /**
@@ -219,8 +77,6 @@ namespace agentxcpp
                 oid.push_back(v);
                 return oid;
             }
-
-
     };
 }
 
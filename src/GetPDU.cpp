@@ -41,8 +41,6 @@ GetPDU::GetPDU(binary::const_iterator& pos,
 	    // include field of ending OID must be 0
 	    throw( parse_error() );
 	}
-
-	pos += 4;   // ignore empty "end" OidVariable
     }
 }
 	    
@@ -58,6 +56,9 @@ binary GetPDU::serialize() const
     for(i = sr.begin(); i < sr.end(); i++)
     {
 	serialized += OidVariable(*i).serialize();
+
+	// The ending OID is always the null OID
+	serialized += OidVariable(Oid()).serialize();
     }
 
     // Add header
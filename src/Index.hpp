@@ -0,0 +1,607 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#ifndef _INDEX_HPP_
+#define _INDEX_HPP_
+
+#include <QtGlobal>
+#include <QByteArray>
+
+#include "Oid.hpp"
+#include "exceptions.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \brief Placeholder for unused components of an Index.
+     *
+     * See Index for details.
+     */
+    struct NoIndex
+    {
+        /**
+         * \brief An empty value.
+         */
+        struct value_type
+        {
+        };
+
+        enum
+        {
+            is_none = 1,
+            implied = 0
+        };
+
+        /**
+         * \brief Encode nothing.
+         */
+        static void encode(const value_type&, Oid&)
+        {
+        }
+
+        /**
+         * \brief Decode nothing.
+         */
+        static bool decode(const Oid&, int&, value_type&)
+        {
+            return true;
+        }
+    };
+
+    /**
+     * \brief Index component for INTEGER (Integer32) index objects.
+     *
+     * Encoded as a single subid (RFC 2578, 7.7 "Mapping of the INDEX 
+     * clause"). Negative values are encoded as their two's complement.
+     */
+    struct Int32
+    {
+        typedef qint32 value_type;
+
+        enum
+        {
+            is_none = 0,
+            implied = 0
+        };
+
+        /**
+         * \brief Append the value to an index.
+         */
+        static void encode(const value_type& value, Oid& index)
+        {
+            index.push_back(static_cast<quint32>(value));
+        }
+
+        /**
+         * \brief Decode the value at position pos of an index.
+         *
+         * pos is advanced behind the value.
+         *
+         * \return false if the index is too short.
+         */
+        static bool decode(const Oid& index, int& pos, value_type& value)
+        {
+            if(pos >= index.size())
+            {
+                return false;
+            }
+            value = static_cast<qint32>(index[pos++]);
+            return true;
+        }
+    };
+
+    /**
+     * \brief Index component for Unsigned32, Gauge32 and TimeTicks index 
+     *        objects.
+     *
+     * Encoded as a single subid.
+     */
+    struct UInt32
+    {
+        typedef quint32 value_type;
+
+        enum
+        {
+            is_none = 0,
+            implied = 0
+        };
+
+        /**
+         * \copydoc Int32::encode()
+         */
+        static void encode(const value_type& value, Oid& index)
+        {
+            index.push_back(value);
+        }
+
+        /**
+         * \copydoc Int32::decode()
+         */
+        static bool decode(const Oid& index, int& pos, value_type& value)
+        {
+            if(pos >= index.size())
+            {
+                return false;
+            }
+            value = index[pos++];
+            return true;
+        }
+    };
+
+    /**
+     * \brief Index component for IpAddress index objects.
+     *
+     * The value is the address as 32-bit number with the first octet in the 
+     * most significant byte. It is encoded as four subids, one per octet.
+     */
+    struct IpAddr
+    {
+        typedef quint32 value_type;
+
+        enum
+        {
+            is_none = 0,
+            implied = 0
+        };
+
+        /**
+         * \copydoc Int32::encode()
+         */
+        static void encode(const value_type& value, Oid& index)
+        {
+            index.push_back(value >> 24 & 0xff);
+            index.push_back(value >> 16 & 0xff);
+            index.push_back(value >> 8 & 0xff);
+            index.push_back(value >> 0 & 0xff);
+        }
+
+        /**
+         * \brief Decode the value at position pos of an index.
+         *
+         * pos is advanced behind the value.
+         *
+         * \return false if the index is too short or contains a subid 
+         *         greater than 255.
+         */
+        static bool decode(const Oid& index, int& pos, value_type& value)
+        {
+            if(pos + 4 > index.size())
+            {
+                return false;
+            }
+            value = 0;
+            for(int i = 0; i < 4; i++)
+            {
+                if(index[pos] > 0xff)
+                {
+                    return false;
+                }
+                value = value << 8 | index[pos++];
+            }
+            return true;
+        }
+    };
+
+    /**
+     * \brief Index component for variable-length OCTET STRING index 
+     *        objects.
+     *
+     * Encoded as the length followed by one subid per octet.
+     */
+    struct String
+    {
+        typedef QByteArray value_type;
+
+        enum
+        {
+            is_none = 0,
+            implied = 0
+        };
+
+        /**
+         * \copydoc Int32::encode()
+         */
+        static void encode(const value_type& value, Oid& index)
+        {
+            index.push_back(value.size());
+            for(int i = 0; i < value.size(); i++)
+            {
+                index.push_back(static_cast<quint8>(value[i]));
+            }
+        }
+
+        /**
+         * \brief Decode the value at position pos of an index.
+         *
+         * pos is advanced behind the value.
+         *
+         * \return false if the index is too short or contains a subid 
+         *         greater than 255.
+         */
+        static bool decode(const Oid& index, int& pos, value_type& value)
+        {
+            if(pos >= index.size())
+            {
+                return false;
+            }
+            quint32 length = index[pos++];
+            if(length > static_cast<quint32>(index.size() - pos))
+            {
+                return false;
+            }
+            return decode_octets(index, pos, length, value);
+        }
+
+        /**
+         * \internal
+         *
+         * \brief Decode a given number of octets.
+         */
+        static bool decode_octets(const Oid& index, int& pos, int length,
+                                  value_type& value)
+        {
+            if(pos + length > index.size())
+            {
+                return false;
+            }
+            value.resize(length);
+            for(int i = 0; i < length; i++)
+            {
+                if(index[pos] > 0xff)
+                {
+                    return false;
+                }
+                value.data()[i] = static_cast<char>(index[pos++]);
+            }
+            return true;
+        }
+    };
+
+    /**
+     * \brief Index component for fixed-length OCTET STRING index objects.
+     *
+     * Used for objects with a SIZE restriction to exactly N octets (e.g. 
+     * MacAddress with N=6). Encoded as one subid per octet, without length.
+     *
+     * \exception inval_param encode() throws if the value does not have 
+     *                        exactly N octets.
+     */
+    template<int N>
+    struct FixedOctets
+    {
+        typedef QByteArray value_type;
+
+        enum
+        {
+            is_none = 0,
+            implied = 0
+        };
+
+        /**
+         * \copydoc Int32::encode()
+         */
+        static void encode(const value_type& value, Oid& index)
+        {
+            if(value.size() != N)
+            {
+                throw(inval_param());
+            }
+            for(int i = 0; i < N; i++)
+            {
+                index.push_back(static_cast<quint8>(value[i]));
+            }
+        }
+
+        /**
+         * \copydoc String::decode()
+         */
+        static bool decode(const Oid& index, int& pos, value_type& value)
+        {
+            return String::decode_octets(index, pos, N, value);
+        }
+    };
+
+    /**
+     * \brief Index component for OCTET STRING index objects with the 
+     *        IMPLIED keyword.
+     *
+     * Encoded as one subid per octet, without length. Such a component 
+     * must be the last one of an Index.
+     */
+    struct ImpliedString
+    {
+        typedef QByteArray value_type;
+
+        enum
+        {
+            is_none = 0,
+            implied = 1
+        };
+
+        /**
+         * \copydoc Int32::encode()
+         */
+        static void encode(const value_type& value, Oid& index)
+        {
+            for(int i = 0; i < value.size(); i++)
+            {
+                index.push_back(static_cast<quint8>(value[i]));
+            }
+        }
+
+        /**
+         * \brief Decode the remainder of an index, starting at pos.
+         *
+         * pos is advanced to the end of the index.
+         *
+         * \return false if the index contains a subid greater than 255.
+         */
+        static bool decode(const Oid& index, int& pos, value_type& value)
+        {
+            return String::decode_octets(index, pos, index.size() - pos,
+                                         value);
+        }
+    };
+
+    /**
+     * \brief Index component for OBJECT IDENTIFIER index objects.
+     *
+     * Encoded as the number of subids followed by the subids.
+     */
+    struct ObjectId
+    {
+        typedef Oid value_type;
+
+        enum
+        {
+            is_none = 0,
+            implied = 0
+        };
+
+        /**
+         * \copydoc Int32::encode()
+         */
+        static void encode(const value_type& value, Oid& index)
+        {
+            index.push_back(value.size());
+            index += value;
+        }
+
+        /**
+         * \copydoc Int32::decode()
+         */
+        static bool decode(const Oid& index, int& pos, value_type& value)
+        {
+            if(pos >= index.size())
+            {
+                return false;
+            }
+            quint32 length = index[pos++];
+            if(length > static_cast<quint32>(index.size() - pos))
+            {
+                return false;
+            }
+            value = Oid();
+            for(quint32 i = 0; i < length; i++)
+            {
+                value.push_back(index[pos++]);
+            }
+            return true;
+        }
+    };
+
+    /**
+     * \brief Index component for OBJECT IDENTIFIER index objects with the 
+     *        IMPLIED keyword.
+     *
+     * Encoded as the subids, without length. Such a component must be the 
+     * last one of an Index.
+     */
+    struct ImpliedObjectId
+    {
+        typedef Oid value_type;
+
+        enum
+        {
+            is_none = 0,
+            implied = 1
+        };
+
+        /**
+         * \copydoc Int32::encode()
+         */
+        static void encode(const value_type& value, Oid& index)
+        {
+            index += value;
+        }
+
+        /**
+         * \brief Decode the remainder of an index, starting at pos.
+         *
+         * pos is advanced to the end of the index.
+         *
+         * \return Always true.
+         */
+        static bool decode(const Oid& index, int& pos, value_type& value)
+        {
+            value = Oid();
+            while(pos < index.size())
+            {
+                value.push_back(index[pos++]);
+            }
+            return true;
+        }
+    };
+
+    /**
+     * \brief A typed index schema for table rows.
+     *
+     * The index of a table row is built from the values of the index 
+     * objects listed in the INDEX clause of the MIB (see \ref 
+     * how_tables_work). The Index template describes these index objects at 
+     * compile time, so that index values can be converted to the index OID 
+     * and back without creating variable objects. Up to six components are 
+     * supported:
+     *
+     * - Int32 and UInt32 for integer types
+     * - IpAddr for IpAddress
+     * - String for variable-length OCTET STRING's
+     * - FixedOctets<N> for OCTET STRING's with a fixed size of N octets
+     * - ImpliedString for OCTET STRING's with the IMPLIED keyword
+     * - ObjectId and ImpliedObjectId for OBJECT IDENTIFIER's
+     *
+     * Example for an index consisting of an interface number, a MAC address 
+     * and an IMPLIED name:
+     * \code
+     * typedef Index<Int32, FixedOctets<6>, ImpliedString> MyIndex;
+     *
+     * Oid index = MyIndex::encode(3, mac, "eth0");
+     *
+     * MyIndex::Value value;
+     * if(MyIndex::decode(index, value))
+     * {
+     *     // value.v1 == 3, value.v2 == mac, value.v3 == "eth0"
+     * }
+     * \endcode
+     *
+     * The encoded index can be returned by TableEntry::index() or used as 
+     * row index of a ColumnarTable. Table::entry() finds a row by its index 
+     * using a hash lookup.
+     *
+     * An IMPLIED component must be the last component; violating this rule 
+     * results in a compile error.
+     */
+    template<class C1,
+             class C2 = NoIndex,
+             class C3 = NoIndex,
+             class C4 = NoIndex,
+             class C5 = NoIndex,
+             class C6 = NoIndex>
+    class Index
+    {
+        private:
+            /**
+             * \brief Compile-time check: only the last component may be
+             *        IMPLIED.
+             *
+             * The array size is negative (and thus the typedef invalid) if
+             * an IMPLIED component is followed by another component.
+             */
+            typedef char implied_must_be_last[
+                (   (C1::implied && !C2::is_none)
+                 || (C2::implied && !C3::is_none)
+                 || (C3::implied && !C4::is_none)
+                 || (C4::implied && !C5::is_none)
+                 || (C5::implied && !C6::is_none) ) ? -1 : 1 ];
+
+        public:
+            /**
+             * \brief The values of the index components.
+             *
+             * v1 is the value of the first component, v2 of the second and 
+             * so on. Fields of unused components are empty.
+             */
+            struct Value
+            {
+                typename C1::value_type v1;
+                typename C2::value_type v2;
+                typename C3::value_type v3;
+                typename C4::value_type v4;
+                typename C5::value_type v5;
+                typename C6::value_type v6;
+            };
+
+            /**
+             * \brief Encode index values to an index OID.
+             *
+             * \param value The values.
+             *
+             * \return The index OID.
+             *
+             * \exception inval_param If a value cannot be encoded (e.g. a 
+             *                        FixedOctets value has the wrong size).
+             */
+            static Oid encode(const Value& value)
+            {
+                Oid index;
+                C1::encode(value.v1, index);
+                C2::encode(value.v2, index);
+                C3::encode(value.v3, index);
+                C4::encode(value.v4, index);
+                C5::encode(value.v5, index);
+                C6::encode(value.v6, index);
+                return index;
+            }
+
+            /**
+             * \brief Encode index values to an index OID.
+             *
+             * Convenience variant of encode(const Value&) taking the values 
+             * as separate arguments. Only the values of the used components 
+             * need to be given.
+             *
+             * \exception inval_param If a value cannot be encoded.
+             */
+            static Oid encode(const typename C1::value_type& v1,
+                              const typename C2::value_type& v2 = typename C2::value_type(),
+                              const typename C3::value_type& v3 = typename C3::value_type(),
+                              const typename C4::value_type& v4 = typename C4::value_type(),
+                              const typename C5::value_type& v5 = typename C5::value_type(),
+                              const typename C6::value_type& v6 = typename C6::value_type())
+            {
+                Oid index;
+                C1::encode(v1, index);
+                C2::encode(v2, index);
+                C3::encode(v3, index);
+                C4::encode(v4, index);
+                C5::encode(v5, index);
+                C6::encode(v6, index);
+                return index;
+            }
+
+            /**
+             * \brief Decode an index OID to index values.
+             *
+             * \param oid The OID containing the index.
+             *
+             * \param value Receives the values.
+             *
+             * \param pos The position of the index within oid. This allows 
+             *            to decode the index part of a full variable OID 
+             *            without copying it.
+             *
+             * \return true on success, false if the index is malformed 
+             *         (too short, too long or a subid is out of range).
+             *
+             * \exception None.
+             */
+            static bool decode(const Oid& oid, Value& value, int pos = 0)
+            {
+                return C1::decode(oid, pos, value.v1)
+                    && C2::decode(oid, pos, value.v2)
+                    && C3::decode(oid, pos, value.v3)
+                    && C4::decode(oid, pos, value.v4)
+                    && C5::decode(oid, pos, value.v5)
+                    && C6::decode(oid, pos, value.v6)
+                    && pos == oid.size();
+            }
+    };
+
+} /* namespace agentxcpp */
+#endif /* _INDEX_HPP_ */
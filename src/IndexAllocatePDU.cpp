@@ -37,7 +37,7 @@ IndexAllocatePDU::IndexAllocatePDU(binary::const_iterator& pos,
 
 
 
-binary IndexAllocatePDU::serialize()
+binary IndexAllocatePDU::serialize() const
 {
     binary serialized;
 
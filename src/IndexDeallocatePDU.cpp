@@ -37,7 +37,7 @@ IndexDeallocatePDU::IndexDeallocatePDU(binary::const_iterator& pos,
 
 
 
-binary IndexDeallocatePDU::serialize()
+binary IndexDeallocatePDU::serialize() const
 {
     binary serialized;
 
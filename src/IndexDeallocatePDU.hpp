@@ -93,7 +93,7 @@ namespace agentxcpp
 	    /**
 	     * \brief Serialize the %PDU
 	     */
-	    virtual binary serialize();
+	    virtual binary serialize() const;
     };
 }
 
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#include <vector>
+
+#include "IndexPool.hpp"
+#include "exceptions.hpp"
+
+using namespace agentxcpp;
+using namespace std;
+
+
+IndexPool::IndexPool(MasterProxy& master,
+                     const Varbind& index,
+                     quint32 block_size,
+                     MasterProxy::index_allocation_t how)
+: master(master),
+  index(index),
+  block_size(block_size),
+  how(how),
+  sessionID(master.get_sessionID())
+{
+    if(block_size == 0 || how == MasterProxy::specificIndex)
+    {
+        throw(inval_param());
+    }
+}
+
+
+IndexPool::~IndexPool()
+{
+    check_session();
+    if(pool.empty() || ! master.is_connected())
+    {
+        // Nothing to release
+        return;
+    }
+
+    try
+    {
+        vector<Varbind> indexes(pool.begin(), pool.end());
+        master.deallocateIndex(indexes);
+    }
+    catch(...)
+    {
+        // The master agent releases the values when the session ends
+    }
+}
+
+
+void IndexPool::check_session()
+{
+    if(master.get_sessionID() != sessionID)
+    {
+        // The master agent has released the values of the old session
+        pool.clear();
+        sessionID = master.get_sessionID();
+    }
+}
+
+
+void IndexPool::prefetch(quint32 blocks)
+{
+    check_session();
+
+    // One IndexAllocate-PDU per value; all are sent at once
+    vector< vector<Varbind> > requests(blocks * block_size,
+                                       vector<Varbind>(1, index));
+    vector<MasterProxy::IndexAllocation> responses;
+    responses = master.allocateIndexes(requests, how);
+
+    int allocated = 0;
+    const MasterProxy::IndexAllocation* refused = 0;
+    for(size_t i = 0; i < responses.size(); i++)
+    {
+        if(responses[i].error != ResponsePDU::noAgentXError)
+        {
+            if(! refused)
+            {
+                refused = &responses[i];
+            }
+        }
+        else if(responses[i].indexes.size() == 1)
+        {
+            pool.push_back(responses[i].indexes[0]);
+            allocated++;
+        }
+    }
+
+    if(allocated == 0 && blocks != 0)
+    {
+        // Not a single value was allocated: report why
+        if(refused)
+        {
+            refused->check();
+        }
+
+        // The master agent accepted the requests, but sent no value
+        throw(parse_error());
+    }
+}
+
+
+Varbind IndexPool::take()
+{
+    check_session();
+    if(pool.empty())
+    {
+        // Refill
+        // (forward exceptions)
+        prefetch(1);
+    }
+
+    Varbind v = pool.front();
+    pool.pop_front();
+    return v;
+}
+
+
+void IndexPool::release(const Varbind& index)
+{
+    if(master.get_sessionID() != sessionID)
+    {
+        // Value of an old session; it is no longer allocated
+        check_session();
+        return;
+    }
+    pool.push_back(index);
+}
+
+
+int IndexPool::available()
+{
+    check_session();
+    return static_cast<int>(pool.size());
+}
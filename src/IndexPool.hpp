@@ -0,0 +1,206 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#ifndef _INDEXPOOL_HPP_
+#define _INDEXPOOL_HPP_
+
+#include <deque>
+
+#include <QtGlobal>
+
+#include "Varbind.hpp"
+#include "MasterProxy.hpp"
+
+
+namespace agentxcpp
+{
+
+/**
+ * \brief A local pool of index values allocated from the master agent.
+ *
+ * Allocating an index value with MasterProxy::allocateIndex() takes 
+ * a round trip to the master agent. Subagents which create many rows (e.g. 
+ * one per connection or per session) would wait for the master agent each 
+ * time. The IndexPool allocates index values in blocks and hands them out 
+ * locally:
+ *
+ * \code
+ * Varbind ifIndex(ifIndex_oid, QSharedPointer<AbstractVariable>(
+ *                                  new IntegerVariable(0)));
+ * IndexPool pool(master, ifIndex, 32);
+ *
+ * Varbind index = pool.take();   // no round trip, except for every 32nd
+ * ...
+ * pool.release(index);           // the value may be taken again
+ * \endcode
+ *
+ * A block is allocated with one pipelined batch of IndexAllocate-PDU's 
+ * (see MasterProxy::allocateIndexes()), so refilling the pool takes 
+ * a single round trip. The values are allocated with the new_index or the 
+ * any_index flag, so the master agent chooses them.
+ *
+ * The master agent releases all index values of a session when the 
+ * session ends. The pool notices when the MasterProxy has opened a new 
+ * session and then discards its values; the values which were taken from 
+ * the pool before must be allocated again by the application.
+ *
+ * \note The pool is not protected against concurrent access. It should be 
+ *       used from within the thread running the QApplication event loop, 
+ *       like the MasterProxy.
+ */
+class IndexPool
+{
+    public:
+        /**
+         * \brief Constructor.
+         *
+         * Creates an empty pool. No index values are allocated until 
+         * take() or prefetch() is called.
+         *
+         * \param master The MasterProxy used to allocate the values.
+         *
+         * \param index The index object, with a value of the desired type.
+         *
+         * \param block_size The number of values allocated at once.
+         *
+         * \param how MasterProxy::newIndex or MasterProxy::anyIndex.
+         *
+         * \exception inval_param If block_size is 0 or how is 
+         *                        MasterProxy::specificIndex.
+         */
+        IndexPool(MasterProxy& master,
+                  const Varbind& index,
+                  quint32 block_size = 16,
+                  MasterProxy::index_allocation_t how = MasterProxy::newIndex);
+
+        /**
+         * \brief Destructor.
+         *
+         * Releases the values remaining in the pool at the master agent. 
+         * Errors are ignored.
+         *
+         * \exception None.
+         */
+        ~IndexPool();
+
+        /**
+         * \brief Take an index value from the pool.
+         *
+         * If the pool is empty, a block of values is allocated first.
+         *
+         * \return The index object with the allocated value.
+         *
+         * \exception index_none_available If the master agent has no more 
+         *                                 values.
+         *
+         * \exception index_wrong_type, unsupported_context, master_is_unable, 
+         *            parse_error If the master agent refused the 
+         *                        allocations for another reason.
+         *
+         * \exception disconnected, timeout_error If the master agent does 
+         *                                        not respond.
+         */
+        Varbind take();
+
+        /**
+         * \brief Return an index value to the pool.
+         *
+         * The value stays allocated at the master agent and is handed out 
+         * again by a later take(). Values from a previous session are 
+         * ignored.
+         *
+         * \exception None.
+         */
+        void release(const Varbind& index);
+
+        /**
+         * \brief Allocate blocks of values in advance.
+         *
+         * \param blocks The number of blocks to allocate.
+         *
+         * \exception index_none_available If the master agent has no more 
+         *                                 values.
+         *
+         * \exception index_wrong_type, unsupported_context, master_is_unable, 
+         *            parse_error If the master agent refused the 
+         *                        allocations for another reason.
+         *
+         * \exception disconnected, timeout_error If the master agent does 
+         *                                        not respond.
+         */
+        void prefetch(quint32 blocks = 1);
+
+        /**
+         * \brief Get the number of values which can be taken without 
+         *        contacting the master agent.
+         *
+         * \exception None.
+         */
+        int available();
+
+    private:
+        /**
+         * \brief The MasterProxy used to allocate the values.
+         */
+        MasterProxy& master;
+
+        /**
+         * \brief The index object and type.
+         */
+        Varbind index;
+
+        /**
+         * \brief The number of values allocated at once.
+         */
+        quint32 block_size;
+
+        /**
+         * \brief How the values are allocated.
+         */
+        MasterProxy::index_allocation_t how;
+
+        /**
+         * \brief The session in which the pooled values were allocated.
+         */
+        quint32 sessionID;
+
+        /**
+         * \brief The allocated values which were not yet taken.
+         */
+        std::deque<Varbind> pool;
+
+        /**
+         * \brief Discard the pooled values if the session has changed.
+         */
+        void check_session();
+
+        /**
+         * \brief Don't allow copying.
+         */
+        IndexPool(const IndexPool&);
+
+        /**
+         * \brief Don't allow assignment.
+         */
+        IndexPool& operator=(const IndexPool&);
+};
+
+} /* namespace agentxcpp */
+#endif /* _INDEXPOOL_HPP_ */
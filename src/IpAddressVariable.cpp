@@ -42,6 +42,20 @@ binary IpAddressVariable::serialize() const
 }
 
 
+void IpAddressVariable::serialize_to(SegmentedBuffer& out) const
+{
+    // encode size (in the buffer's byte order) (size is always 4)
+    out.write32(4);
+
+    // encode address
+    quint8* p = out.allocate(4);
+    p[0] = v[0];
+    p[1] = v[1];
+    p[2] = v[2];
+    p[3] = v[3];
+}
+
+
 IpAddressVariable::IpAddressVariable(binary::const_iterator& pos,
 		     const binary::const_iterator& end,
 		     bool big_endian)
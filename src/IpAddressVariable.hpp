@@ -51,7 +51,7 @@ namespace agentxcpp
             IpAddressVariable();
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::new_value
+             * \copydoc agentxcpp::ScalarVariable::new_value
              */
             QSharedPointer<IpAddressVariable> new_value;
 
@@ -77,6 +77,16 @@ namespace agentxcpp
 	     */
 	    binary serialize() const;
 
+	    /**
+	     * \internal
+	     *
+	     * \brief Encode the object into a segmented buffer.
+	     *
+	     * Like serialize(), but the value is written directly into the
+	     * buffer, in the buffer's byte order.
+	     */
+	    virtual void serialize_to(SegmentedBuffer& out) const;
+
 	    /**
              * \brief Construct an IpAddressValue object.
              *
@@ -159,7 +169,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_get()
+             * \copydoc agentxcpp::ScalarVariable::handle_get()
              */
             virtual void handle_get()
             {
@@ -167,7 +177,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_get()
+             * \copydoc agentxcpp::ScalarVariable::perform_get()
              */
             virtual void perform_get()
             {
@@ -176,7 +186,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_testset()
+             * \copydoc agentxcpp::ScalarVariable::handle_testset()
              */
             virtual testset_result_t handle_testset(QSharedPointer<AbstractVariable> _v)
             {
@@ -197,7 +207,7 @@ namespace agentxcpp
             /**
              * \brief Handle a TestSet request.
              *
-             * \copydoc agentxcpp::IntegerVariable::perform_testset()
+             * \copydoc agentxcpp::ScalarVariable::perform_testset()
              */
             virtual testset_result_t perform_testset(const quint8 _v[4])
             {
@@ -207,7 +217,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_cleanupset()
+             * \copydoc agentxcpp::ScalarVariable::handle_cleanupset()
              */
             virtual void handle_cleanupset()
             {
@@ -215,7 +225,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_cleanupset()
+             * \copydoc agentxcpp::ScalarVariable::perform_cleanupset()
              */
             virtual void perform_cleanupset(const quint8 _v[4])
             {
@@ -225,7 +235,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_commitset()
+             * \copydoc agentxcpp::ScalarVariable::handle_commitset()
              */
             virtual bool handle_commitset()
             {
@@ -233,7 +243,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_commitset()
+             * \copydoc agentxcpp::ScalarVariable::perform_commitset()
              */
             virtual bool perform_commitset(const quint8 _v[4])
             {
@@ -243,7 +253,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_undoset()
+             * \copydoc agentxcpp::ScalarVariable::handle_undoset()
              */
             virtual bool handle_undoset()
             {
@@ -251,7 +261,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_undoset()
+             * \copydoc agentxcpp::ScalarVariable::perform_undoset()
              */
             virtual bool perform_undoset(const quint8 _v[4])
             {
@@ -16,6 +16,8 @@
  * See the AgentXcpp library license in the LICENSE file of this package 
  * for more details.
  */
+#include <algorithm>
+
 #include <QtGlobal>
 
 #include "MasterProxy.hpp"
@@ -25,15 +27,93 @@
 #include "RegisterPDU.hpp"
 #include "GetPDU.hpp"
 #include "GetNextPDU.hpp"
+#include "GetBulkPDU.hpp"
 #include "NotifyPDU.hpp"
+#include "IndexAllocatePDU.hpp"
+#include "IndexDeallocatePDU.hpp"
 #include "util.hpp"
 #include "OidVariable.hpp"
+#include "StatisticsHandler.hpp"
+#include "UnixDomainConnector.hpp"
+#include "EpollConnector.hpp"
+#include "UringConnector.hpp"
+#include "Trace.hpp"
 
 
 using namespace std;
 using namespace agentxcpp;
 
 
+/**
+ * \brief Measures the duration of a callback.
+ *
+ * The callback is recorded when the object is destroyed, which also happens
+ * if the callback throws. It is recorded as failed unless succeeded() was
+ * called.
+ *
+ * The object also places the trace_callback_begin and trace_callback_end
+ * tracepoints (see Trace.hpp).
+ */
+class CallbackTimer
+{
+    public:
+        /**
+         * \brief Start the measurement.
+         *
+         * \param s The statistics to update.
+         *
+         * \param n The OID passed to the callback.
+         *
+         * \param request The PDU being processed.
+         *
+         * \param type The type of the PDU being processed.
+         *
+         * \param index The 1-based index of the varbind being processed.
+         */
+        CallbackTimer(AgentStatistics& s, const Oid& n,
+                      PDU& request, PDU::type_t type, quint32 index)
+        : stats(s),
+          name(n),
+          pdu(request),
+          pdu_type(type),
+          varbind(index),
+          start(AgentStatistics::now()),
+          failed(true)
+        {
+            AGENTXCPP_TRACE(callback_begin, pdu.get_packetID(),
+                            pdu.get_transactionID(), pdu_type, varbind);
+        }
+
+        /**
+         * \brief Mark the callback as succeeded.
+         */
+        void succeeded()
+        {
+            failed = false;
+        }
+
+        /**
+         * \brief Record the callback.
+         */
+        ~CallbackTimer()
+        {
+            stats.record_callback(name, AgentStatistics::now() - start,
+                                  failed);
+            AGENTXCPP_TRACE(callback_end, pdu.get_packetID(),
+                            pdu.get_transactionID(), pdu_type, varbind);
+        }
+
+    private:
+        AgentStatistics& stats;
+        Oid name;
+        PDU& pdu;
+        PDU::type_t pdu_type;
+        quint32 varbind;
+        quint64 start;
+        bool failed;
+};
+
+
 
 
 
@@ -43,21 +123,79 @@ using namespace agentxcpp;
 MasterProxy::MasterProxy(std::string _description,
 			   quint8 _default_timeout,
 			   Oid _id,
-			   std::string _filename) :
+			   std::string _filename,
+			   backend_t backend,
+			   bool _native_byte_order) :
     socket_file(_filename.c_str()),
     sessionID(0),
     description(_description),
     default_timeout(_default_timeout),
-    id(_id)
+    id(_id),
+    namespaces(1),
+    ns(0),
+    deadline(0),
+    deadline_cutoff(true),
+    deadline_margin(100),
+    prefetcher(0),
+    prefetch_depth(0),
+    keepalive_interval(0),
+    keepalive_timeout(0),
+    native_byte_order(_native_byte_order)
 {
+    QObject::connect(&tuning_timer, SIGNAL(timeout()),
+                     this, SLOT(tune_timeouts()));
+
     // Initialize connector (never use timeout=0)
     quint8 timeout;
     timeout = (this->default_timeout == 0) ? 1 : this->default_timeout;
-    connection = new UnixDomainConnector(
-			       _filename.c_str(),
-			       timeout*1000);
-    connection->moveToThread(&m_thread);
-    m_thread.start();
+    used_backend = backend;
+    if(backend == uringBackend)
+    {
+#ifdef AGENTXCPP_IO_URING
+        try
+        {
+            connection = new UringConnector(_filename, timeout*1000);
+        }
+        catch(network_error)
+        {
+            // io_uring is not available at runtime
+            used_backend = epollBackend;
+        }
+#else
+        // Built without io_uring support
+        used_backend = epollBackend;
+#endif
+    }
+    if(used_backend == epollBackend)
+    {
+        // The connector runs its own I/O thread
+        connection = new EpollConnector(_filename, timeout*1000);
+    }
+    else if(used_backend == embeddedBackend)
+    {
+        // The connector is driven by process(), and its signals arrive 
+        // directly in our thread
+        connection = new EpollConnector(_filename, timeout*1000, true);
+    }
+    else if(used_backend == qtBackend)
+    {
+        connection = new UnixDomainConnector(
+                               _filename.c_str(),
+                               timeout*1000);
+    }
+    connection->setStatistics(&stats);
+    if(native_byte_order)
+    {
+        // Before the agentx-Open-PDU is sent
+        connection->setByteOrder(host_big_endian);
+    }
+    QObject::connect(connection, SIGNAL(reconnected()),
+                     this, SLOT(resume_session()));
+    if(used_backend == qtBackend)
+    {
+        connection->moveToThread(&m_thread);
+        m_thread.start();
+    }
 
 
     // Register this object as %PDU handler
@@ -81,6 +219,94 @@ MasterProxy::MasterProxy(std::string _description,
 }
 
 
+/**
+ * \brief Convert a context name to the representation used in PDU's.
+ */
+static OctetStringVariable context_value(const std::string& context)
+{
+    binary value;
+    value.assign(context.begin(), context.end());
+    return OctetStringVariable(value);
+}
+
+
+/**
+ * \brief Get the context name of a PDU.
+ *
+ * \return The name, or the empty string for the default context.
+ */
+static std::string context_name(PDUwithContext& pdu)
+{
+    if( ! pdu.has_context())
+    {
+        return std::string();
+    }
+    binary value = pdu.get_context().value();
+    return std::string(value.begin(), value.end());
+}
+
+
+MasterProxy::ContextNamespace&
+MasterProxy::get_namespace(const std::string& context)
+{
+    ContextNamespace* n = find_namespace(QByteArray(context.data(),
+                                                    context.size()));
+    if(n)
+    {
+        return *n;
+    }
+
+    // Intern the new context
+    context_ids.insert(QByteArray(context.data(), context.size()),
+                       namespaces.size());
+    namespaces.push_back(ContextNamespace());
+    return namespaces.back();
+}
+
+
+MasterProxy::ContextNamespace*
+MasterProxy::find_namespace(const QByteArray& context)
+{
+    if(context.isEmpty())
+    {
+        // Default context
+        return &namespaces[0];
+    }
+
+    // The default context is not contained, so 0 means "unknown"
+    quint32 n = context_ids.value(context, 0);
+    if(n == 0)
+    {
+        return 0;
+    }
+    return &namespaces[n];
+}
+
+
+/**
+ * \brief Create a copy of a RegisterPDU with another timeout.
+ *
+ * The copy gets a new packetID, so that it can be sent as a new request.
+ */
+static QSharedPointer<RegisterPDU> copy_registration(
+        QSharedPointer<RegisterPDU> r, quint8 timeout)
+{
+    QSharedPointer<RegisterPDU> pdu(new RegisterPDU);
+    pdu->set_subtree(r->get_subtree());
+    pdu->set_priority(r->get_priority());
+    pdu->set_range_subid(r->get_range_subid());
+    pdu->set_upper_bound(r->get_upper_bound());
+    pdu->set_instance_registration(r->get_instance_registration());
+    if(r->has_context())
+    {
+        pdu->set_context(r->get_context());
+    }
+    pdu->set_sessionID(r->get_sessionID());
+    pdu->set_timeout(timeout);
+    return pdu;
+}
+
+
 void MasterProxy::connect()
 {
 //    if( this->connection->is_connected() )
@@ -89,9 +315,10 @@ void MasterProxy::connect()
 //	return;
 //    }
 
-    // Clear registrations and variables
-    registrations.clear();
-    variables.clear();
+    // The variables, subtree handlers and registrations are kept, so that
+    // the subagent resumes service after a reconnect (e.g. after a restart
+    // of the master agent) without help from the application.
+    quint64 start = AgentStatistics::now();
 
     // Connect to endpoint
     this->connection->connect();
@@ -131,11 +358,78 @@ void MasterProxy::connect()
 
     // All went fine, we are connected now
     this->sessionID = response->get_sessionID();
+    stats.record_connect();
 
+    // (connect() may be called again after a connection loss)
     QObject::connect(connection,
                      SIGNAL(pduArrived(QSharedPointer<PDU>)),
                      this,
-                     SLOT(handle_pdu(QSharedPointer<PDU>)));
+                     SLOT(handle_pdu(QSharedPointer<PDU>)),
+                     Qt::UniqueConnection);
+
+    // Restore the registrations of the previous session
+    restore_registrations();
+    stats.record_time_to_service(AgentStatistics::now() - start);
+
+    if(keepalive_interval != 0)
+    {
+        connection->startKeepalive(sessionID,
+                                   keepalive_interval, keepalive_timeout);
+    }
+}
+
+
+
+void MasterProxy::restore_registrations()
+{
+    if(registrations.empty())
+    {
+        return;
+    }
+
+    // The master agent removed the registrations when the previous session
+    // ended (RFC 2741, 7.1.8. "Processing the agentx-Close-PDU"). Register
+    // them again for the new session, all at once.
+    std::list< QSharedPointer<RegisterPDU> > renewed;
+    QList< QSharedPointer<PDU> > batch;
+    std::list< QSharedPointer<RegisterPDU> >::const_iterator r;
+    for(r = registrations.begin(); r != registrations.end(); r++)
+    {
+        QSharedPointer<RegisterPDU> pdu;
+        pdu = copy_registration(*r, (*r)->get_timeout());
+        pdu->set_priority(application_priority(*r));
+        pdu->set_sessionID(this->sessionID);
+        renewed.push_back(pdu);
+        batch.append(pdu);
+    }
+
+    QList< QSharedPointer<ResponsePDU> > responses;
+    try
+    {
+        responses = connection->request_batch(batch);
+    }
+    catch(timeout_error)
+    {
+        // Keep the registrations for the next attempt
+        throw disconnected();
+    }
+
+    // Keep the registrations accepted by the master agent (all of them use 
+    // the application's priority again)
+    registrations.clear();
+    application_priorities.clear();
+    int i = 0;
+    for(r = renewed.begin(); r != renewed.end(); r++, i++)
+    {
+        if(responses[i]->get_error() == ResponsePDU::noAgentXError)
+        {
+            registrations.push_back(*r);
+        }
+        else
+        {
+            stats.remove_subtree((*r)->get_subtree());
+        }
+    }
 }
 
 
@@ -200,6 +494,9 @@ MasterProxy::~MasterProxy()
     // Disconnect from master agent
     this->disconnect(ClosePDU::reasonShutdown);
 
+    // Stop prefetching
+    delete prefetcher;
+
     // Destroy connection
     // Unregistering this object as %PDU handler is unneeded.
     delete this->connection;
@@ -238,9 +535,8 @@ void MasterProxy::do_registration(QSharedPointer<RegisterPDU> pdu)
 	    throw(disconnected());
 
 	case ResponsePDU::unsupportedContext:
-	    // We do currently not really support contexts in this library. An 
-	    // invalid context is thus probably an agentxcpp bug.
-	    throw(internal_error());
+	    // The master agent does not know the context
+	    throw(unsupported_context());
 
 	case ResponsePDU::processingError:
 	    // master was unable to process the request
@@ -276,7 +572,8 @@ void MasterProxy::do_registration(QSharedPointer<RegisterPDU> pdu)
 
 void MasterProxy::register_subtree(Oid subtree,
 		      quint8 priority,
-		      quint8 timeout)
+		      quint8 timeout,
+		      const std::string& context)
 {
     // Build PDU
     QSharedPointer<RegisterPDU> pdu(new RegisterPDU);
@@ -284,6 +581,10 @@ void MasterProxy::register_subtree(Oid subtree,
     pdu->set_priority(priority);
     pdu->set_timeout(timeout);
     pdu->set_sessionID(this->sessionID);
+    if( ! context.empty())
+    {
+        pdu->set_context(context_value(context));
+    }
 
     // Send PDU
     try
@@ -304,13 +605,18 @@ void MasterProxy::register_subtree(Oid subtree,
 
     // Success: store registration
     this->registrations.push_back(pdu);
+    stats.add_subtree(subtree);
+
+    // Requests for the context are served from now on
+    get_namespace(context);
 
 }
 
 
 
 void MasterProxy::unregister_subtree(Oid subtree,
-				      quint8 priority)
+				      quint8 priority,
+				      const std::string& context)
 {
     // The UnregisterPDU
     QSharedPointer<UnregisterPDU> pdu;
@@ -320,10 +626,11 @@ void MasterProxy::unregister_subtree(Oid subtree,
     r = this->registrations.begin();
     while (r != this->registrations.end())
     {
-	if(   (*r)->get_priority() == priority
+	if(   application_priority(*r) == priority
 	   && (*r)->get_subtree() == subtree
 	   && (*r)->get_range_subid() == 0
-	   && (*r)->get_upper_bound() == 0 )
+	   && (*r)->get_upper_bound() == 0
+	   && context_name(**r) == context )
 	{
 	    // registration found
 
@@ -331,6 +638,7 @@ void MasterProxy::unregister_subtree(Oid subtree,
 	    pdu = create_unregister_pdu(*r);
 
 	    // remove registration from list, forward to next one
+	    application_priorities.erase(r->data());
 	    r = registrations.erase(r);
 	}
 	else
@@ -340,10 +648,30 @@ void MasterProxy::unregister_subtree(Oid subtree,
 	}
     }
 
+    if( ! pdu )
+    {
+	// No such registration
+	throw(unknown_registration());
+    }
+
     // Sent PDU
     try
     {
 	this->undo_registration(pdu);
+
+	// The statistics are kept while the subtree is registered for 
+	// another context
+	for(r = registrations.begin(); r != registrations.end(); r++)
+	{
+	    if((*r)->get_subtree() == subtree)
+	    {
+		break;
+	    }
+	}
+	if(r == registrations.end())
+	{
+	    stats.remove_subtree(subtree);
+	}
     }
     catch( internal_error )
     {
@@ -393,9 +721,8 @@ void MasterProxy::undo_registration(QSharedPointer<UnregisterPDU> pdu)
 	    throw(disconnected());
 
 	case ResponsePDU::unsupportedContext:
-	    // We do currently not really support contexts in this library. An 
-	    // invalid context is thus probably an agentxcpp bug.
-	    throw(internal_error());
+	    // The master agent does not know the context
+	    throw(unsupported_context());
 
 	case ResponsePDU::processingError:
 	    // master was unable to process the request
@@ -432,6 +759,10 @@ QSharedPointer<UnregisterPDU> MasterProxy::create_unregister_pdu(
     new_pdu->set_range_subid( pdu->get_range_subid() );
     new_pdu->set_upper_bound( pdu->get_upper_bound() );
     new_pdu->set_priority( pdu->get_priority() );
+    if( pdu->has_context() )
+    {
+        new_pdu->set_context( pdu->get_context() );
+    }
 
     return new_pdu;
 }
@@ -442,8 +773,14 @@ void MasterProxy::handle_getpdu(QSharedPointer<ResponsePDU> response, QSharedPoi
         // Handling according to
 	// RFC 2741, 7.2.3.1 "Subagent Processing of the agentx-Get-PDU"
 
-	// Extract searchRange list
-	vector<Oid> sr = get_pdu->get_sr();
+	// Extract searchRange list (no copy)
+	const vector<Oid>& sr = get_pdu->get_sr();
+
+	// There is one varbind per searchRange
+	response->varbindlist.reserve(sr.size());
+
+	// The time left to answer the request
+	start_deadline(sr.empty() ? Oid() : sr.front());
 
 	// Iterate over list and handle each Oid separately
 	vector<Oid>::const_iterator i;
@@ -451,13 +788,24 @@ void MasterProxy::handle_getpdu(QSharedPointer<ResponsePDU> response, QSharedPoi
                              // 5.4. "Value Representation"):
 	for(i = sr.begin(); i != sr.end(); i++)
 	{
+            if(deadline_passed())
+            {
+                // Answer with the varbinds processed so far, before the
+                // master agent regards us as not responding
+                response->set_error( ResponsePDU::genErr );
+                response->set_index( index );
+                stats.record_deadline_cutoff();
+                return;
+            }
+
 	    // The name
 	    const Oid& name = *i;
 
 	    // Find variable for current OID
 	    map< Oid, QSharedPointer<AbstractVariable> >::const_iterator var;
-	    var = variables.find(name);
-	    if(var != variables.end())
+	    map< Oid, QSharedPointer<SubtreeHandler> >::const_iterator handler;
+	    var = ns->variables.find(name);
+	    if(var != ns->variables.end())
 	    {
 		// Step (2): We have a variable for this Oid
 
@@ -465,7 +813,10 @@ void MasterProxy::handle_getpdu(QSharedPointer<ResponsePDU> response, QSharedPoi
                 try
                 {
                     // Add variable to response (Step (1): include name)
-                    var->second->handle_get();
+                    CallbackTimer timer(stats, name, *get_pdu,
+                                        PDU::agentxGetPDU, index);
+                    update_variable(var->second);
+                    timer.succeeded();
                     response->varbindlist.push_back( Varbind(name, var->second) );
                 }
                 catch(...)
@@ -477,6 +828,24 @@ void MasterProxy::handle_getpdu(QSharedPointer<ResponsePDU> response, QSharedPoi
                 }
 
 	    }
+	    else if( (handler = find_handler(name)) != ns->handlers.end() )
+	    {
+		// The OID lies within the subtree of a handler. Let the 
+		// handler decide (it also takes care of Steps (3) and (4))
+                try
+                {
+                    CallbackTimer timer(stats, name, *get_pdu,
+                                        PDU::agentxGetPDU, index);
+                    response->varbindlist.push_back( handler->second->get(name) );
+                    timer.succeeded();
+                }
+                catch(...)
+                {
+                    // An error occurred
+                    response->set_error( ResponsePDU::genErr );
+                    response->set_index( index );
+                }
+	    }
 	    else
 	    {
 		// Interpret 'name' as prefix:
@@ -484,8 +853,8 @@ void MasterProxy::handle_getpdu(QSharedPointer<ResponsePDU> response, QSharedPoi
 		// with this name
 		Oid name_copy(name, 0);
 
-		var = variables.find(name_copy);
-		if(var != variables.end())
+		var = ns->variables.find(name_copy);
+		if(var != ns->variables.end())
 		{
 		    // Step (4): We have a variable with the object
 		    //           identifier prefix 'name': Send noSuchInstance 
@@ -515,67 +884,60 @@ void MasterProxy::handle_getnextpdu(QSharedPointer<ResponsePDU> response, QShare
 	// Extract searchRange list
 	vector< pair<Oid,Oid> >& sr = getnext_pdu->get_sr();
 
+	// There is one varbind per SearchRange
+	response->varbindlist.reserve(sr.size());
+
+	// The time left to answer the request
+	start_deadline(sr.empty() ? Oid() : sr.front().first);
+
 	// Iterate over list and handle each SearchRange separately
 	vector< pair<Oid,Oid> >::const_iterator i;
         quint16 index = 1;  // Index is 1-based (RFC 2741,
                              // 5.4. "Value Representation"):
 	for(i = sr.begin(); i != sr.end(); i++)
 	{
+            if(deadline_passed())
+            {
+                // Answer with the varbinds processed so far, before the
+                // master agent regards us as not responding
+                response->set_error( ResponsePDU::genErr );
+                response->set_index( index );
+                stats.record_deadline_cutoff();
+                return;
+            }
+
 	    // The names
 	    const Oid& starting_oid = i->first;
             const Oid& ending_oid   = i->second;
 
-            // Find "next" variable
-	    map< Oid, QSharedPointer<AbstractVariable> >::const_iterator next_var;
-	    if( ! starting_oid.include())
-            {
-                // Find the closest lexicographical successor to the starting 
-                // OID (excluding the starting OID itself)
-                next_var = variables.upper_bound(starting_oid);
-            }
-            else
-            {
-                // Find the exact variable or, if not present, find the 
-                // lexicographical successor of it
-                next_var = variables.lower_bound(starting_oid);
-            }
-            if(next_var != variables.end() && ! ending_oid.is_null() )
+            // Find "next" variable (a SubtreeHandler may throw) and
+            // update it
+            try
             {
-                // The "next" variable must precede the ending OID (it must not 
-                // be greater or equal than the ending OID)
-                if( next_var->first >= ending_oid )
-                {
-                    // The found "next" variable doesn't precede the ending 
-                    // OID, which means that we didn't found a suitable 
-                    // variable.
-                    next_var = variables.end(); // indicate "not found"
-                }
-            }
-
-	    if(next_var != variables.end())
-	    {
-                // "Next" variable was found
-
-		// update variable
-                try
+                Oid next_name;
+                QSharedPointer<AbstractVariable> next_var;
+                if(find_next(starting_oid, ending_oid, next_name, next_var))
                 {
-                    next_var->second->handle_get();
-                    response->varbindlist.push_back( Varbind(next_var->first, next_var->second) );
+                    // "Next" variable was found
+                    CallbackTimer timer(stats, next_name, *getnext_pdu,
+                                        PDU::agentxGetNextPDU, index);
+                    update_variable(next_var);
+                    timer.succeeded();
+                    response->varbindlist.push_back( Varbind(next_name, next_var) );
                 }
-                catch(...)
+                else
                 {
-                    // An error occurred
-                    response->set_error( ResponsePDU::genErr );
-                    response->set_index( index );
-                    // Leave response.varbindlist empty
+                    // "Next" variable was NOT found
+                    response->varbindlist.push_back( Varbind(starting_oid, Varbind::endOfMibView) );
                 }
-
-	    }
-	    else
-	    {
-                // "Next" variable was NOT found
-		response->varbindlist.push_back( Varbind(starting_oid, Varbind::endOfMibView) );
-	    }
+            }
+            catch(...)
+            {
+                // An error occurred
+                response->set_error( ResponsePDU::genErr );
+                response->set_index( index );
+                // Leave response.varbindlist empty
+            }
 
             index++;
 	}
@@ -583,92 +945,413 @@ void MasterProxy::handle_getnextpdu(QSharedPointer<ResponsePDU> response, QShare
 
 
 
-void MasterProxy::handle_testsetpdu(QSharedPointer<ResponsePDU> response, QSharedPointer<TestSetPDU> testset_pdu)
+/**
+ * \brief Get the first OID following all OID's of a subtree.
+ *
+ * \param subtree The subtree.
+ *
+ * \param successor Receives the successor. Its include flag is set.
+ *
+ * \return false if no OID can follow the subtree, true otherwise.
+ */
+static bool subtree_successor(const Oid& subtree, Oid& successor)
 {
-    // Handling according to
-    // RFC 2741, 7.2.4.1 "Subagent Processing of the agentx-TestSet-PDU"
-
-    // Extract Varbind list
-    vector<Varbind>& vb = testset_pdu->get_vb();
-
-    // Initially, no Varbind failed:
-    response->set_error(ResponsePDU::noAgentXError);
-
-    // Iterate over list and handle each Varbind separately. Return on the 
-    // first varbind which doesn't validate correctly.
-    vector<Varbind>::const_iterator i;
-    quint16 index;
-    for(i = vb.begin(), index = 1; i != vb.end(); i++, index++)
+    successor = subtree;
+    while( ! successor.empty() )
     {
-        // Find the associated variable
-        map< Oid, QSharedPointer<AbstractVariable> >::const_iterator var;
-	var = variables.find(i->get_name());
-        if(var == variables.end())
+        if(successor.last() != 0xffffffff)
         {
-            // error: variable unknown
-            response->set_error(ResponsePDU::notWritable);
-            response->set_index(index);
-
-            // Some variables may have allocated resources, which must be
-            // released again. This is the same as handle_cleanupsetpdu() does, 
-            // so we are lazy here and call this function:
-            this->handle_cleanupsetpdu();
-            return;
+            successor.last()++;
+            successor.setInclude(true);
+            return true;
         }
+        successor.pop_back();
+    }
 
-        // Remember the found variable for later operations
-        setlist.push_back(var->second);
+    return false;
+}
 
-        // Perform validation, store result within response
-        // Note: ResponsePDU::error_t and variable::testset_result_t are in 
-        // sync, therefore the static cast works.
-        response->set_error(static_cast<ResponsePDU::error_t>(var->second->handle_testset(i->get_var())));
-        if(response->get_error() != ResponsePDU::noAgentXError)
-        {
-            response->set_index(index);
 
-            // Some variables may have allocated resources, which must be
-            // released again. This is the same as handle_cleanupsetpdu() does, 
-            // so we are lazy here and call this function:
-            this->handle_cleanupsetpdu();
 
-            return;
+map< Oid, QSharedPointer<SubtreeHandler> >::const_iterator
+MasterProxy::find_handler(const Oid& name) const
+{
+    if(ns->handlers.empty())
+    {
+        return ns->handlers.end();
+    }
+
+    // Try the prefixes of name, starting with the longest one
+    Oid prefix = name;
+    while( ! prefix.empty() )
+    {
+        map< Oid, QSharedPointer<SubtreeHandler> >::const_iterator h;
+        h = ns->handlers.find(prefix);
+        if(h != ns->handlers.end())
+        {
+            return h;
         }
+        prefix.pop_back();
     }
 
-    // At this point, all VarBinds validated correctly. The response was filled 
-    // correctly, and we simply return.
-    return;
+    return ns->handlers.end();
 }
 
 
-void MasterProxy::handle_cleanupsetpdu()
+
+bool MasterProxy::find_next(const Oid& starting_oid,
+                            const Oid& ending_oid,
+                            Oid& name,
+                            QSharedPointer<AbstractVariable>& var)
 {
-    // Handling according to
-    // RFC 2741, 7.2.4.4 "Subagent Processing of the agentx-CleanupSet-PDU"
+    bool found = false;
 
-    // Iterate over list and handle each Varbind separately. We iterate 
-    // backwards, so that resources are released in the reverse order of their
-    // allocation.
-    list< QSharedPointer<AbstractVariable> >::const_reverse_iterator i;
-    for(i = setlist.rbegin(); i != setlist.rend(); i++)
+    // Search the variables
+    map< Oid, QSharedPointer<AbstractVariable> >::const_iterator next_var;
+    bool walking = false;
+    if( ! starting_oid.include()
+        && ns->cursor_valid && ns->cursor->first == starting_oid )
     {
-        (*i)->handle_cleanupset();
+        // A walk continues behind the variable found last time: its
+        // successor is the next element of the map
+        next_var = ns->cursor;
+        next_var++;
+        walking = true;
+    }
+    else if( ! starting_oid.include())
+    {
+        // Find the closest lexicographical successor to the starting OID 
+        // (excluding the starting OID itself)
+        next_var = ns->variables.upper_bound(starting_oid);
+    }
+    else
+    {
+        // Find the exact variable or, if not present, find the 
+        // lexicographical successor of it
+        next_var = ns->variables.lower_bound(starting_oid);
+    }
+    bool found_variable = false;
+    if(next_var != ns->variables.end())
+    {
+        name = next_var->first;
+        var = next_var->second;
+        found = true;
+        found_variable = true;
     }
 
-    // Finally: remove all variables from the list
-    setlist.clear();
-}
-
-void MasterProxy::handle_commitsetpdu(QSharedPointer<ResponsePDU> response, QSharedPointer<CommitSetPDU> commitset_pdu)
-{
-    // Handling according to RFC 2741, 7.2.4.2 "Subagent Processing of the 
-    // agentx-CommitSet-PDU"
-
-    // Iterate over list and handle each Varbind separately.
-    list< QSharedPointer<AbstractVariable> >::iterator i;
-    quint16 index = 1;  // Index is 1-based (RFC 2741, 5.4. "Value Representation")
-    for(i = setlist.begin(); i != setlist.end(); i++)
+    // Search the subtree handlers. An object served by a handler wins if it 
+    // precedes the variable found so far. Handlers whose subtree lies 
+    // completely before the starting OID cannot serve an object, therefore 
+    // the scan starts at the outermost handler containing the starting OID 
+    // or, if there is none, at the first handler behind it.
+    map< Oid, QSharedPointer<SubtreeHandler> >::const_iterator h;
+    h = ns->handlers.lower_bound(starting_oid);
+    Oid prefix = starting_oid;
+    while( ! prefix.empty() )
+    {
+        prefix.pop_back();
+        map< Oid, QSharedPointer<SubtreeHandler> >::const_iterator outer;
+        outer = ns->handlers.find(prefix);
+        if(outer != ns->handlers.end())
+        {
+            h = outer;
+        }
+    }
+    for(; h != ns->handlers.end(); h++)
+    {
+        if(found && name < h->first)
+        {
+            // This handler (and all following handlers) cannot contain a
+            // better candidate
+            break;
+        }
+        if(h->first < starting_oid && ! h->first.contains(starting_oid))
+        {
+            // A subtree nested in the outermost handler which ends before 
+            // the starting OID
+            continue;
+        }
+
+        Oid from = starting_oid;
+        Oid obj_name;
+        QSharedPointer<AbstractVariable> obj_var;
+        while(h->second->next(from, ending_oid, obj_name, obj_var))
+        {
+            // Is the handler responsible for the found object, or is there 
+            // a handler for a nested subtree?
+            map< Oid, QSharedPointer<SubtreeHandler> >::const_iterator owner;
+            owner = find_handler(obj_name);
+            if(owner == h)
+            {
+                if( ! found || obj_name < name)
+                {
+                    name = obj_name;
+                    var = obj_var;
+                    found = true;
+                    found_variable = false;
+                }
+                break;
+            }
+
+            // The object belongs to a nested subtree (which is searched 
+            // separately): continue behind that subtree
+            if( ! subtree_successor(owner->first, from) )
+            {
+                // Nothing can follow the nested subtree
+                break;
+            }
+        }
+    }
+
+    if(found_variable)
+    {
+        // The variable wins: the next request of a walk will start here
+        ns->cursor = next_var;
+        ns->cursor_valid = true;
+
+        if(prefetcher && walking)
+        {
+            prefetch_ahead(next_var);
+        }
+    }
+
+    if(found && ! ending_oid.is_null() )
+    {
+        // The "next" object must precede the ending OID (it must not be 
+        // greater or equal than the ending OID)
+        if( name >= ending_oid )
+        {
+            // The found "next" object doesn't precede the ending OID, which 
+            // means that we didn't found a suitable object.
+            found = false;
+        }
+    }
+
+    return found;
+}
+
+
+
+void MasterProxy::handle_getbulkpdu(QSharedPointer<ResponsePDU> response, QSharedPointer<GetBulkPDU> getbulk_pdu)
+{
+    // Handling according to
+    // RFC 2741, 7.2.3.3 "Subagent Processing of the agentx-GetBulk-PDU"
+
+    // Extract searchRange list
+    vector< pair<Oid,Oid> >& sr = getbulk_pdu->get_sr();
+    size_t non_repeaters = getbulk_pdu->get_non_repeaters();
+    if(non_repeaters > sr.size())
+    {
+        non_repeaters = sr.size();
+    }
+
+    // The time left to answer the request
+    start_deadline(sr.empty() ? Oid() : sr.front().first);
+
+    // Step (1): the first non_repeaters SearchRanges are processed like a 
+    // GetNext request
+    quint16 index = 1;  // Index is 1-based (RFC 2741,
+                        // 5.4. "Value Representation"):
+    for(size_t i = 0; i < non_repeaters; i++, index++)
+    {
+        if(deadline_passed())
+        {
+            // The non-repeaters must be complete: answer with an error
+            response->set_error( ResponsePDU::genErr );
+            response->set_index( index );
+            stats.record_deadline_cutoff();
+            return;
+        }
+        try
+        {
+            Oid name;
+            QSharedPointer<AbstractVariable> var;
+            if(find_next(sr[i].first, sr[i].second, name, var))
+            {
+                CallbackTimer timer(stats, name, *getbulk_pdu,
+                                    PDU::agentxGetBulkPDU, index);
+                update_variable(var);
+                timer.succeeded();
+                response->varbindlist.push_back( Varbind(name, var) );
+            }
+            else
+            {
+                response->varbindlist.push_back( Varbind(sr[i].first, Varbind::endOfMibView) );
+            }
+        }
+        catch(...)
+        {
+            // An error occurred (in a SubtreeHandler or in the variable):
+            // stop processing
+            response->set_error( ResponsePDU::genErr );
+            response->set_index( index );
+            return;
+        }
+    }
+
+    // Step (2): the remaining SearchRanges are processed repeatedly, each 
+    // repetition starting behind the object found by the previous one.
+    vector<Oid> current;
+    for(size_t i = non_repeaters; i < sr.size(); i++)
+    {
+        current.push_back(sr[i].first);
+    }
+    for(quint16 repetition = 0;
+        repetition < getbulk_pdu->get_max_repititions() && ! current.empty();
+        repetition++)
+    {
+        bool end_of_mib_view = true;
+        for(size_t j = 0; j < current.size(); j++)
+        {
+            if(deadline_passed())
+            {
+                // Stop the repetitions early. The response is valid, it
+                // just contains fewer repetitions than requested.
+                stats.record_deadline_cutoff();
+                return;
+            }
+
+            const Oid& ending_oid = sr[non_repeaters + j].second;
+            Oid name;
+            QSharedPointer<AbstractVariable> var;
+            bool next_found;
+            try
+            {
+                next_found = find_next(current[j], ending_oid, name, var);
+                if(next_found)
+                {
+                    CallbackTimer timer(stats, name, *getbulk_pdu,
+                                        PDU::agentxGetBulkPDU, index + j);
+                    update_variable(var);
+                    timer.succeeded();
+                    response->varbindlist.push_back( Varbind(name, var) );
+                }
+            }
+            catch(...)
+            {
+                // An error occurred (in a SubtreeHandler or in the
+                // variable): stop processing
+                response->set_error( ResponsePDU::genErr );
+                response->set_index( index + j );
+                return;
+            }
+            if(next_found)
+            {
+                // Next repetition starts behind the found object
+                current[j] = name;
+                current[j].setInclude(false);
+                end_of_mib_view = false;
+            }
+            else
+            {
+                response->varbindlist.push_back( Varbind(current[j], Varbind::endOfMibView) );
+            }
+        }
+
+        if(end_of_mib_view)
+        {
+            // All repeaters reached the end of the MIB view. Further 
+            // repetitions would only add endOfMibView varbinds.
+            break;
+        }
+    }
+}
+
+
+void MasterProxy::handle_testsetpdu(QSharedPointer<ResponsePDU> response, QSharedPointer<TestSetPDU> testset_pdu)
+{
+    // Handling according to
+    // RFC 2741, 7.2.4.1 "Subagent Processing of the agentx-TestSet-PDU"
+
+    // Extract Varbind list
+    vector<Varbind>& vb = testset_pdu->get_vb();
+
+    // Initially, no Varbind failed:
+    response->set_error(ResponsePDU::noAgentXError);
+
+    // Iterate over list and handle each Varbind separately. Return on the 
+    // first varbind which doesn't validate correctly.
+    vector<Varbind>::const_iterator i;
+    quint16 index;
+    for(i = vb.begin(), index = 1; i != vb.end(); i++, index++)
+    {
+        // Find the associated variable
+        map< Oid, QSharedPointer<AbstractVariable> >::const_iterator var;
+	var = ns->variables.find(i->get_name());
+        if(var == ns->variables.end())
+        {
+            // error: variable unknown
+            response->set_error(ResponsePDU::notWritable);
+            response->set_index(index);
+
+            // Some variables may have allocated resources, which must be
+            // released again. This is the same as handle_cleanupsetpdu() does, 
+            // so we are lazy here and call this function:
+            this->handle_cleanupsetpdu();
+            return;
+        }
+
+        // Remember the found variable for later operations
+        setlist.push_back(var->second);
+
+        // Perform validation, store result within response
+        // Note: ResponsePDU::error_t and variable::testset_result_t are in 
+        // sync, therefore the static cast works.
+        {
+            CallbackTimer timer(stats, i->get_name(), *testset_pdu,
+                                PDU::agentxTestSetPDU, index);
+            response->set_error(static_cast<ResponsePDU::error_t>(var->second->handle_testset(i->get_var())));
+            if(response->get_error() == ResponsePDU::noAgentXError)
+            {
+                timer.succeeded();
+            }
+        }
+        if(response->get_error() != ResponsePDU::noAgentXError)
+        {
+            response->set_index(index);
+
+            // Some variables may have allocated resources, which must be
+            // released again. This is the same as handle_cleanupsetpdu() does, 
+            // so we are lazy here and call this function:
+            this->handle_cleanupsetpdu();
+
+            return;
+        }
+    }
+
+    // At this point, all VarBinds validated correctly. The response was filled 
+    // correctly, and we simply return.
+    return;
+}
+
+
+void MasterProxy::handle_cleanupsetpdu()
+{
+    // Handling according to
+    // RFC 2741, 7.2.4.4 "Subagent Processing of the agentx-CleanupSet-PDU"
+
+    // Iterate over list and handle each Varbind separately. We iterate 
+    // backwards, so that resources are released in the reverse order of their
+    // allocation.
+    list< QSharedPointer<AbstractVariable> >::const_reverse_iterator i;
+    for(i = setlist.rbegin(); i != setlist.rend(); i++)
+    {
+        (*i)->handle_cleanupset();
+    }
+
+    // Finally: remove all variables from the list
+    setlist.clear();
+}
+
+void MasterProxy::handle_commitsetpdu(QSharedPointer<ResponsePDU> response, QSharedPointer<CommitSetPDU> commitset_pdu)
+{
+    // Handling according to RFC 2741, 7.2.4.2 "Subagent Processing of the 
+    // agentx-CommitSet-PDU"
+
+    // Iterate over list and handle each Varbind separately.
+    list< QSharedPointer<AbstractVariable> >::iterator i;
+    quint16 index = 1;  // Index is 1-based (RFC 2741, 5.4. "Value Representation")
+    for(i = setlist.begin(); i != setlist.end(); i++)
     {
         if( (*i)->handle_commitset() )
         {
@@ -727,8 +1410,43 @@ void MasterProxy::handle_undosetpdu(QSharedPointer<ResponsePDU> response, QShare
 }
 
 
+/**
+ * \brief Determine the type of a PDU received from the master agent.
+ *
+ * \return The type, or 0 for PDU's which are not handled by the
+ *         MasterProxy.
+ */
+static PDU::type_t pdu_type(QSharedPointer<PDU> pdu)
+{
+    if(qSharedPointerDynamicCast<GetPDU>(pdu))
+        return PDU::agentxGetPDU;
+    if(qSharedPointerDynamicCast<GetNextPDU>(pdu))
+        return PDU::agentxGetNextPDU;
+    if(qSharedPointerDynamicCast<GetBulkPDU>(pdu))
+        return PDU::agentxGetBulkPDU;
+    if(qSharedPointerDynamicCast<TestSetPDU>(pdu))
+        return PDU::agentxTestSetPDU;
+    if(qSharedPointerDynamicCast<CommitSetPDU>(pdu))
+        return PDU::agentxCommitSetPDU;
+    if(qSharedPointerDynamicCast<UndoSetPDU>(pdu))
+        return PDU::agentxUndoSetPDU;
+    if(qSharedPointerDynamicCast<CleanupSetPDU>(pdu))
+        return PDU::agentxCleanupSetPDU;
+    if(qSharedPointerDynamicCast<ClosePDU>(pdu))
+        return PDU::agentxClosePDU;
+    return static_cast<PDU::type_t>(0);
+}
+
+
 void MasterProxy::handle_pdu(QSharedPointer<PDU> pdu)
 {
+    // Runtime statistics: the PDU left the receive queue
+    quint64 start = AgentStatistics::now();
+    PDU::type_t type = pdu_type(pdu);
+    stats.add_receive_queue(-1);
+    AGENTXCPP_TRACE(dispatch_begin, pdu->get_packetID(),
+                    pdu->get_transactionID(), type, trace_varbind_count(*pdu));
+
     int error = 0; // 0 is "success"
     if(error == -2)
     {
@@ -762,7 +1480,8 @@ void MasterProxy::handle_pdu(QSharedPointer<PDU> pdu)
     //     automatically
     //   - The flags are not copied, because they have
     //     other meanings in ResponsePDU's.
-    //   - TODO: Context is not yet supported.
+    //   - The context is not copied; it is used to select the variables
+    //     below.
     QSharedPointer<ResponsePDU> response(new ResponsePDU);
     response->set_sessionID( pdu->get_sessionID() );
     response->set_transactionID( pdu->get_transactionID() );
@@ -776,6 +1495,8 @@ void MasterProxy::handle_pdu(QSharedPointer<PDU> pdu)
 	response->set_error(ResponsePDU::notOpen);
 
 	// Step 4a) Stop processing the PDU. Send response.
+        AGENTXCPP_TRACE(dispatch_end, pdu->get_packetID(),
+                        pdu->get_transactionID(), type, 0);
 	try
 	{
 //	    this->connection->send(response);
@@ -785,6 +1506,39 @@ void MasterProxy::handle_pdu(QSharedPointer<PDU> pdu)
 	catch(timeout_error) { /* connection loss. Ignore.*/ }
 	catch(disconnected) { /* connection loss. Ignore.*/ }
 
+	stats.record_pdu(type, AgentStatistics::now() - start, true);
+	return;
+    }
+
+    // Select the variables and handlers of the PDU's context. PDU's 
+    // without context field (e.g. CommitSet) operate on the setlist and 
+    // don't need them.
+    ns = &namespaces[0];
+    QSharedPointer<PDUwithContext> context_pdu;
+    context_pdu = qSharedPointerDynamicCast<PDUwithContext>(pdu);
+    if(context_pdu && context_pdu->has_context())
+    {
+        binary context = context_pdu->get_context().value();
+        ns = find_namespace(QByteArray::fromRawData(
+                    reinterpret_cast<const char*>(context.data()),
+                    context.size()));
+    }
+    if(ns == 0)
+    {
+        // We don't serve this context
+	response->set_error(ResponsePDU::unsupportedContext);
+
+	// Stop processing the PDU. Send response.
+        AGENTXCPP_TRACE(dispatch_end, pdu->get_packetID(),
+                        pdu->get_transactionID(), type, 0);
+	try
+	{
+	    connection->send(response);
+	}
+	catch(timeout_error) { /* connection loss. Ignore.*/ }
+	catch(disconnected) { /* connection loss. Ignore.*/ }
+
+	stats.record_pdu(type, AgentStatistics::now() - start, true);
 	return;
     }
 
@@ -808,6 +1562,14 @@ void MasterProxy::handle_pdu(QSharedPointer<PDU> pdu)
         this->handle_getnextpdu(response, getnext_pdu);
     }
 
+    // Is it a GetBulkPDU?
+    QSharedPointer<GetBulkPDU> getbulk_pdu;
+    if( (getbulk_pdu = qSharedPointerDynamicCast<GetBulkPDU>(pdu)) != 0 )
+    {
+        // (response is modified in-place)
+        this->handle_getbulkpdu(response, getbulk_pdu);
+    }
+
     // Is it a TestSetPDU?
     QSharedPointer<TestSetPDU> testset_pdu;
     if( (testset_pdu = qSharedPointerDynamicCast<TestSetPDU>(pdu)) != 0 )
@@ -823,6 +1585,9 @@ void MasterProxy::handle_pdu(QSharedPointer<PDU> pdu)
         this->handle_cleanupsetpdu();
 
         // Do not send a response:
+        AGENTXCPP_TRACE(dispatch_end, pdu->get_packetID(),
+                        pdu->get_transactionID(), type, 0);
+        stats.record_pdu(type, AgentStatistics::now() - start, false);
         return;
     }
 
@@ -845,6 +1610,9 @@ void MasterProxy::handle_pdu(QSharedPointer<PDU> pdu)
     // TODO: handle other PDU types
 
     // Finally: send the response
+    AGENTXCPP_TRACE(dispatch_end, pdu->get_packetID(),
+                    pdu->get_transactionID(), type,
+                    response->varbindlist.size());
     try
     {
         connection->send(response);
@@ -853,10 +1621,14 @@ void MasterProxy::handle_pdu(QSharedPointer<PDU> pdu)
     }
     catch(timeout_error) { /* connection loss. Ignore.*/ }
     catch(disconnected) { /* connection loss. Ignore.*/ }
+
+    stats.record_pdu(type, AgentStatistics::now() - start,
+                     response->get_error() != ResponsePDU::noAgentXError);
 }
 
 void MasterProxy::addVariables(QVector< QPair<
-                            Oid, QSharedPointer<AbstractVariable> > > v)
+                            Oid, QSharedPointer<AbstractVariable> > > v,
+                               const std::string& context)
 {
     QVectorIterator<QPair< Oid,
                            QSharedPointer<AbstractVariable> > > iter(v);
@@ -865,11 +1637,12 @@ void MasterProxy::addVariables(QVector< QPair<
         QPair<Oid, QSharedPointer<AbstractVariable> > varPair;
         varPair = iter.next();
 
-        add_variable(varPair.first, varPair.second);
+        add_variable(varPair.first, varPair.second, context);
     }
 }
 
-void MasterProxy::add_variable(const Oid& id, QSharedPointer<AbstractVariable> v)
+void MasterProxy::add_variable(const Oid& id, QSharedPointer<AbstractVariable> v,
+                               const std::string& context)
 {
     // Check whether id is contained in a registration
     bool is_registered = false;
@@ -877,7 +1650,8 @@ void MasterProxy::add_variable(const Oid& id, QSharedPointer<AbstractVariable> v
     for(r = registrations.begin(); r != registrations.end(); r++)
     {
 	if((*r)->get_instance_registration() == false &&
-	   (*r)->get_range_subid() == 0)
+	   (*r)->get_range_subid() == 0 &&
+	   context_name(**r) == context)
 	{
 	    // Registration is a simple subtree
 	    if( (*r)->get_subtree().contains(id) )
@@ -895,11 +1669,11 @@ void MasterProxy::add_variable(const Oid& id, QSharedPointer<AbstractVariable> v
 	// Not in a registered area
 	throw(unknown_registration());
     }
-    variables[id] = v;
+    get_namespace(context).variables[id] = v;
 }
 
 
-bool MasterProxy::isRegistered(Oid id)
+bool MasterProxy::isRegistered(Oid id, const std::string& context)
 {
     // Check whether id is contained in a registration
     bool is_registered = false;
@@ -907,7 +1681,8 @@ bool MasterProxy::isRegistered(Oid id)
     for(r = registrations.begin(); r != registrations.end(); r++)
     {
         if((*r)->get_instance_registration() == false &&
-           (*r)->get_range_subid() == 0)
+           (*r)->get_range_subid() == 0 &&
+           context_name(**r) == context)
         {
             // Registration is a simple subtree
             if( (*r)->get_subtree().contains(id) )
@@ -924,18 +1699,104 @@ bool MasterProxy::isRegistered(Oid id)
 
 
 
-void MasterProxy::remove_variable(const Oid& id)
+void MasterProxy::remove_variable(const Oid& id, const std::string& context)
+{
+    ContextNamespace* n = find_namespace(QByteArray(context.data(),
+                                                    context.size()));
+    if(n)
+    {
+        // Remove variable
+        n->erase(id); // If variable was not registered: ignore
+    }
+}
+
+void MasterProxy::removeVariables(const QVector<Oid>& ids,
+                                  const std::string& context)
+{
+    QVectorIterator<Oid> iter(ids);
+    while(iter.hasNext())
+    {
+        remove_variable(iter.next(), context);
+    }
+}
+
+/**
+ * \brief Compare two variable pairs by their OID.
+ */
+static bool lessByOid(const QPair< Oid, QSharedPointer<AbstractVariable> >& a,
+                      const QPair< Oid, QSharedPointer<AbstractVariable> >& b)
 {
-    // Remove variable
-    variables.erase(id); // If variable was not registered: ignore
+    return a.first < b.first;
 }
 
-void MasterProxy::removeVariables(const QVector<Oid>& ids)
+void MasterProxy::updateVariables(const Oid& subtree,
+                                  const QVector<Oid>& ids,
+                                  QVector< QPair<
+                                  Oid, QSharedPointer<AbstractVariable> >
+                                  > vars,
+                                  const std::string& context)
 {
+    // Check registrations before changing anything. If the whole subtree is 
+    // registered, the variables need not be checked one by one.
+    if( ! isRegistered(subtree, context) )
+    {
+        QVectorIterator<QPair< Oid,
+                               QSharedPointer<AbstractVariable> > > iter(vars);
+        while(iter.hasNext())
+        {
+            if( ! isRegistered(iter.next().first, context) )
+            {
+                // Not in a registered area
+                throw(unknown_registration());
+            }
+        }
+    }
+
+    ContextNamespace& n = get_namespace(context);
+    map< Oid, QSharedPointer<AbstractVariable> >& variables = n.variables;
+
+    // Remove variables
     QVectorIterator<Oid> iter(ids);
     while(iter.hasNext())
     {
-        remove_variable(iter.next());
+        n.erase(iter.next()); // If variable was not registered: ignore
+    }
+
+    // Add variables in ascending order, so that each one is inserted next to 
+    // its predecessor (amortized constant time per variable)
+    std::sort(vars.begin(), vars.end(), lessByOid);
+    map< Oid, QSharedPointer<AbstractVariable> >::iterator hint;
+    hint = variables.begin();
+    for(int i = 0; i < vars.size(); i++)
+    {
+        hint = variables.insert(hint, std::make_pair(vars[i].first,
+                                                     vars[i].second));
+        hint->second = vars[i].second; // Replace existing variable
+    }
+}
+
+void MasterProxy::add_subtree_handler(const Oid& subtree,
+                                      QSharedPointer<SubtreeHandler> handler,
+                                      const std::string& context)
+{
+    // Check whether the subtree is contained in a registration
+    if( ! isRegistered(subtree, context) )
+    {
+	// Not in a registered area
+	throw(unknown_registration());
+    }
+    get_namespace(context).handlers[subtree] = handler;
+}
+
+void MasterProxy::remove_subtree_handler(const Oid& subtree,
+                                         const std::string& context)
+{
+    ContextNamespace* n = find_namespace(QByteArray(context.data(),
+                                                    context.size()));
+    if(n)
+    {
+        // Remove handler
+        n->handlers.erase(subtree); // If handler was not added: ignore
     }
 }
 
@@ -1003,3 +1864,474 @@ void MasterProxy::send_notification(const Oid& snmpTrapOID,
             break;
     }
 }
+
+
+
+void MasterProxy::exportStatistics(const Oid& subtree)
+{
+    // Register first, so that the handler is accepted
+    register_subtree(subtree);
+    add_subtree_handler(subtree, QSharedPointer<SubtreeHandler>(
+                new StatisticsHandler(subtree, stats)));
+}
+
+
+/**
+ * \brief The timeout assumed for the master agent's default timeout, in
+ *        seconds.
+ *
+ * RFC 2741 leaves the master agent's default timeout to the implementation.
+ * Net-SNMP uses 1 second.
+ */
+static const quint8 master_default_timeout = 1;
+
+
+void MasterProxy::start_deadline(const Oid& name)
+{
+    deadline = 0;
+    if(! deadline_cutoff)
+    {
+        return;
+    }
+
+    // The master agent uses the timeout of the registration containing the
+    // OID, otherwise the session's default timeout, otherwise its own default
+    // timeout (RFC 2741, 6.2.3. "The agentx-Register-PDU"). Nested
+    // registrations: the longest subtree wins.
+    quint8 timeout = 0;
+    int longest = -1;
+    std::list< QSharedPointer<RegisterPDU> >::const_iterator r;
+    for(r = registrations.begin(); r != registrations.end(); r++)
+    {
+        if((*r)->get_timeout() == 0)
+        {
+            // No specific timeout for this registration
+            continue;
+        }
+        Oid subtree = (*r)->get_subtree();
+        if(subtree.size() > longest && subtree.contains(name))
+        {
+            timeout = (*r)->get_timeout();
+            longest = subtree.size();
+        }
+    }
+    if(timeout == 0)
+    {
+        timeout = default_timeout;
+    }
+    if(timeout == 0)
+    {
+        timeout = master_default_timeout;
+    }
+
+    // Leave the margin for sending the response (but at least half of the
+    // timeout for processing)
+    quint64 total = quint64(timeout) * 1000000;
+    quint64 margin = quint64(deadline_margin) * 1000;
+    if(margin > total / 2)
+    {
+        margin = total / 2;
+    }
+    deadline = AgentStatistics::now() + total - margin;
+}
+
+
+void MasterProxy::setDeadlineCutoff(bool enabled, quint32 margin)
+{
+    deadline_cutoff = enabled;
+    deadline_margin = margin;
+}
+
+
+quint8 MasterProxy::effective_timeout(QSharedPointer<RegisterPDU> r) const
+{
+    if(r->get_timeout() != 0)
+    {
+        return r->get_timeout();
+    }
+    if(default_timeout != 0)
+    {
+        return default_timeout;
+    }
+    return master_default_timeout;
+}
+
+
+void MasterProxy::setAdaptiveTimeouts(bool enabled, quint32 interval)
+{
+    if(enabled)
+    {
+        tuning_timer.start(interval * 1000);
+    }
+    else
+    {
+        tuning_timer.stop();
+        tuners.clear();
+    }
+}
+
+
+/**
+ * \brief Get the priority of a temporary registration.
+ *
+ * Returns the priority next to the given one, preferring the lower 
+ * precedence (i.e. the greater value).
+ */
+static quint8 adjacent_priority(quint8 priority)
+{
+    return priority == 255 ? 254 : priority + 1;
+}
+
+
+quint8 MasterProxy::application_priority(QSharedPointer<RegisterPDU> r) const
+{
+    std::map<const RegisterPDU*, quint8>::const_iterator p;
+    p = application_priorities.find(r.data());
+    return p == application_priorities.end() ? r->get_priority() : p->second;
+}
+
+
+bool MasterProxy::replace_registration(
+        std::list< QSharedPointer<RegisterPDU> >::iterator r,
+        QSharedPointer<RegisterPDU> pdu)
+{
+    try
+    {
+        do_registration(pdu);
+    }
+    catch(...)
+    {
+        // Still registered as before
+        return false;
+    }
+    try
+    {
+        undo_registration(create_unregister_pdu(*r));
+    }
+    catch(...)
+    {
+        // The old registration may remain until the session ends. Both 
+        // registrations are served by this session, so this is harmless.
+    }
+
+    quint8 priority = application_priority(*r);
+    application_priorities.erase(r->data());
+    if(pdu->get_priority() != priority)
+    {
+        application_priorities[pdu.data()] = priority;
+    }
+    *r = pdu;
+    return true;
+}
+
+
+void MasterProxy::tune_timeouts()
+{
+    // The latencies are recorded per subtree, so a subtree registered for 
+    // several contexts is evaluated once and all its registrations get the 
+    // same timeout
+    std::map<Oid, quint8> proposals;
+
+    std::list< QSharedPointer<RegisterPDU> >::iterator r;
+    for(r = registrations.begin(); r != registrations.end(); r++)
+    {
+        if((*r)->get_range_subid() != 0)
+        {
+            // Range registration: not adapted
+            continue;
+        }
+        Oid subtree = (*r)->get_subtree();
+        QSharedPointer<SubtreeStatistics> st = stats.subtree(subtree);
+        if(! st)
+        {
+            continue;
+        }
+        std::map<Oid, quint8>::iterator p = proposals.find(subtree);
+        if(p == proposals.end())
+        {
+            p = proposals.insert(std::make_pair(subtree,
+                    tuners[subtree].update(st->latency(),
+                                           effective_timeout(*r)))).first;
+        }
+        quint8 timeout = p->second;
+        if(timeout == 0 || timeout == effective_timeout(*r))
+        {
+            if((*r)->get_priority() == application_priority(*r))
+            {
+                // Keep the registration
+                continue;
+            }
+
+            // Keep the timeout, but return to the application's priority 
+            // (a previous pass was interrupted)
+            timeout = (*r)->get_timeout();
+        }
+
+        // Re-register with the new timeout. Each new registration is made 
+        // before the old one is removed, so that the subtree stays 
+        // reachable. The master agent rejects a second registration of the 
+        // same region at the same priority, therefore the subtree is first 
+        // moved to a temporary registration at an adjacent priority, and 
+        // then back to the application's priority.
+        quint8 priority = application_priority(*r);
+        if((*r)->get_priority() == priority)
+        {
+            QSharedPointer<RegisterPDU> temporary;
+            temporary = copy_registration(*r, timeout);
+            temporary->set_priority(adjacent_priority(priority));
+            if( ! replace_registration(r, temporary) )
+            {
+                // Still registered with the old timeout
+                continue;
+            }
+        }
+        QSharedPointer<RegisterPDU> pdu = copy_registration(*r, timeout);
+        pdu->set_priority(priority);
+        replace_registration(r, pdu);
+        // (If this fails, the subtree stays registered at the temporary 
+        // priority, and the next tuning pass or reconnect moves it back.)
+    }
+}
+
+
+void MasterProxy::setKeepalive(quint32 interval, quint32 timeout)
+{
+    keepalive_interval = interval;
+    keepalive_timeout = timeout;
+    if(interval == 0)
+    {
+        connection->stopKeepalive();
+    }
+    else if(is_connected())
+    {
+        connection->startKeepalive(sessionID, interval, timeout);
+    }
+}
+
+
+void MasterProxy::setNativeByteOrder(bool enabled)
+{
+    if(enabled == native_byte_order)
+    {
+        return;
+    }
+    native_byte_order = enabled;
+
+    // On big endian hosts, this doesn't change anything
+    connection->setByteOrder(enabled ? host_big_endian : true);
+    if(host_big_endian || ! is_connected())
+    {
+        // The next agentx-Open-PDU uses the new byte order
+        return;
+    }
+
+    // The master agent uses the byte order of the running session until it 
+    // is re-opened. The registrations are kept and restored by connect().
+    try
+    {
+        QSharedPointer<ClosePDU> closepdu(new ClosePDU(sessionID,
+                                                       ClosePDU::reasonOther));
+        connection->request(closepdu);
+    }
+    catch(...)
+    {
+        // Re-open anyway
+    }
+    try
+    {
+        connect();
+    }
+    catch(...)
+    {
+        // Stay disconnected
+    }
+}
+
+
+void MasterProxy::setAutoReconnect(bool enabled,
+                                   quint32 min_delay, quint32 max_delay)
+{
+    connection->setAutoReconnect(enabled, min_delay, max_delay);
+}
+
+
+void MasterProxy::setPrefetch(quint32 depth, quint32 max_age)
+{
+    // Stop the running prefetcher, if any. Its values may be older than 
+    // the new max_age allows.
+    delete prefetcher;
+    prefetcher = 0;
+
+    prefetch_depth = depth;
+    if(depth != 0)
+    {
+        prefetcher = new Prefetcher(quint64(max_age) * 1000);
+    }
+}
+
+
+void MasterProxy::prefetch_ahead(
+        map< Oid, QSharedPointer<AbstractVariable> >::const_iterator pos)
+{
+    if(quint32(prefetcher->pending()) > prefetch_depth / 2)
+    {
+        // Enough values are under way
+        return;
+    }
+
+    // Queue the successors of pos. Variables which are already known to 
+    // the prefetcher are skipped by it.
+    pos++;
+    for(quint32 i = 0; i < prefetch_depth && pos != ns->variables.end(); i++)
+    {
+        prefetcher->enqueue(pos->second);
+        pos++;
+    }
+}
+
+
+void MasterProxy::resume_session()
+{
+    try
+    {
+        connect();
+    }
+    catch(...)
+    {
+        // The master agent is not ready yet: try again later
+        connection->reconnectFailed();
+    }
+}
+
+
+/**
+ * \brief Check the error of a response to an IndexAllocate or 
+ *        IndexDeallocate PDU.
+ *
+ * \exception index_wrong_type, index_already_allocated,
+ *            index_none_available, index_not_allocated,
+ *            unsupported_context, master_is_unable, disconnected,
+ *            parse_error According to the error.
+ */
+static void check_index_error(ResponsePDU::error_t error)
+{
+    switch(error)
+    {
+        case ResponsePDU::noAgentXError:
+            // All went well
+            return;
+
+        // Index-specific errors (RFC 2741, 7.1.4.1 and 7.1.5.1)
+        case ResponsePDU::indexWrongType:
+            throw(index_wrong_type());
+        case ResponsePDU::indexAlreadyAllocated:
+            throw(index_already_allocated());
+        case ResponsePDU::indexNoneAvailable:
+            throw(index_none_available());
+        case ResponsePDU::indexNotAllocated:
+            throw(index_not_allocated());
+
+        // General errors
+        case ResponsePDU::unsupportedContext:
+            throw(unsupported_context());
+        case ResponsePDU::processingError:
+            throw(master_is_unable());
+        case ResponsePDU::notOpen:
+            throw(disconnected());
+
+        default:
+            // The master agent sent an unexpected error
+            throw(parse_error());
+    }
+}
+
+
+/**
+ * \brief Check the response to an IndexAllocate or IndexDeallocate PDU.
+ *
+ * \exception See check_index_error().
+ */
+static void check_index_response(QSharedPointer<ResponsePDU> response)
+{
+    check_index_error(response->get_error());
+}
+
+
+void MasterProxy::IndexAllocation::check() const
+{
+    check_index_error(error);
+}
+
+
+/**
+ * \brief Create an IndexAllocatePDU.
+ */
+static QSharedPointer<IndexAllocatePDU> create_index_allocate_pdu(
+        quint32 sessionID,
+        const std::vector<Varbind>& indexes,
+        MasterProxy::index_allocation_t how)
+{
+    QSharedPointer<IndexAllocatePDU> pdu(new IndexAllocatePDU);
+    pdu->set_sessionID(sessionID);
+    pdu->set_new_index(how == MasterProxy::newIndex);
+    pdu->set_any_index(how == MasterProxy::anyIndex);
+    pdu->get_vb() = indexes;
+    return pdu;
+}
+
+
+std::vector<Varbind> MasterProxy::allocateIndex(
+        const std::vector<Varbind>& indexes, index_allocation_t how)
+{
+    // Send PDU
+    // (forward exceptions timeout_error and disconnected)
+    QSharedPointer<ResponsePDU> response;
+    response = connection->request(
+            create_index_allocate_pdu(sessionID, indexes, how));
+
+    check_index_response(response);
+    return response->varbindlist;
+}
+
+
+std::vector<MasterProxy::IndexAllocation> MasterProxy::allocateIndexes(
+        const std::vector< std::vector<Varbind> >& requests,
+        index_allocation_t how)
+{
+    // Send all PDU's at once
+    // (forward exceptions timeout_error and disconnected)
+    QList< QSharedPointer<PDU> > batch;
+    for(size_t i = 0; i < requests.size(); i++)
+    {
+        batch.append(create_index_allocate_pdu(sessionID, requests[i], how));
+    }
+    QList< QSharedPointer<ResponsePDU> > responses;
+    responses = connection->request_batch(batch);
+
+    // Collect the allocated values and the errors
+    std::vector<IndexAllocation> result(requests.size());
+    for(size_t i = 0; i < requests.size(); i++)
+    {
+        result[i].error = responses[i]->get_error();
+        if(result[i].error == ResponsePDU::noAgentXError)
+        {
+            result[i].indexes = responses[i]->varbindlist;
+        }
+    }
+    return result;
+}
+
+
+void MasterProxy::deallocateIndex(const std::vector<Varbind>& indexes)
+{
+    QSharedPointer<IndexDeallocatePDU> pdu(new IndexDeallocatePDU);
+    pdu->set_sessionID(sessionID);
+    pdu->get_vb() = indexes;
+
+    // Send PDU
+    // (forward exceptions timeout_error and disconnected)
+    QSharedPointer<ResponsePDU> response;
+    response = connection->request(pdu);
+
+    check_index_response(response);
+}
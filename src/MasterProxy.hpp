@@ -21,6 +21,7 @@
 
 #include <string>
 #include <map>
+#include <deque>
 #include <list>
 
 #include <QSharedPointer>
@@ -28,7 +29,10 @@
 
 #include <QObject>
 #include <QThread>
+#include <QTimer>
 #include <QMap>
+#include <QHash>
+#include <QByteArray>
 #include <QVector>
 
 #include "Oid.hpp"
@@ -40,11 +44,17 @@
 #include "UnregisterPDU.hpp"
 #include "GetPDU.hpp"
 #include "GetNextPDU.hpp"
+#include "GetBulkPDU.hpp"
 #include "TestSetPDU.hpp"
 #include "CleanupSetPDU.hpp"
 #include "CommitSetPDU.hpp"
 #include "UndoSetPDU.hpp"
-#include "UnixDomainConnector.hpp"
+#include "Connector.hpp"
+#include "SubtreeHandler.hpp"
+#include "ColumnarTable.hpp"
+#include "AgentStatistics.hpp"
+#include "TimeoutTuner.hpp"
+#include "Prefetcher.hpp"
 
 namespace agentxcpp
 {
@@ -90,6 +100,10 @@ namespace agentxcpp
      * also creates a QThread object for the networking part. Networking is 
      * done within the event loop of that thread.
      *
+     * Applications which run their own event loop (e.g. epoll or libuv) 
+     * can use the embeddedBackend instead (see backend_t and process()). 
+     * Then, no event loop and no additional thread are needed.
+     *
      */
     /**
      * \par Registrations
@@ -136,12 +150,10 @@ namespace agentxcpp
      * When unregistering, the matching RegisterPDU is removed from the 
      * registration member.
      *
-     * The MasterProxy::registration member becomes invalid on connection loss.
-     * Since a
-     * connection loss is not signaled, the member cannot be cleared in such
-     * situations. Therefore, it is cleared in the connect() method if the 
-     * object is currently disconnected. If connect() is called on a connected 
-     * MasterProxy object, the registrations member is not cleared.
+     * The master agent forgets the registrations of a session when the 
+     * session ends. The MasterProxy::registrations member is kept 
+     * nevertheless, and connect() registers all of them again for the new 
+     * session (see restore_registrations()).
      *
      * \endinternal
      */
@@ -167,24 +179,54 @@ namespace agentxcpp
      *
      * When removing a variable, it is removed from the variables member.
      *
-     * The variables member becomes invalid on connection loss. Since a 
-     * connection loss is not signaled, the member cannot be cleared in such
-     * situations.  Therefore, it is cleared in the connect() method if the 
-     * object is currently disconnected. If connect() is called on a connected 
-     * MasterProxy object, the variables member is not cleared.
+     * The variables member (like the subtree handlers) is kept across 
+     * reconnects, so that the subagent resumes service with the same 
+     * variables as soon as the registrations are restored.
      *
      * \endinternal
      *
      */
+    /**
+     * \anchor contexts
+     * \par Contexts
+     *
+     * SNMP allows an agent to provide several instances of a MIB, each in 
+     * its own context (e.g. one per VRF or per virtual router). A single 
+     * MasterProxy can serve any number of contexts: register_subtree(), 
+     * add_variable(), add_subtree_handler() and the related functions take 
+     * an optional context name. The variables and handlers of each context 
+     * are kept apart, and a request is answered from the variables and 
+     * handlers of the context it names. The empty string denotes the 
+     * default context, which is used if no context is given.
+     *
+     * \code
+     * master.register_subtree(ifTable_oid, 127, 0, "vrf-red");
+     * master.add_variable(ifNumber_oid, ifNumber_red, "vrf-red");
+     * \endcode
+     *
+     * Requests for a context which is not known to the MasterProxy are 
+     * answered with an unsupportedContext error.
+     *
+     * \internal
+     *
+     * Each context is represented by a ContextNamespace, which holds the 
+     * variables and handlers of the context. A context name is mapped 
+     * (interned) to a number once, when it is first used; the number is 
+     * the position of the context's namespace within the namespaces member.  
+     * The default context always has number 0. When a PDU arrives, its 
+     * context is looked up in a hash table, so that selecting the namespace 
+     * takes constant time regardless of the number of contexts.
+     *
+     * \endinternal
+     */
     /**
      * \internal
      *
      * \par Internals
      * 
-     * Receiving and processing PDU's coming from the master is done using the 
-     * UnixDomainConnector class. The MasterProxy implements the handle_pdu() 
-     * slot, which is connected to the UnixDomainConnector::pduArrived() 
-     * signal.
+     * Receiving and processing PDU's coming from the master is done using a 
+     * Connector (see backend_t). The MasterProxy implements the handle_pdu() 
+     * slot, which is connected to the Connector::pduArrived() signal.
      *
      * \endinternal
      *
@@ -201,7 +243,7 @@ namespace agentxcpp
              * \brief The thread running a UnixDomainConnector.
              *
              * The UnixDomainConnector object is moved into this thread after 
-             * creation.
+             * creation. The thread is not started for other backends.
              */
             QThread m_thread;
 
@@ -215,7 +257,7 @@ namespace agentxcpp
 	     *
 	     * Created by constructors, destroyed by destructor.
 	     */
-	    UnixDomainConnector* connection;
+	    Connector* connection;
 
 	    /**
 	     * \brief The session ID of the current session.
@@ -253,10 +295,156 @@ namespace agentxcpp
 	     */
 	    std::list< QSharedPointer<RegisterPDU> > registrations;
 
-	    /**
-	     * \brief Storage for all SNMP variables known to the MasterProxy.
-	     */
-	    std::map< Oid, QSharedPointer<AbstractVariable> > variables;
+            /**
+             * \brief The priorities chosen by the application for 
+             *        registrations which are registered at another priority.
+             *
+             * tune_timeouts() registers the new timeout at an adjacent 
+             * priority before the old registration is removed. This map 
+             * keeps the application's priority of such registrations, so 
+             * that unregister_subtree() finds them and restore_registrations() 
+             * returns to the application's priority.
+             */
+            std::map<const RegisterPDU*, quint8> application_priorities;
+
+            /**
+             * \brief Get the priority chosen by the application for a 
+             *        registration (see application_priorities).
+             */
+            quint8 application_priority(QSharedPointer<RegisterPDU> r) const;
+
+            /**
+             * \brief Replace a registration by another one for the same 
+             *        region.
+             *
+             * The new registration is made before the old one is removed. 
+             * The application's priority of the registration is kept.
+             *
+             * \param r The registration to replace.
+             *
+             * \param pdu The new registration (must differ in priority).
+             *
+             * \return false if the new registration failed (the old one 
+             *         stays in place), true otherwise.
+             */
+            bool replace_registration(
+                    std::list< QSharedPointer<RegisterPDU> >::iterator r,
+                    QSharedPointer<RegisterPDU> pdu);
+
+            /**
+             * \brief The variables and subtree handlers of a context.
+             */
+            struct ContextNamespace
+            {
+                /**
+                 * \brief Storage for the SNMP variables of the context.
+                 */
+                std::map< Oid, QSharedPointer<AbstractVariable> > variables;
+
+                /**
+                 * \brief The subtree handlers of the context.
+                 *
+                 * The key is the subtree served by the handler. The OID's
+                 * served by the handlers are not contained in the
+                 * variables member; requests for them are forwarded to the
+                 * handler.
+                 */
+                std::map< Oid, QSharedPointer<SubtreeHandler> > handlers;
+
+                /**
+                 * \brief The variable found by the last search of
+                 *        find_next() (the walk cursor).
+                 *
+                 * During a walk, the master agent asks for the successor
+                 * of the OID returned before. find_next() then continues
+                 * at the cursor instead of searching the variables map
+                 * again. Only valid if cursor_valid is true.
+                 */
+                std::map< Oid, QSharedPointer<AbstractVariable> >
+                    ::const_iterator cursor;
+
+                /**
+                 * \brief Whether cursor is valid.
+                 */
+                bool cursor_valid;
+
+                /**
+                 * \brief Constructor.
+                 */
+                ContextNamespace()
+                : cursor_valid(false)
+                {
+                }
+
+                /**
+                 * \brief Remove a variable.
+                 *
+                 * Variables must be removed using this function, so that
+                 * the cursor is invalidated if it points to the removed
+                 * variable. (Adding variables does not affect the cursor.)
+                 */
+                void erase(const Oid& id)
+                {
+                    if(cursor_valid && cursor->first == id)
+                    {
+                        cursor_valid = false;
+                    }
+                    variables.erase(id);
+                }
+            };
+
+            /**
+             * \brief The namespaces of all known contexts.
+             *
+             * The position of a namespace is the number of its context (see
+             * context_ids). Position 0 is the default context. A deque is
+             * used, so that adding a context does not move the existing
+             * namespaces.
+             */
+            std::deque<ContextNamespace> namespaces;
+
+            /**
+             * \brief The numbers of the known contexts, by name.
+             *
+             * The default context is not contained.
+             */
+            QHash<QByteArray, quint32> context_ids;
+
+            /**
+             * \brief The namespace of the request being processed.
+             *
+             * Set by handle_pdu() according to the context of the request.
+             */
+            ContextNamespace* ns;
+
+            /**
+             * \brief Get the namespace of a context, creating it if needed.
+             */
+            ContextNamespace& get_namespace(const std::string& context);
+
+            /**
+             * \brief Find the namespace of a context.
+             *
+             * \param context The context name. The empty name denotes the
+             *                default context.
+             *
+             * \return The namespace, or 0 if the context is unknown.
+             */
+            ContextNamespace* find_namespace(const QByteArray& context);
+
+            /**
+             * \brief Find the handler responsible for an OID.
+             *
+             * If several subtrees contain the OID, the handler of the
+             * longest subtree is responsible (longest-prefix match).
+             *
+             * The handlers of the namespace ns are searched.
+             *
+             * \return The handler, or ns->handlers.end() if no handler is
+             *         responsible for the OID.
+             */
+            std::map< Oid, QSharedPointer<SubtreeHandler> >::const_iterator
+            find_handler(const Oid& name) const;
 
             /**
              * \brief The variables affected by the Set operation currently
@@ -270,6 +458,141 @@ namespace agentxcpp
              */
             std::list< QSharedPointer<AbstractVariable> > setlist;
 
+            /**
+             * \brief The runtime statistics (see statistics()).
+             */
+            AgentStatistics stats;
+
+            /**
+             * \brief The deadline of the request being processed.
+             *
+             * The deadline is a time as returned by AgentStatistics::now(),
+             * or 0 if the request has no deadline. It is set by
+             * start_deadline().
+             */
+            quint64 deadline;
+
+            /**
+             * \brief Whether requests are cut off at their deadline (see
+             *        setDeadlineCutoff()).
+             */
+            bool deadline_cutoff;
+
+            /**
+             * \brief The time reserved for sending the response, in
+             *        milliseconds (see setDeadlineCutoff()).
+             */
+            quint32 deadline_margin;
+
+            /**
+             * \brief The prefetcher (see setPrefetch()), or 0 if 
+             *        prefetching is disabled.
+             */
+            Prefetcher* prefetcher;
+
+            /**
+             * \brief How many variables are prefetched ahead of a walk.
+             */
+            quint32 prefetch_depth;
+
+            /**
+             * \brief Queue the variables following a walk's current 
+             *        position for prefetching.
+             *
+             * Called by find_next() when a walk continues at the cursor. 
+             * The variables following pos in the namespace ns are passed to 
+             * the prefetcher, up to prefetch_depth of them. To avoid a 
+             * new batch for each request, nothing happens while at least 
+             * half of the previous batch is outstanding.
+             *
+             * \param pos The variable found by find_next().
+             */
+            void prefetch_ahead(std::map< Oid,
+                                QSharedPointer<AbstractVariable> >
+                                ::const_iterator pos);
+
+            /**
+             * \brief Update a variable for a Get, GetNext or GetBulk 
+             *        request.
+             *
+             * Uses the value fetched by the prefetcher if there is a recent 
+             * one, and calls var->handle_get() otherwise.
+             */
+            void update_variable(QSharedPointer<AbstractVariable> var)
+            {
+                if( ! prefetcher || ! prefetcher->claim(var) )
+                {
+                    var->handle_get();
+                }
+            }
+
+            /**
+             * \brief Set the deadline for the request being processed.
+             *
+             * The deadline is derived from the timeout which the master
+             * agent applies to the request, minus deadline_margin.
+             *
+             * \param name The OID of the first varbind of the request. The
+             *             master agent uses the timeout of the registration
+             *             containing it.
+             */
+            void start_deadline(const Oid& name);
+
+            /**
+             * \brief Check whether the deadline of the request being
+             *        processed has passed.
+             */
+            bool deadline_passed() const
+            {
+                return deadline != 0 && AgentStatistics::now() >= deadline;
+            }
+
+            /**
+             * \brief Triggers tune_timeouts() (see setAdaptiveTimeouts()).
+             */
+            QTimer tuning_timer;
+
+            /**
+             * \brief The timeout tuners of the registered subtrees.
+             */
+            std::map<Oid, TimeoutTuner> tuners;
+
+            /**
+             * \brief Get the timeout the master agent applies to a
+             *        registration, in seconds.
+             *
+             * This is the timeout of the registration, otherwise the
+             * session's default timeout, otherwise the master agent's
+             * default timeout.
+             */
+            quint8 effective_timeout(QSharedPointer<RegisterPDU> r) const;
+
+            /**
+             * \brief The keepalive interval in milliseconds, or 0 (see
+             *        setKeepalive()).
+             */
+            quint32 keepalive_interval;
+
+            /**
+             * \brief The keepalive timeout in milliseconds (see
+             *        setKeepalive()).
+             */
+            quint32 keepalive_timeout;
+
+            /**
+             * \brief Whether the host's byte order is used on the wire (see
+             *        setNativeByteOrder()).
+             */
+            bool native_byte_order;
+
+            /**
+             * \brief Register the subtrees of the registrations member for
+             *        the current session.
+             *
+             * \exception disconnected If the master agent does not respond.
+             */
+            void restore_registrations();
+
 	    /**
 	     * \brief Send a RegisterPDU to the master agent.
 	     *
@@ -392,6 +715,48 @@ namespace agentxcpp
              */
             void handle_getnextpdu(QSharedPointer<ResponsePDU> response, QSharedPointer<GetNextPDU> getnext_pdu);
 
+            /**
+             * \brief Handle incoming GetBulkPDU's.
+             *
+             * This method is called by handle_pdu(). It processes the given 
+             * GetBulkPDU and stores the results in the given ResponsePDU 
+             * (i.e. it adds Varbinds to the ResponsePDU).
+             *
+             * \param response The pre-initialized ResponsePDU. Varbinds are
+             *                 added to this PDU during processing.
+             *
+             * \param getbulk_pdu The GetBulkPDU to be processed.
+             */
+            void handle_getbulkpdu(QSharedPointer<ResponsePDU> response, QSharedPointer<GetBulkPDU> getbulk_pdu);
+
+            /**
+             * \brief Find the lexicographical successor of an OID.
+             *
+             * This method searches the variables and the subtree handlers of
+             * the namespace ns for the
+             * object following starting_oid (or, if starting_oid.include() is
+             * true, for starting_oid itself or its successor). The found
+             * object must precede ending_oid, unless ending_oid is the null
+             * OID.
+             *
+             * This is the search performed for a single SearchRange of a
+             * GetNext or GetBulk request (RFC 2741, 7.2.3.2).
+             *
+             * \param starting_oid The starting OID of the SearchRange.
+             *
+             * \param ending_oid The ending OID of the SearchRange.
+             *
+             * \param name Receives the OID of the found object.
+             *
+             * \param var Receives the found object.
+             *
+             * \return true if an object was found, false otherwise.
+             */
+            bool find_next(const Oid& starting_oid,
+                           const Oid& ending_oid,
+                           Oid& name,
+                           QSharedPointer<AbstractVariable>& var);
+
             /**
              * \brief Handle incoming TestSetPDU's.
              *
@@ -436,13 +801,34 @@ namespace agentxcpp
              */
             void handle_undosetpdu(QSharedPointer<ResponsePDU> response, QSharedPointer<UndoSetPDU> undoset_pdu);
 
+	private slots:
+	    /**
+	     * \brief Adjust the timeouts of the registrations to the 
+	     *        measured latencies.
+	     *
+	     * Called periodically if enabled with setAdaptiveTimeouts(). Each 
+	     * registration whose TimeoutTuner proposes a new timeout is 
+	     * unregistered and registered again with the new timeout. If the 
+	     * new registration fails, the old one is restored.
+	     */
+	    void tune_timeouts();
+
+	    /**
+	     * \brief Open a new session after an automatic reconnect.
+	     *
+	     * Connected to Connector::reconnected(). Calls 
+	     * connect(), which restores the registrations. If that fails, the 
+	     * connector is told to try again later.
+	     */
+	    void resume_session();
+
 	public slots:
 	    /**
              * \internal
              *
 	     * \brief The dispatcher for incoming %PDU's.
 	     *
-             * This slot is connected to UnixDomainConnector::pduArrived() and 
+             * This slot is connected to Connector::pduArrived() and 
              * thus called for each incoming PDU (except ResponsePDU's).
              *
              * This method performs the steps described in RFC 2741, 7.2.2.  
@@ -525,6 +911,68 @@ namespace agentxcpp
 	        send_notification(snmpTrapOID, 0, varbinds);
 	    }
 
+	public:
+
+	    /**
+	     * \brief The implementations of the connection to the master 
+	     *        agent.
+	     */
+	    enum backend_t
+	    {
+		/**
+		 * \brief A QLocalSocket in a separate thread running a Qt 
+		 *        event loop.
+		 *
+		 * This is the default.
+		 */
+		qtBackend,
+
+		/**
+		 * \brief A non-blocking socket driven by epoll (Linux only).
+		 *
+		 * %PDU's are written directly by the sending thread and read 
+		 * by an I/O thread which doesn't run a Qt event loop, so that 
+		 * requests and responses take fewer thread switches and 
+		 * allocations. Only the requests from the master agent are 
+		 * delivered to the MasterProxy's thread as queued signals, 
+		 * like with qtBackend.
+		 */
+		epollBackend,
+
+		/**
+		 * \brief Like epollBackend, but driven by the application's 
+		 *        event loop (Linux only).
+		 *
+		 * There is no I/O thread. The application watches 
+		 * fileDescriptor() for readability and calls process() when 
+		 * it becomes readable or when processTimeout() expired. The 
+		 * requests from the master agent are then handled inline in 
+		 * the application's thread, without thread switches. See 
+		 * process().
+		 */
+		embeddedBackend,
+
+		/**
+		 * \brief A socket driven by io_uring (Linux 5.19 or later).
+		 *
+		 * Like epollBackend, but the data is received into 
+		 * preregistered buffers without a system call per read, and 
+		 * %PDU's sent while a send is in flight are sent together. 
+		 * This reduces the number of system calls at high request 
+		 * rates. The library must be built with 
+		 * <tt>--with-io-uring</tt>. If it wasn't, or if io_uring is 
+		 * not available at runtime, epollBackend is used instead (see 
+		 * backend()).
+		 */
+		uringBackend
+	    };
+
+	private:
+	    /**
+	     * \brief The backend used (see backend()).
+	     */
+	    backend_t used_backend;
+
 	public:
 
             /**
@@ -554,11 +1002,20 @@ namespace agentxcpp
              *                           Defaults to /var/agentx/master, as 
              *                           described in RFC 2741, section 8.2.1 
              *                           "Well-known Values".
+	     *
+	     * \param backend The implementation of the connection.
+	     *
+	     * \param native_byte_order Whether to use the host's byte order on 
+	     *                          the wire, see setNativeByteOrder(). 
+	     *                          Passing it here ensures that already 
+	     *                          the first session is opened with it.
 	     */
 	    MasterProxy(std::string description="",
 		   quint8 default_timeout=0,
 		   Oid ID=Oid(),
-		   std::string unix_domain_socket="/var/agentx/master");
+		   std::string unix_domain_socket="/var/agentx/master",
+		   backend_t backend=qtBackend,
+		   bool native_byte_order=false);
 
 	    /**
 	     * \brief Register a subtree with the master agent
@@ -584,9 +1041,15 @@ namespace agentxcpp
 	     *		      according to RFC 2741, 6.2.3.  "The 
 	     *		      agentx-Register-PDU".
 	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
 	     * \exception disconnected If the MasterProxy is currently in
 	     *                         state 'disconnected'.
 	     *
+	     * \exception unsupported_context If the master agent does not
+	     *                                support the context.
+	     *
 	     * \exception timeout_exception If the master agent does not
 	     *                              respond within the timeout 
 	     *                              interval.
@@ -616,7 +1079,8 @@ namespace agentxcpp
 	     */
 	    void register_subtree(Oid subtree,
 				  quint8 priority=127,
-				  quint8 timeout=0);
+				  quint8 timeout=0,
+				  const std::string& context=std::string());
 
 	    /**
 	     * \brief Unregister a subtree with the master agent
@@ -636,6 +1100,9 @@ namespace agentxcpp
 	     * \param priority The priority with which the registration was
              *                 done.
 	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
 	     * \exception disconnected If the MasterProxy is currently in
 	     *                         state 'disconnected'.
 	     *
@@ -660,7 +1127,8 @@ namespace agentxcpp
             // TODO: the 'priority' parameter can possibly be omitted: the 
             // value can be stored by master_agent upon subtree registration.
 	    void unregister_subtree(Oid subtree,
-				    quint8 priority=127);
+				    quint8 priority=127,
+				    const std::string& context=std::string());
 
             /**
 	     * \brief Check whether the session is in state connected
@@ -679,7 +1147,18 @@ namespace agentxcpp
              *       automatically established. If the current state is 
              *       "connected", the function does nothing.
 	     *
-	     * \exception disconnected If connecting fails.
+	     * The variables and subtree handlers which were added before are 
+	     * kept, and the subtrees which were registered in the previous 
+	     * session are registered again. The registrations are sent in one 
+	     * batch, without waiting for the response to a registration 
+	     * before sending the next one. Registrations which are refused by 
+	     * the master agent are dropped. The time until the session is 
+	     * fully restored is reported by AgentStatistics::timeToService().
+	     *
+	     * \exception disconnected If connecting fails, or if the master 
+	     *                         agent does not respond to the 
+	     *                         registrations. The registrations are 
+	     *                         kept for the next attempt.
 	     */
 	    void connect();
 
@@ -755,12 +1234,16 @@ namespace agentxcpp
 	     *
 	     * \param v The variable.
 	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
 	     * \exception unknown_registration If trying to add a variable
 	     *                                 with an id which does not reside 
-	     *                                 within a registered MIB 
-	     *                                 region.
+	     *                                 within a MIB region registered 
+	     *                                 for the context.
 	     */
-	    void add_variable(const Oid& id, QSharedPointer<AbstractVariable> v);
+	    void add_variable(const Oid& id, QSharedPointer<AbstractVariable> v,
+			      const std::string& context=std::string());
 
 	    /**
 	    * \brief Add several SNMP variables for serving.
@@ -774,6 +1257,9 @@ namespace agentxcpp
 	    *             agentxcpp::add_variable(const Oid&,
 	    *             QSharedPointer<AbstractVariable>) for an explanation.
 	    *
+	    * \param context The context, or the empty string for the default
+	    *                context (see \ref contexts).
+	    *
 	    * \exception unknown_registration If trying to add a variable
 	    *                                 with an id which does not reside
 	    *                                 within a registered MIB
@@ -782,7 +1268,8 @@ namespace agentxcpp
 	    */
 	    void addVariables(QVector< QPair<
 	                      Oid, QSharedPointer<AbstractVariable> >
-	                                  > vars);
+	                                  > vars,
+	                      const std::string& context=std::string());
 
 	    /**
 	     * \brief Remove an SNMP variable so that is not longer accessible.
@@ -795,9 +1282,13 @@ namespace agentxcpp
 	     * \param id The OID of the variable to remove. This is the OID
 	     *           which was given to add_variable().
 	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
 	     * \exception None.
 	     */
-	    void remove_variable(const Oid& id);
+	    void remove_variable(const Oid& id,
+				 const std::string& context=std::string());
 
 	    /**
 	     * \brief Remove several SNMP variables so that they are not longer
@@ -809,9 +1300,136 @@ namespace agentxcpp
              *
              * \param ids The variables to be removed.
              *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+             *
              * \exception None.
 	     */
-	    void removeVariables(const QVector<Oid>& ids);
+	    void removeVariables(const QVector<Oid>& ids,
+				 const std::string& context=std::string());
+
+	    /**
+	     * \brief Remove and add SNMP variables in one go.
+	     *
+	     * This is a faster variant of removeVariables() followed by 
+	     * addVariables(), intended for updating many variables at once 
+	     * (e.g. by Table::sync()). The registrations are checked before 
+	     * anything is changed: if the given subtree lies within a 
+	     * registered MIB region, all variables are accepted without 
+	     * further checks; otherwise each added variable is checked.
+	     *
+	     * \param subtree A common prefix of the OID's of all added 
+	     *                variables.
+	     *
+	     * \param ids The OID's of the variables to be removed.
+	     *
+	     * \param vars The variables to be added, see addVariables(). A 
+	     *             variable replaces a variable with the same OID.
+	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
+	     * \exception unknown_registration If trying to add a variable
+	     *                                 with an id which does not 
+	     *                                 reside within a registered MIB 
+	     *                                 region. No variable is removed 
+	     *                                 or added in this case.
+	     */
+	    void updateVariables(const Oid& subtree,
+				 const QVector<Oid>& ids,
+				 QVector< QPair<
+				 Oid, QSharedPointer<AbstractVariable> >
+				 > vars,
+				 const std::string& context=std::string());
+
+	    /**
+	     * \brief Add a handler for a subtree.
+	     *
+	     * All Get, GetNext and GetBulk requests for OID's within the 
+	     * subtree are forwarded to the handler, except for OID's of 
+	     * variables added with add_variable(). No per-instance registration 
+	     * is needed, so the set of objects served by the handler may 
+	     * change at any time. See SubtreeHandler for details.
+	     *
+	     * Handlers may be added for nested subtrees. The handler with the 
+	     * longest matching subtree OID is responsible for an OID.
+	     *
+	     * If a handler for the same subtree was added before, it is 
+	     * replaced.
+	     *
+	     * \param subtree The subtree to be served by the handler.
+	     *
+	     * \param handler The handler.
+	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
+	     * \exception unknown_registration If the subtree does not reside 
+	     *                                 within a MIB region registered 
+	     *                                 for the context.
+	     */
+	    void add_subtree_handler(const Oid& subtree,
+				     QSharedPointer<SubtreeHandler> handler,
+				     const std::string& context=std::string());
+
+	    /**
+	     * \brief Remove the handler of a subtree.
+	     *
+	     * If no handler is known for the given subtree, nothing happens.
+	     *
+	     * \param subtree The subtree.
+	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
+	     * \exception None.
+	     */
+	    void remove_subtree_handler(const Oid& subtree,
+					const std::string& context=std::string());
+
+	    /**
+	     * \brief Add a ColumnarTable for serving.
+	     *
+	     * The cells of the table become accessible for the master agent.  
+	     * Unlike the Table class, a ColumnarTable is not expanded into 
+	     * variables. Instead, the table is added as the handler of its 
+	     * subtree (see add_subtree_handler()). Rows added to or removed 
+	     * from the table later on are therefore visible immediately.
+	     *
+	     * If a table with the same OID was added before, it is replaced.
+	     *
+	     * \param table The table.
+	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
+	     * \exception unknown_registration If the table's OID does not
+	     *                                 reside within a MIB region 
+	     *                                 registered for the context.
+	     */
+	    void add_table(QSharedPointer<ColumnarTable> table,
+			   const std::string& context=std::string())
+	    {
+		add_subtree_handler(table->oid(), table, context);
+	    }
+
+	    /**
+	     * \brief Remove a ColumnarTable so that is not longer accessible.
+	     *
+	     * If no table is known for the given OID, nothing happens.
+	     *
+	     * \param oid The OID of the table.
+	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
+	     * \exception None.
+	     */
+	    void remove_table(const Oid& oid,
+			      const std::string& context=std::string())
+	    {
+		remove_subtree_handler(oid, context);
+	    }
 
 	    /**
 	     * \brief Check whether an OID is within the registered ranges.
@@ -821,11 +1439,491 @@ namespace agentxcpp
 	     *
 	     * \param id The OID to check.
 	     *
+	     * \param context The context, or the empty string for the default 
+	     *                context (see \ref contexts).
+	     *
 	     * \return true if it is with an registered range, false otherwise.
 	     *
 	     * \exception None.
 	     */
-	    bool isRegistered(Oid id);
+	    bool isRegistered(Oid id, const std::string& context=std::string());
+
+	    /**
+	     * \brief Get the runtime statistics of the subagent.
+	     *
+	     * The statistics count the handled PDU's, the transferred bytes 
+	     * and the time spent in the callbacks of the variables, see 
+	     * AgentStatistics.
+	     *
+	     * \exception None.
+	     */
+	    const AgentStatistics& statistics() const
+	    {
+		return stats;
+	    }
+
+	    /**
+	     * \brief Export the runtime statistics as a MIB subtree.
+	     *
+	     * The subtree is registered with the master agent, so that the 
+	     * statistics returned by statistics() can be read via SNMP. The 
+	     * layout of the subtree is described in StatisticsHandler. The 
+	     * subtree is usually located below the enterprise OID of the 
+	     * application, e.g. 1.3.6.1.4.1.\<enterprise\>.\<agentStats\>.
+	     *
+	     * \param subtree The subtree.
+	     *
+	     * \exception disconnected, timeout_error, master_is_unable, 
+	     *            duplicate_registration, master_is_unwilling, 
+	     *            parse_error See register_subtree().
+	     */
+	    void exportStatistics(const Oid& subtree);
+
+	    /**
+	     * \brief Configure the deadline of requests.
+	     *
+	     * The master agent regards the subagent as not responding if a 
+	     * request is not answered within a timeout; a late response is 
+	     * lost and the master agent may close the session. The timeout 
+	     * is the one given to register_subtree() for the subtree 
+	     * containing the first varbind of the request, otherwise the 
+	     * default_timeout given to the constructor, otherwise the master 
+	     * agent's own default (assumed to be 1 second).
+	     *
+	     * Each Get, GetNext and GetBulk request gets a deadline, which is 
+	     * the timeout minus the given margin. The deadline is checked 
+	     * before each variable callback. When it has passed:
+	     * - Get and GetNext requests are answered with the varbinds 
+	     *   processed so far and the error genErr, whose index is the 
+	     *   first unprocessed varbind.
+	     * - GetBulk requests stop the repetitions early and are answered 
+	     *   without error (unless the non-repeaters were not yet 
+	     *   completed).
+	     *
+	     * A callback which is already running is not interrupted. Such 
+	     * requests are counted by AgentStatistics::deadlineCutoffs(), and 
+	     * slow callbacks are logged by AgentStatistics::slowCallbacks().
+	     *
+	     * The cutoff is enabled by default, with a margin of 100 
+	     * milliseconds.
+	     *
+	     * \param enabled Whether requests are cut off at their deadline.
+	     *
+	     * \param margin The time reserved for sending the response, in 
+	     *               milliseconds. At most half of the timeout is 
+	     *               reserved.
+	     *
+	     * \exception None.
+	     */
+	    void setDeadlineCutoff(bool enabled, quint32 margin = 100);
+
+	    /**
+	     * \brief Set the duration above which a callback is logged as 
+	     *        slow.
+	     *
+	     * See AgentStatistics::setSlowCallbackThreshold().
+	     *
+	     * \param milliseconds The threshold. 0 disables the slow callback 
+	     *                     log.
+	     *
+	     * \exception None.
+	     */
+	    void setSlowCallbackThreshold(quint32 milliseconds)
+	    {
+		stats.setSlowCallbackThreshold(quint64(milliseconds) * 1000);
+	    }
+
+	    /**
+	     * \brief Adapt the timeouts of the registrations to the measured 
+	     *        latencies.
+	     *
+	     * The timeout given to register_subtree() tells the master agent 
+	     * how long to wait for responses concerning the subtree. A 
+	     * timeout too short makes the master agent give up on slow 
+	     * subtrees (e.g. hardware sensors), a timeout too long makes it 
+	     * wait needlessly when the subagent really hangs.
+	     *
+	     * If enabled, the MasterProxy periodically evaluates the callback 
+	     * latencies of each registered subtree (see 
+	     * AgentStatistics::subtree()) and sets the registration's timeout 
+	     * to twice the 99th percentile, rounded up to whole seconds. The 
+	     * timeout is raised as soon as the percentile requires it, but 
+	     * lowered only if it can be halved, and only subtrees with at 
+	     * least TimeoutTuner::min_samples callbacks since the last 
+	     * evaluation are evaluated.
+	     *
+	     * The master agent rejects a second registration of a subtree at 
+	     * the same priority, so a timeout is changed in two steps: the 
+	     * subtree is registered with the new timeout at the adjacent 
+	     * priority (the priority plus one, or 254 for priority 255) and the 
+	     * old registration is removed; then the subtree is registered at 
+	     * the priority given to register_subtree() and the temporary 
+	     * registration is removed. The subtree stays reachable throughout, 
+	     * but while the temporary registration is active, its precedence 
+	     * against other subagents differs from the requested one. If the 
+	     * second step fails, the temporary registration stays until the 
+	     * next evaluation or reconnect; unregister_subtree() still expects 
+	     * the original priority.
+	     *
+	     * The evaluation happens in the thread running the MasterProxy's 
+	     * event loop. Range registrations are not adapted.
+	     *
+	     * Adaptive timeouts are disabled by default.
+	     *
+	     * \param enabled Whether to adapt the timeouts.
+	     *
+	     * \param interval The time between two evaluations, in seconds.
+	     *
+	     * \exception None.
+	     */
+	    void setAdaptiveTimeouts(bool enabled, quint32 interval = 60);
+
+	    /**
+	     * \brief Detect a dead master agent with PingPDU's.
+	     *
+	     * Without keepalive, a dead master agent is only noticed when 
+	     * sending fails. With keepalive, the connector sends a PingPDU 
+	     * whenever nothing was received from the master agent for 
+	     * interval milliseconds, and regards the connection as lost if 
+	     * nothing is received within timeout milliseconds after that. A 
+	     * dead master agent is thus detected within interval + timeout 
+	     * milliseconds. Threads waiting for a response from the master 
+	     * agent (e.g. in register_subtree()) then get a disconnected 
+	     * exception.
+	     *
+	     * The PingPDU's are sent from the connector's thread. The setting 
+	     * is kept across reconnects. Keepalive is disabled by default.
+	     *
+	     * \param interval The idle time before a PingPDU is sent, in 
+	     *                 milliseconds. 0 disables the keepalive.
+	     *
+	     * \param timeout The time to wait for the master agent's answer, 
+	     *                in milliseconds.
+	     *
+	     * \exception None.
+	     */
+	    void setKeepalive(quint32 interval, quint32 timeout = 1000);
+
+	    /**
+	     * \brief Use the host's byte order on the wire.
+	     *
+	     * By default, all PDU's are encoded in big endian format (network 
+	     * byte order), which must be converted byte by byte on little 
+	     * endian hosts. RFC 2741 lets the subagent choose the byte order 
+	     * of its PDU's, and the master agent uses the byte order of the 
+	     * agentx-Open-PDU for the PDU's it sends during the session 
+	     * (7.1.1. "Processing the agentx-Open-PDU"). If enabled, the 
+	     * agentx-Open-PDU and all responses are encoded in the host's byte 
+	     * order, so that OID's and numbers are copied with memcpy() 
+	     * instead of being converted. Other PDU's sent by the subagent 
+	     * (e.g. registrations and notifications) stay in big endian 
+	     * format.
+	     *
+	     * Values are encoded by AbstractVariable::serialize_to(), which all 
+	     * variable types of the library implement for both byte orders. 
+	     * An application class which overrides serialize() must override 
+	     * serialize_to() as well, otherwise its values are encoded in big 
+	     * endian within a PDU declared to be in the host's byte order.
+	     *
+	     * The master agent keeps the byte order of the agentx-Open-PDU for 
+	     * the whole session. Therefore, if the setting changes while 
+	     * connected, the session is closed and re-opened (restoring the 
+	     * registrations, see connect()). To avoid this, pass the setting 
+	     * to the constructor instead. Native byte order is disabled by 
+	     * default.
+	     *
+	     * \param enabled Whether to use the host's byte order.
+	     *
+	     * \exception None.
+	     */
+	    void setNativeByteOrder(bool enabled);
+
+	    /**
+	     * \brief Reconnect automatically after a connection loss.
+	     *
+	     * If enabled, the connector tries to reconnect to the master 
+	     * agent after the connection was lost (see also setKeepalive()). 
+	     * The first attempt is made after min_delay milliseconds, and the 
+	     * delay is doubled after each failed attempt, up to max_delay 
+	     * milliseconds. The attempts are made in the connector's thread, 
+	     * so that no application thread is blocked while the master agent 
+	     * is unavailable. When the socket is connected, a new session is 
+	     * opened and the registrations are restored (see connect()) in the 
+	     * thread running the MasterProxy's event loop.
+	     *
+	     * Automatic reconnect is disabled by default.
+	     *
+	     * \param enabled Whether to reconnect automatically.
+	     *
+	     * \param min_delay The delay before the first attempt, in 
+	     *                  milliseconds.
+	     *
+	     * \param max_delay The maximum delay between two attempts, in 
+	     *                  milliseconds.
+	     *
+	     * \exception None.
+	     */
+	    void setAutoReconnect(bool enabled,
+	                          quint32 min_delay = 1000,
+	                          quint32 max_delay = 60000);
+
+	    /**
+	     * \brief Fetch values ahead of walks.
+	     *
+	     * A manager walking a table sends a sequence of GetNext or GetBulk 
+	     * requests, each starting where the previous one ended. When such 
+	     * a sequence is detected (a request continues behind the variable 
+	     * returned by the previous one), the following 
+	     * variables are updated in advance in a background thread by 
+	     * calling their handle_get() method. When they are requested, the 
+	     * fetched values are returned without calling handle_get() again. 
+	     * This hides the latency of slow get handlers (e.g. those which 
+	     * query hardware) from the master agent.
+	     *
+	     * At most depth variables are fetched ahead of the walk. A fetched 
+	     * value is used only if it is not older than max_age 
+	     * milliseconds; otherwise handle_get() is called as usual. Values 
+	     * for objects served by a SubtreeHandler are not prefetched.
+	     *
+	     * \note If enabled, the handle_get() methods of the variables are 
+	     *       called from the background thread, concurrently to other 
+	     *       callbacks of the MasterProxy. They must be thread-safe.
+	     *
+	     * Prefetching is disabled by default.
+	     *
+	     * \param depth The maximum number of variables fetched in 
+	     *              advance. 0 disables prefetching.
+	     *
+	     * \param max_age The time for which a fetched value is valid, in 
+	     *                milliseconds.
+	     *
+	     * \exception None.
+	     */
+	    void setPrefetch(quint32 depth, quint32 max_age = 1000);
+
+	    /**
+	     * \brief The implementation of the connection actually used.
+	     *
+	     * This is the backend given to the constructor, unless it was not 
+	     * available (see uringBackend).
+	     *
+	     * \exception None.
+	     */
+	    backend_t backend() const
+	    {
+		return used_backend;
+	    }
+
+	    /**
+	     * \brief The file descriptor to watch for embeddedBackend.
+	     *
+	     * The application waits until this file descriptor becomes 
+	     * readable (e.g. using epoll, poll() or libuv) and then calls 
+	     * process(). The descriptor stays the same for the lifetime of 
+	     * the MasterProxy, even across reconnects. The application must 
+	     * not read from it or close it.
+	     *
+	     * \return The file descriptor, or -1 if another backend is used.
+	     *
+	     * \exception None.
+	     */
+	    int fileDescriptor()
+	    {
+		return connection->file_descriptor();
+	    }
+
+	    /**
+	     * \brief The time after which process() must be called even if 
+	     *        fileDescriptor() is not readable.
+	     *
+	     * This drives the keepalive and the automatic reconnect (see 
+	     * setKeepalive() and setAutoReconnect()). The value changes after 
+	     * each call to the MasterProxy, so the application should obtain 
+	     * it each time before it waits.
+	     *
+	     * \return The time in milliseconds, or -1 if the application may 
+	     *         wait forever.
+	     *
+	     * \exception None.
+	     */
+	    int processTimeout()
+	    {
+		return connection->process_timeout();
+	    }
+
+	    /**
+	     * \brief Process the data received from the master agent.
+	     *
+	     * Used with embeddedBackend; does nothing for other backends. 
+	     * This function doesn't block. The requests received from the 
+	     * master agent are handled before it returns, i.e. the callbacks 
+	     * of the variables are invoked in the calling thread. The 
+	     * function must be called from the thread which created the 
+	     * MasterProxy.
+	     *
+	     * Methods which wait for the master agent (e.g. 
+	     * register_subtree()) read the socket themselves while waiting. 
+	     * Requests from the master agent received meanwhile are handled 
+	     * by the next call to process().
+	     *
+	     * \note With embeddedBackend, no Qt event loop is needed, except 
+	     *       for adaptive timeouts (see setAdaptiveTimeouts()).
+	     *
+	     * \exception None.
+	     */
+	    void process()
+	    {
+		connection->process();
+	    }
+
+	    /**
+	     * \brief How index values are chosen by allocateIndex().
+	     *
+	     * See RFC 2741, 7.1.4.1. "Processing the agentx-IndexAllocate-PDU".
+	     */
+	    enum index_allocation_t
+	    {
+		/**
+		 * \brief Allocate the given values.
+		 */
+		specificIndex,
+
+		/**
+		 * \brief Allocate values which were never allocated before
+		 *        (the new_index flag). The given values only determine 
+		 *        the type.
+		 */
+		newIndex,
+
+		/**
+		 * \brief Allocate values which are currently not allocated
+		 *        (the any_index flag). The given values only determine 
+		 *        the type.
+		 */
+		anyIndex
+	    };
+
+	    /**
+	     * \brief Allocate index values from the master agent.
+	     *
+	     * Index values which are shared by several subagents (e.g. 
+	     * ifIndex) are allocated from the master agent, so that no two 
+	     * subagents use the same value. Each varbind names an index object 
+	     * and carries the value to be allocated (or, for newIndex and 
+	     * anyIndex, a value of the desired type). All varbinds are sent in 
+	     * one IndexAllocate-PDU, and either all or none of them are 
+	     * allocated.
+	     *
+	     * The master agent releases all index values of the session when 
+	     * the session ends, so they must be allocated again after a 
+	     * reconnect.
+	     *
+	     * \param indexes The index objects and values.
+	     *
+	     * \param how How the values are chosen.
+	     *
+	     * \return The allocated index objects and values, in the order of 
+	     *         indexes.
+	     *
+	     * \exception index_wrong_type, index_already_allocated, 
+	     *            index_none_available If the master agent refuses the 
+	     *                                 allocation.
+	     *
+	     * \exception unsupported_context, master_is_unable, 
+	     *            parse_error If the master agent reports another error.
+	     *
+	     * \exception disconnected, timeout_error If the master agent does 
+	     *                                        not respond.
+	     */
+	    std::vector<Varbind> allocateIndex(const std::vector<Varbind>& indexes,
+	                                       index_allocation_t how
+	                                           = specificIndex);
+
+	    /**
+	     * \brief The outcome of one request of allocateIndexes().
+	     */
+	    struct IndexAllocation
+	    {
+		/**
+		 * \brief Default constructor (a successful, empty 
+		 *        allocation).
+		 */
+		IndexAllocation()
+		: error(ResponsePDU::noAgentXError)
+		{
+		}
+
+		/**
+		 * \brief The error reported by the master agent, or 
+		 *        ResponsePDU::noAgentXError on success.
+		 */
+		ResponsePDU::error_t error;
+
+		/**
+		 * \brief The allocated index objects and values (empty if 
+		 *        the request was refused).
+		 */
+		std::vector<Varbind> indexes;
+
+		/**
+		 * \brief Throw the exception allocateIndex() throws for the 
+		 *        error.
+		 *
+		 * Does nothing if the request succeeded.
+		 *
+		 * \exception index_wrong_type, index_already_allocated, 
+		 *            index_none_available, unsupported_context, 
+		 *            master_is_unable, parse_error According to the 
+		 *                                          error.
+		 */
+		void check() const;
+	    };
+
+	    /**
+	     * \brief Allocate index values with several pipelined requests.
+	     *
+	     * Like allocateIndex(), but each element of requests is sent as 
+	     * a separate IndexAllocate-PDU. All PDU's are sent at once, 
+	     * without waiting for the response to a PDU before sending the 
+	     * next one, so that the allocations take a single round trip. The 
+	     * requests succeed or fail independently.
+	     *
+	     * \param requests The index objects and values, one vector per 
+	     *                 IndexAllocate-PDU.
+	     *
+	     * \param how How the values are chosen.
+	     *
+	     * \return The outcome of each request, in the order of requests: 
+	     *         the allocated index objects and values, or the error 
+	     *         reported by the master agent (see 
+	     *         IndexAllocation::check()).
+	     *
+	     * \exception disconnected, timeout_error If the master agent does 
+	     *                                        not respond.
+	     */
+	    std::vector<IndexAllocation> allocateIndexes(
+	            const std::vector< std::vector<Varbind> >& requests,
+	            index_allocation_t how = specificIndex);
+
+	    /**
+	     * \brief Release index values allocated with allocateIndex().
+	     *
+	     * All varbinds are sent in one IndexDeallocate-PDU, and either all 
+	     * or none of them are released.
+	     *
+	     * \param indexes The index objects and values.
+	     *
+	     * \exception index_not_allocated If a value was not allocated by 
+	     *                                this session.
+	     *
+	     * \exception index_wrong_type, unsupported_context, 
+	     *            master_is_unable, parse_error If the master agent 
+	     *                                          reports another error.
+	     *
+	     * \exception disconnected, timeout_error If the master agent does 
+	     *                                        not respond.
+	     */
+	    void deallocateIndex(const std::vector<Varbind>& indexes);
     };
 }
 
@@ -34,19 +34,20 @@ void OctetStringVariable::setValue(QString _value)
 {
     // Here we convert initial value to a binary string. We do this in four
     // steps:
-    // 1. get the bare data: v.toStdString().data()
+    // 1. get the bare data: str.data()
     // 2. cast the data to the value type of binary
     // 3. calculate the size of the data
-    //    - v.toStdString().size() gives us the number of characters
+    //    - str.size() gives us the number of characters
     //    - sizeof(binary::value_type) gives us the size of an character
     // 4. Assign v to value, giving it the bare data and its size
     //
     // This seems to be goofy, but it ensures that our code works even on a
     // machine where a char is not 8 bit wide, i.e. when char has another size
-    // than quint8.
+    // than quint8. The string is converted only once.
+    std::string str = _value.toStdString();
     v.assign(
-            reinterpret_cast<const binary::value_type*>( _value.toStdString().data() ),
-            _value.toStdString().size() * sizeof( binary::value_type )
+            reinterpret_cast<const binary::value_type*>( str.data() ),
+            str.size() * sizeof( binary::value_type )
                 );
 }
 
@@ -94,6 +95,23 @@ binary OctetStringVariable::serialize() const
 }
 
 
+void OctetStringVariable::serialize_to(SegmentedBuffer& out) const
+{
+    // encode size (in the buffer's byte order)
+    out.write32(v.size());
+
+    // encode value
+    out.append(v);
+
+    // Padding bytes
+    int padsize = 4 - (v.size() % 4);
+    if( padsize != 4 )
+    {
+	memset(out.allocate(padsize), 0, padsize);
+    }
+}
+
+
 OctetStringVariable::OctetStringVariable(binary::const_iterator& pos,
                                          const binary::const_iterator& end,
                                          bool big_endian)
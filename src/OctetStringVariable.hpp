@@ -25,7 +25,7 @@ namespace agentxcpp
         private:
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::new_value
+             * \copydoc agentxcpp::ScalarVariable::new_value
              */
             QSharedPointer<OctetStringVariable> new_value;
 
@@ -40,6 +40,16 @@ namespace agentxcpp
              */
             binary serialize() const;
 
+            /**
+             * \internal
+             *
+             * \brief Encode the object into a segmented buffer.
+             *
+             * Like serialize(), but the value is written directly into the
+             * buffer, in the buffer's byte order.
+             */
+            virtual void serialize_to(SegmentedBuffer& out) const;
+
             /**
              * \brief (Default) constructor.
              *
@@ -66,7 +76,7 @@ namespace agentxcpp
                                 bool big_endian=true);
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::setValue()
+             * \copydoc agentxcpp::ScalarVariable::setValue()
              */
             void setValue(binary _value)
             {
@@ -74,7 +84,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::setValue()
+             * \copydoc agentxcpp::ScalarVariable::setValue()
              */
             void setValue(QString _value);
 
@@ -109,7 +119,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_get()
+             * \copydoc agentxcpp::ScalarVariable::handle_get()
              */
             virtual void handle_get()
             {
@@ -117,7 +127,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_get()
+             * \copydoc agentxcpp::ScalarVariable::perform_get()
              */
             virtual void perform_get()
             {
@@ -126,7 +136,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_testset()
+             * \copydoc agentxcpp::ScalarVariable::handle_testset()
              */
             virtual testset_result_t handle_testset(QSharedPointer<AbstractVariable> _v)
             {
@@ -147,7 +157,7 @@ namespace agentxcpp
             /**
              * \brief Handle a TestSet request.
              *
-             * \copydoc agentxcpp::IntegerVariable::perform_testset()
+             * \copydoc agentxcpp::ScalarVariable::perform_testset()
              */
             virtual testset_result_t perform_testset(const binary& _v)
             {
@@ -157,7 +167,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_cleanupset()
+             * \copydoc agentxcpp::ScalarVariable::handle_cleanupset()
              */
             virtual void handle_cleanupset()
             {
@@ -165,7 +175,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_cleanupset()
+             * \copydoc agentxcpp::ScalarVariable::perform_cleanupset()
              */
             virtual void perform_cleanupset(const binary& _v)
             {
@@ -175,7 +185,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_commitset()
+             * \copydoc agentxcpp::ScalarVariable::handle_commitset()
              */
             virtual bool handle_commitset()
             {
@@ -183,7 +193,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_commitset()
+             * \copydoc agentxcpp::ScalarVariable::perform_commitset()
              */
             virtual bool perform_commitset(const binary& _v)
             {
@@ -193,7 +203,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_undoset()
+             * \copydoc agentxcpp::ScalarVariable::handle_undoset()
              */
             virtual bool handle_undoset()
             {
@@ -201,7 +211,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_undoset()
+             * \copydoc agentxcpp::ScalarVariable::perform_undoset()
              */
             virtual bool perform_undoset(const binary& _v)
             {
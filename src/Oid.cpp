@@ -65,6 +65,7 @@ void Oid::parseString(std::string s)
 
 
 Oid::Oid(std::string s)
+: mInclude(false)
 {
     // parse the string. Forward all exceptions.
     parseString(s);
@@ -91,6 +92,19 @@ Oid::Oid(const Oid& o, quint32 id)
 }
 
 
+uint agentxcpp::qHash(const Oid& o)
+{
+    // FNV-1a over the subids
+    quint32 hash = 2166136261u;
+    for(Oid::const_iterator it = o.begin(); it != o.end(); it++)
+    {
+	hash ^= *it;
+	hash *= 16777619u;
+    }
+    return hash;
+}
+
+
 std::ostream& agentxcpp::operator<<(std::ostream& out, const Oid& o)
 {
     // Leading dot
@@ -442,6 +442,18 @@ namespace agentxcpp
      */
     std::ostream& operator<<(std::ostream& out, const agentxcpp::Oid& o);
 
+    /**
+     * \brief Hash function for Oid objects.
+     *
+     * Allows to use Oid as key in QHash and QSet. The hash is calculated
+     * from all subids (FNV-1a).
+     *
+     * \param o The OID.
+     *
+     * \return The hash value.
+     */
+    uint qHash(const agentxcpp::Oid& o);
+
 
     // TODO: Possibly these should be put into the agentxcpp::Oid namespace?
     // The use of \memberof is not elegant.
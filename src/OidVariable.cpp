@@ -103,6 +103,42 @@ binary OidVariable::serialize() const
     return serialized;
 }
 
+void OidVariable::serialize_to(SegmentedBuffer& out) const
+{
+    // See serialize() for the format
+    Oid::const_iterator subid = v.begin();
+    quint8 n_subid;
+    quint8 prefix;
+    if( v.size() >= 5 &&
+	v[0] == 1 &&
+	v[1] == 3 &&
+	v[2] == 6 &&
+	v[3] == 1 &&
+	v[4] <= 0xff)	// we have only one byte for the prefix!
+    {
+	// use prefix field
+	prefix = v[4];
+	n_subid = v.size() - 5;
+	subid += 5;
+    }
+    else
+    {
+	// don't use prefix field
+	prefix = 0;
+	n_subid = v.size();
+    }
+
+    // header
+    quint8* p = out.allocate(4 + 4 * n_subid);
+    *p++ = n_subid;
+    *p++ = prefix;
+    *p++ = v.include() ? 1 : 0;
+    *p++ = 0;	// reserved
+
+    // subids (copied at once in the host's byte order)
+    out.store32(p, &*subid, n_subid);
+}
+
 OidVariable::OidVariable(binary::const_iterator& pos,
 	 const binary::const_iterator& end,
 	 bool big_endian)
@@ -148,6 +184,15 @@ OidVariable::OidVariable(binary::const_iterator& pos,
     {
 	throw(parse_error());
     }
+    if(big_endian == host_big_endian && n_subid != 0)
+    {
+	// Host byte order: copy all subids at once
+	int size = v.size();
+	v.resize(size + n_subid);
+	memcpy(v.data() + size, &*pos, n_subid * 4);
+	pos += n_subid * 4;
+	return;
+    }
     quint32 subid;
     for( int i = 0; i < n_subid; i++)
     {
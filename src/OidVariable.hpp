@@ -49,7 +49,7 @@ namespace agentxcpp
         private:
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::new_value
+             * \copydoc agentxcpp::ScalarVariable::new_value
              */
             QSharedPointer<OidVariable> new_value;
 
@@ -86,7 +86,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::setValue()
+             * \copydoc agentxcpp::ScalarVariable::setValue()
              */
             void setValue(const Oid& _value)
             {
@@ -102,6 +102,16 @@ namespace agentxcpp
              */
             binary serialize() const;
 
+            /**
+             * \internal
+             *
+             * \brief Encode the object into a segmented buffer.
+             *
+             * Like serialize(), but the OID is written directly into the
+             * buffer, without a temporary binary object.
+             */
+            virtual void serialize_to(SegmentedBuffer& out) const;
+
             /**
              * \internal
              *
@@ -149,7 +159,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_get()
+             * \copydoc agentxcpp::ScalarVariable::handle_get()
              */
             virtual void handle_get()
             {
@@ -157,7 +167,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_get()
+             * \copydoc agentxcpp::ScalarVariable::perform_get()
              */
             virtual void perform_get()
             {
@@ -166,7 +176,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_testset()
+             * \copydoc agentxcpp::ScalarVariable::handle_testset()
              */
             virtual testset_result_t handle_testset(QSharedPointer<AbstractVariable> _v)
             {
@@ -185,7 +195,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_testset()
+             * \copydoc agentxcpp::ScalarVariable::perform_testset()
              */
             virtual testset_result_t perform_testset(const Oid& _v)
             {
@@ -195,7 +205,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_cleanupset()
+             * \copydoc agentxcpp::ScalarVariable::handle_cleanupset()
              */
             virtual void handle_cleanupset()
             {
@@ -203,7 +213,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_cleanupset()
+             * \copydoc agentxcpp::ScalarVariable::perform_cleanupset()
              */
             virtual void perform_cleanupset(const Oid& _v)
             {
@@ -213,7 +223,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_commitset()
+             * \copydoc agentxcpp::ScalarVariable::handle_commitset()
              */
             virtual bool handle_commitset()
             {
@@ -221,7 +231,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_commitset()
+             * \copydoc agentxcpp::ScalarVariable::perform_commitset()
              */
             virtual bool perform_commitset(const Oid& _v)
             {
@@ -231,7 +241,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_undoset()
+             * \copydoc agentxcpp::ScalarVariable::handle_undoset()
              */
             virtual bool handle_undoset()
             {
@@ -240,7 +250,7 @@ namespace agentxcpp
 
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_undoset()
+             * \copydoc agentxcpp::ScalarVariable::perform_undoset()
              */
             virtual bool perform_undoset(const Oid& _v)
             {
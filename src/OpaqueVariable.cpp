@@ -37,6 +37,7 @@ binary OpaqueVariable::serialize() const
 
     // Padding bytes
     int padsize = 4 - (size % 4);
+    if( padsize == 4 ) padsize = 0; // avoid adding 4 padding bytes
     while( padsize-- )
     {
 	serialized.push_back(0);
@@ -46,6 +47,23 @@ binary OpaqueVariable::serialize() const
 }
 
 
+void OpaqueVariable::serialize_to(SegmentedBuffer& out) const
+{
+    // encode size (in the buffer's byte order)
+    out.write32(v.size());
+
+    // encode value
+    out.append(v);
+
+    // Padding bytes
+    int padsize = 4 - (v.size() % 4);
+    if( padsize != 4 )
+    {
+	memset(out.allocate(padsize), 0, padsize);
+    }
+}
+
+
 OpaqueVariable::OpaqueVariable(binary::const_iterator& pos,
 	       const binary::const_iterator& end,
 	       bool big_endian)
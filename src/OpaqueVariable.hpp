@@ -42,7 +42,7 @@ namespace agentxcpp
         private:
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::new_value
+             * \copydoc agentxcpp::ScalarVariable::new_value
              */
             QSharedPointer<OpaqueVariable> new_value;
 
@@ -57,6 +57,16 @@ namespace agentxcpp
              */
             binary serialize() const;
 
+            /**
+             * \internal
+             *
+             * \brief Encode the object into a segmented buffer.
+             *
+             * Like serialize(), but the value is written directly into the
+             * buffer, in the buffer's byte order.
+             */
+            virtual void serialize_to(SegmentedBuffer& out) const;
+
             /**
              * \internal
              *
@@ -82,7 +92,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::setValue()
+             * \copydoc agentxcpp::ScalarVariable::setValue()
              */
             void setValue(binary _value)
             {
@@ -102,7 +112,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_get()
+             * \copydoc agentxcpp::ScalarVariable::handle_get()
              */
             virtual void handle_get()
             {
@@ -110,7 +120,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_get()
+             * \copydoc agentxcpp::ScalarVariable::perform_get()
              */
             virtual void perform_get()
             {
@@ -119,7 +129,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_testset()
+             * \copydoc agentxcpp::ScalarVariable::handle_testset()
              */
             virtual testset_result_t handle_testset(QSharedPointer<AbstractVariable> _v)
             {
@@ -138,7 +148,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_testset()
+             * \copydoc agentxcpp::ScalarVariable::perform_testset()
              */
             virtual testset_result_t perform_testset(const binary& _v)
             {
@@ -148,7 +158,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_cleanupset()
+             * \copydoc agentxcpp::ScalarVariable::handle_cleanupset()
              */
             virtual void handle_cleanupset()
             {
@@ -156,7 +166,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_cleanupset()
+             * \copydoc agentxcpp::ScalarVariable::perform_cleanupset()
              */
             virtual void perform_cleanupset(const binary& _v)
             {
@@ -166,7 +176,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_commitset()
+             * \copydoc agentxcpp::ScalarVariable::handle_commitset()
              */
             virtual bool handle_commitset()
             {
@@ -174,7 +184,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_commitset()
+             * \copydoc agentxcpp::ScalarVariable::perform_commitset()
              */
             virtual bool perform_commitset(const binary& _v)
             {
@@ -184,7 +194,7 @@ namespace agentxcpp
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_undoset()
+             * \copydoc agentxcpp::ScalarVariable::handle_undoset()
              */
             virtual bool handle_undoset()
             {
@@ -192,7 +202,7 @@ namespace agentxcpp
             }
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::perform_undoset()
+             * \copydoc agentxcpp::ScalarVariable::perform_undoset()
              */
             virtual bool perform_undoset(const binary& _v)
             {
@@ -71,3 +71,28 @@ binary OpenPDU::serialize() const
     // return serialized form of PDU
     return serialized;
 }
+
+
+void OpenPDU::serialize_to(SegmentedBuffer& out) const
+{
+    // Reserve the header, which is filled in when the payload length is
+    // known
+    quint8* hdr = out.allocate(20);
+    quint32 start = out.size();
+
+    // timeout and reserved fields
+    quint8* p = out.allocate(4);
+    p[0] = timeout;
+    p[1] = 0;
+    p[2] = 0;
+    p[3] = 0;
+
+    // id
+    OidVariable(id).serialize_to(out);
+
+    // descr
+    descr.serialize_to(out);
+
+    // Fill in the header (type for OpenPDU is 1)
+    header(PDU::agentxOpenPDU, out.size() - start, hdr, out.bigEndian());
+}
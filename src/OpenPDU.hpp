@@ -135,6 +135,16 @@ namespace agentxcpp
 	     * \brief Serialize the %PDU
 	     */
 	    binary serialize() const;
+
+	    /**
+	     * \brief Serialize the %PDU into a segmented buffer
+	     *
+	     * The %PDU is encoded in the byte order of the buffer. The master 
+	     * agent uses the byte order of the agentx-Open-PDU for the PDU's 
+	     * it sends during the session, so this selects the byte order of 
+	     * the whole session.
+	     */
+	    void serialize_to(SegmentedBuffer& out) const;
     };
 }
 
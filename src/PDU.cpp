@@ -184,16 +184,14 @@ QSharedPointer<PDU> PDU::parse_pdu(binary buf)
 
 
 
-void PDU::add_header(type_t type, binary& payload) const
+void PDU::header(type_t type, quint32 payload_length, quint8* out,
+                 bool big_endian) const
 {
-    /* Construct header */
-    binary header;
-
     // Protocol version
-    header.push_back(1);
+    out[0] = 1;
 
     // Type
-    header.push_back(type);
+    out[1] = type;
 
     // flags
     quint8 flags = 0;
@@ -201,18 +199,46 @@ void PDU::add_header(type_t type, binary& payload) const
     if(new_index)             flags |= (1<<1);
     if(any_index)             flags |= (1<<2);
     if(non_default_context)   flags |= (1<<3);
-    flags |= (1<<4);	// We always use big endian
-    header.push_back(flags);
+    if(big_endian)            flags |= (1<<4);
+    out[2] = flags;
 
     // reserved field
-    header.push_back(0);
+    out[3] = 0;
 
     // remaining fields
-    write32(header, sessionID);
-    write32(header, transactionID);
-    write32(header, packetID);
-    write32(header, payload.size());	// payload length
+    quint32 fields[4] = { sessionID, transactionID, packetID, payload_length };
+    if(big_endian == host_big_endian)
+    {
+	// Host byte order: copy
+	memcpy(out + 4, fields, sizeof(fields));
+	return;
+    }
+    for(int i = 0; i < 4; i++)
+    {
+	if(big_endian)
+	{
+	    out[4 + 4*i + 0] = fields[i] >> 24 & 0xff;
+	    out[4 + 4*i + 1] = fields[i] >> 16 & 0xff;
+	    out[4 + 4*i + 2] = fields[i] >> 8 & 0xff;
+	    out[4 + 4*i + 3] = fields[i] >> 0 & 0xff;
+	}
+	else
+	{
+	    out[4 + 4*i + 0] = fields[i] >> 0 & 0xff;
+	    out[4 + 4*i + 1] = fields[i] >> 8 & 0xff;
+	    out[4 + 4*i + 2] = fields[i] >> 16 & 0xff;
+	    out[4 + 4*i + 3] = fields[i] >> 24 & 0xff;
+	}
+    }
+}
+
+
+void PDU::add_header(type_t type, binary& payload) const
+{
+    /* Construct header */
+    quint8 serialized[20];
+    header(type, payload.size(), serialized);
 
     // Add header to payload
-    payload.insert(0, header);
+    payload.insert(0, serialized, 20);
 }
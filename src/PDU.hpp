@@ -28,6 +28,7 @@
 
 #include "exceptions.hpp"
 #include "binary.hpp"
+#include "SegmentedBuffer.hpp"
 
 namespace agentxcpp
 {
@@ -113,6 +114,7 @@ namespace agentxcpp
 	     */
 	    bool non_default_context;
 
+	public:
 	    /**
 	     * \brief The PDU types
 	     *
@@ -141,6 +143,8 @@ namespace agentxcpp
 
 	    };
 
+	protected:
+
 	    /**
 	     * \brief h.packetID field according to RFC 2741, 6.1. "AgentX PDU
 	     *        Header".
@@ -202,6 +206,27 @@ namespace agentxcpp
 	     */
 	    void add_header(type_t type, binary& payload) const;
 
+	    /**
+	     * \brief Construct the PDU header for a payload of a given size
+	     *
+	     * Like add_header(), but the header is written to a given buffer
+	     * instead of being inserted into the payload. Used by derived 
+	     * classes which serialize into a SegmentedBuffer.
+	     *
+	     * \param type The PDU type.
+	     *
+	     * \param payload_length The size of the payload in bytes.
+	     *
+	     * \param out The buffer receiving the header (20 bytes).
+	     *
+	     * \param big_endian Whether the %PDU is encoded in big endian
+	     *                   format. This determines the 
+	     *                   NETWORK_BYTE_ORDER flag and the encoding of the 
+	     *                   header fields.
+	     */
+	    void header(type_t type, quint32 payload_length, quint8* out,
+			bool big_endian = true) const;
+
 	    /**
 	     * \brief Default constructor
 	     *
@@ -293,6 +318,19 @@ namespace agentxcpp
 	     * \brief Serialize function for concrete PDUs.
 	     */
 	    virtual binary serialize() const =0;
+
+	    /**
+	     * \brief Serialize the %PDU into a segmented buffer
+	     *
+	     * This is used by the connectors to write the %PDU to the
+	     * socket. The default implementation appends the result of
+	     * serialize(). PDU's which may carry large variables override it,
+	     * so that the values of these variables are not copied.
+	     */
+	    virtual void serialize_to(SegmentedBuffer& out) const
+	    {
+		out.append(serialize());
+	    }
     };
 }
 
@@ -33,7 +33,7 @@ PingPDU::PingPDU(binary::const_iterator& pos,
 
 
 
-binary PingPDU::serialize()
+binary PingPDU::serialize() const
 {
     binary serialized;
 
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#include <QMutexLocker>
+#include <QList>
+
+#include "Prefetcher.hpp"
+#include "AgentStatistics.hpp"
+
+using namespace agentxcpp;
+
+
+Prefetcher::Prefetcher(quint64 max_age)
+: next_ticket(0),
+  max_age(max_age),
+  stopping(false)
+{
+    start();
+}
+
+
+Prefetcher::~Prefetcher()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        changed.wakeAll();
+    }
+    wait();
+}
+
+
+void Prefetcher::enqueue(QSharedPointer<AbstractVariable> var)
+{
+    QMutexLocker locker(&mutex);
+    if(entries.contains(var.data()))
+    {
+        // Already known
+        return;
+    }
+
+    Entry e;
+    e.var = var;
+    e.updated = 0;
+    e.running = false;
+    e.failed = false;
+    e.ticket = next_ticket++;
+    entries.insert(var.data(), e);
+    queue.push_back(std::make_pair(var.data(), e.ticket));
+    changed.wakeAll();
+}
+
+
+bool Prefetcher::claim(QSharedPointer<AbstractVariable> var)
+{
+    QMutexLocker locker(&mutex);
+    while(entries.contains(var.data()) && entries[var.data()].running)
+    {
+        // Being updated: wait for the result
+        changed.wait(&mutex);
+    }
+    if( ! entries.contains(var.data()))
+    {
+        // Unknown to us
+        return false;
+    }
+
+    // Either the value was updated, or it is still queued (then run() 
+    // skips it, because the entry is gone)
+    Entry e = entries.take(var.data());
+    return    e.updated != 0
+           && ! e.failed
+           && AgentStatistics::now() - e.updated <= max_age;
+}
+
+
+int Prefetcher::pending()
+{
+    QMutexLocker locker(&mutex);
+
+    // Discard outdated values (e.g. of an aborted walk)
+    quint64 now = AgentStatistics::now();
+    QList<AbstractVariable*> outdated;
+    QHashIterator<AbstractVariable*, Entry> i(entries);
+    while(i.hasNext())
+    {
+        i.next();
+        if(i.value().updated != 0 && now - i.value().updated > max_age)
+        {
+            outdated.append(i.key());
+        }
+    }
+    for(int j = 0; j < outdated.size(); j++)
+    {
+        entries.remove(outdated[j]);
+    }
+
+    return entries.size();
+}
+
+
+void Prefetcher::run()
+{
+    QMutexLocker locker(&mutex);
+    while( ! stopping )
+    {
+        if(queue.empty())
+        {
+            changed.wait(&mutex);
+            continue;
+        }
+
+        AbstractVariable* key = queue.front().first;
+        quint64 ticket = queue.front().second;
+        queue.pop_front();
+        if( ! entries.contains(key) || entries[key].ticket != ticket)
+        {
+            // Claimed before we got to it (and maybe enqueued again)
+            continue;
+        }
+
+        // Update the value without holding the lock. The entry keeps the 
+        // variable alive.
+        QSharedPointer<AbstractVariable> var = entries[key].var;
+        entries[key].running = true;
+        locker.unlock();
+        bool failed = false;
+        try
+        {
+            var->handle_get();
+        }
+        catch(...)
+        {
+            failed = true;
+        }
+        locker.relock();
+
+        Entry& e = entries[key];
+        e.running = false;
+        e.failed = failed;
+        e.updated = AgentStatistics::now();
+        changed.wakeAll();
+    }
+}
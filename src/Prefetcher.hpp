@@ -0,0 +1,184 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#ifndef _PREFETCHER_HPP_
+#define _PREFETCHER_HPP_
+
+#include <deque>
+#include <utility>
+
+#include <QtGlobal>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QSharedPointer>
+
+#include "AbstractVariable.hpp"
+
+
+namespace agentxcpp
+{
+
+/**
+ * \internal
+ *
+ * \brief Updates variables ahead of a walk in a background thread.
+ *
+ * When the MasterProxy detects a walk (see MasterProxy::setPrefetch()), it 
+ * passes the variables which will probably be requested next to 
+ * enqueue(). The Prefetcher's thread calls AbstractVariable::handle_get() 
+ * for them, one after the other. When a variable is actually requested, 
+ * the MasterProxy calls claim() instead of handle_get(): if the variable 
+ * was updated recently, its value is used as is.
+ *
+ * A variable is never updated by both threads at the same time: claim() 
+ * takes a variable which was not yet updated out of the queue, and waits 
+ * if the variable is being updated by the Prefetcher's thread.
+ */
+class Prefetcher : public QThread
+{
+    public:
+        /**
+         * \brief Constructor.
+         *
+         * Starts the thread.
+         *
+         * \param max_age The time for which an updated value is used, in 
+         *                microseconds.
+         */
+        Prefetcher(quint64 max_age);
+
+        /**
+         * \brief Destructor.
+         *
+         * Stops the thread. Variables still in the queue are not updated.
+         */
+        ~Prefetcher();
+
+        /**
+         * \brief Queue a variable for updating.
+         *
+         * Nothing happens if the variable is already queued or updated.
+         */
+        void enqueue(QSharedPointer<AbstractVariable> var);
+
+        /**
+         * \brief Take an updated value.
+         *
+         * \return true if the variable was updated by the Prefetcher not 
+         *         longer than max_age ago, false if the caller must call 
+         *         handle_get() itself.
+         */
+        bool claim(QSharedPointer<AbstractVariable> var);
+
+        /**
+         * \brief Get the number of variables which are queued, being 
+         *        updated or updated recently.
+         *
+         * Entries older than max_age are discarded first.
+         */
+        int pending();
+
+    protected:
+        /**
+         * \brief The thread's main loop.
+         */
+        virtual void run();
+
+    private:
+        /**
+         * \brief The state of a variable known to the Prefetcher.
+         */
+        struct Entry
+        {
+            /**
+             * \brief The variable.
+             */
+            QSharedPointer<AbstractVariable> var;
+
+            /**
+             * \brief The time at which the update finished (see 
+             *        AgentStatistics::now()), or 0 if it did not finish 
+             *        yet.
+             */
+            quint64 updated;
+
+            /**
+             * \brief Whether handle_get() is being called.
+             */
+            bool running;
+
+            /**
+             * \brief Whether handle_get() threw an exception.
+             */
+            bool failed;
+
+            /**
+             * \brief The number of the entry's element in the queue.
+             */
+            quint64 ticket;
+        };
+
+        /**
+         * \brief The known variables.
+         */
+        QHash<AbstractVariable*, Entry> entries;
+
+        /**
+         * \brief The variables to update, in order, with the ticket of 
+         *        their entry.
+         *
+         * Variables which were claimed are not removed from the queue, but 
+         * from entries. run() skips an element if its variable has no 
+         * entry, or if the ticket differs from the entry's ticket (the 
+         * variable was claimed and enqueued again, and its new element 
+         * follows later).
+         */
+        std::deque< std::pair<AbstractVariable*, quint64> > queue;
+
+        /**
+         * \brief The ticket for the next queue element.
+         */
+        quint64 next_ticket;
+
+        /**
+         * \brief The time for which an updated value is used.
+         */
+        quint64 max_age;
+
+        /**
+         * \brief Set to stop the thread.
+         */
+        bool stopping;
+
+        /**
+         * \brief Protects all members.
+         */
+        QMutex mutex;
+
+        /**
+         * \brief Signalled when the queue grows or an update finishes.
+         */
+        QWaitCondition changed;
+};
+
+} /* namespace agentxcpp */
+#endif /* _PREFETCHER_HPP_ */
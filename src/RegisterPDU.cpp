@@ -40,12 +40,12 @@ RegisterPDU::RegisterPDU(binary::const_iterator& pos,
     subtree = OidVariable(pos, end, big_endian).value();
 
     // read r.upper_bound only if r.range_subid is not 0
-    if(end - pos < 4)
-    {
-	throw(parse_error());
-    }
     if( range_subid != 0 )
     {
+	if(end - pos < 4)
+	{
+	    throw(parse_error());
+	}
 	upper_bound = read32(pos, big_endian);
     }
 }
@@ -35,7 +35,7 @@ RemoveAgentCapsPDU::RemoveAgentCapsPDU(binary::const_iterator& pos,
 
 
 
-binary RemoveAgentCapsPDU::serialize()
+binary RemoveAgentCapsPDU::serialize() const
 {
     binary serialized;
 
@@ -110,7 +110,7 @@ namespace agentxcpp
 	    /**
 	     * \brief Serialize the %PDU
 	     */
-	    binary serialize();
+	    virtual binary serialize() const;
     };
 }
 
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "RequestArena.hpp"
+
+using namespace agentxcpp;
+using namespace std;
+
+
+RequestArena::RequestArena(size_t size)
+: block_size(size),
+  blocks(0),
+  top(0),
+  limit(0),
+  used_bytes(0),
+  total_size(0),
+  heap_allocations(0)
+{
+}
+
+
+RequestArena::~RequestArena()
+{
+    free_blocks();
+}
+
+
+bool RequestArena::add_block(size_t size)
+{
+    if(size < block_size)
+    {
+        size = block_size;
+    }
+    Block* block = static_cast<Block*>(malloc(sizeof(Block) + size));
+    if(block == 0)
+    {
+        return false;
+    }
+    heap_allocations++;
+    block->next = blocks;
+    block->size = size;
+    blocks = block;
+    top = reinterpret_cast<char*>(block + 1);
+    limit = top + size;
+    total_size += size;
+    return true;
+}
+
+
+void RequestArena::free_blocks()
+{
+    while(blocks)
+    {
+        Block* next = blocks->next;
+        free(blocks);
+        blocks = next;
+    }
+    top = 0;
+    limit = 0;
+    total_size = 0;
+}
+
+
+void* RequestArena::allocate(size_t size, size_t align)
+{
+    // Align the top pointer
+    size_t misalign = reinterpret_cast<size_t>(top) & (align - 1);
+    size_t skip = misalign ? align - misalign : 0;
+
+    if(top == 0 || static_cast<size_t>(limit - top) < skip + size)
+    {
+        // The current block is too small. The header of a new block is
+        // aligned for any type.
+        if(! add_block(size + align))
+        {
+            throw(bad_alloc());
+        }
+        misalign = reinterpret_cast<size_t>(top) & (align - 1);
+        skip = misalign ? align - misalign : 0;
+    }
+
+    char* p = top + skip;
+    top = p + size;
+    used_bytes += size;
+    return p;
+}
+
+
+void RequestArena::reset()
+{
+    if(blocks && blocks->next)
+    {
+        // Several blocks were needed: replace them by one block which is
+        // large enough for all of them
+        size_t size = total_size;
+        free_blocks();
+        add_block(size); // On failure, allocate() tries again
+    }
+    else if(blocks)
+    {
+        // Reuse the only block
+        top = reinterpret_cast<char*>(blocks + 1);
+    }
+    used_bytes = 0;
+}
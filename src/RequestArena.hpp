@@ -0,0 +1,179 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#ifndef _REQUESTARENA_HPP_
+#define _REQUESTARENA_HPP_
+
+#include <cstddef>
+
+namespace agentxcpp
+{
+    /**
+     * \internal
+     *
+     * \brief A monotonic allocator for data which lives only while a single
+     *        request is processed.
+     *
+     * Memory is taken from large blocks by advancing a pointer. It is not
+     * freed individually; instead, reset() releases all allocations at
+     * once. After a reset(), the arena keeps a single block which is large
+     * enough for everything allocated before the reset, so that processing
+     * similar requests does not allocate heap memory anymore.
+     *
+     * The arena is not thread-safe. It is meant to be owned by the object
+     * processing the requests, e.g. the UnixDomainConnector uses one to
+     * serialize the PDU's it sends, and resets it after each PDU.
+     */
+    class RequestArena
+    {
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * No memory is allocated until allocate() is called.
+             *
+             * \param block_size The minimum size of the blocks.
+             *
+             * \exception None.
+             */
+            RequestArena(std::size_t block_size = 4096);
+
+            /**
+             * \brief Destructor.
+             *
+             * Frees all blocks.
+             */
+            ~RequestArena();
+
+            /**
+             * \brief Allocate memory.
+             *
+             * \param size The number of bytes.
+             *
+             * \param align The alignment, which must be a power of 2. Byte
+             *              data allocated with an alignment of 1 is
+             *              contiguous to the previous allocation as long as
+             *              the current block has room for it.
+             *
+             * \return The memory, which is valid until the next reset().
+             *
+             * \exception std::bad_alloc If no block can be allocated.
+             */
+            void* allocate(std::size_t size,
+                           std::size_t align = sizeof(void*));
+
+            /**
+             * \brief Release all allocations.
+             *
+             * \exception None.
+             */
+            void reset();
+
+            /**
+             * \brief Get the number of bytes allocated since the last
+             *        reset().
+             *
+             * \exception None.
+             */
+            std::size_t used() const
+            {
+                return used_bytes;
+            }
+
+            /**
+             * \brief Get the number of blocks obtained from the heap since
+             *        the arena was created.
+             *
+             * \exception None.
+             */
+            std::size_t heapAllocations() const
+            {
+                return heap_allocations;
+            }
+
+        private:
+            /**
+             * \brief A block; the memory follows the header.
+             */
+            struct Block
+            {
+                Block* next;
+                std::size_t size;
+            };
+
+            /**
+             * \brief The minimum size of a block.
+             */
+            std::size_t block_size;
+
+            /**
+             * \brief The list of blocks, the current block first.
+             */
+            Block* blocks;
+
+            /**
+             * \brief Next free byte in the current block.
+             */
+            char* top;
+
+            /**
+             * \brief End of the current block.
+             */
+            char* limit;
+
+            /**
+             * \brief The bytes allocated since the last reset().
+             */
+            std::size_t used_bytes;
+
+            /**
+             * \brief The sizes of all blocks added together.
+             */
+            std::size_t total_size;
+
+            /**
+             * \brief See heapAllocations().
+             */
+            std::size_t heap_allocations;
+
+            /**
+             * \brief Add a block of at least the given size.
+             *
+             * \return false if the block cannot be allocated.
+             */
+            bool add_block(std::size_t size);
+
+            /**
+             * \brief Free all blocks.
+             */
+            void free_blocks();
+
+            /**
+             * \brief Copying is not allowed.
+             */
+            RequestArena(const RequestArena&);
+
+            /**
+             * \brief Assignment is not allowed.
+             */
+            RequestArena& operator=(const RequestArena&);
+    };
+}
+
+#endif /* _REQUESTARENA_HPP_ */
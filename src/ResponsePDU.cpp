@@ -103,3 +103,27 @@ binary ResponsePDU::serialize() const
 
     return serialized;
 }
+
+
+void ResponsePDU::serialize_to(SegmentedBuffer& out) const
+{
+    // Reserve the header, which is filled in when the payload length is
+    // known
+    quint8* hdr = out.allocate(20);
+    quint32 start = out.size();
+
+    // Encode simple fields
+    out.write32(this->sysUpTime);
+    out.write16(this->error);
+    out.write16(this->index);
+
+    // Encode VarBindList
+    vector<Varbind>::const_iterator i;
+    for(i = this->varbindlist.begin(); i != this->varbindlist.end(); i++)
+    {
+	i->serialize_to(out);
+    }
+
+    // Fill in the header
+    header(PDU::agentxResponsePDU, out.size() - start, hdr, out.bigEndian());
+}
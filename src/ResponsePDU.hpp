@@ -212,6 +212,13 @@ namespace agentxcpp
 	     * \brief Serialize the %PDU
 	     */
 	    binary serialize() const;
+
+	    /**
+	     * \brief Serialize the %PDU into a segmented buffer
+	     *
+	     * The values of ByteArrayVariable objects are not copied.
+	     */
+	    void serialize_to(SegmentedBuffer& out) const;
     };
 }
 
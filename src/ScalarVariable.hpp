@@ -0,0 +1,455 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#ifndef _SCALARVARIABLE_HPP_
+#define _SCALARVARIABLE_HPP_
+
+#include <QtGlobal>
+#include <QSharedPointer>
+
+#include "AbstractVariable.hpp"
+#include "exceptions.hpp"
+#include "util.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \brief Common implementation of the numeric variable types.
+     *
+     * IntegerVariable, Counter32Variable, Counter64Variable, Gauge32Variable 
+     * and TimeTicksVariable only differ in their value type and their type 
+     * code. This template implements everything else: the storage of the 
+     * value, the encoding, and the dispatching of the Get and Set requests 
+     * to the perform_get(), perform_testset(), perform_commitset(), 
+     * perform_cleanupset() and perform_undoset() methods, which are 
+     * overridden to customize a variable (see \ref variables).
+     *
+     * The template parameter Self is the concrete variable class (e.g.  
+     * IntegerVariable, which is derived from ScalarVariable<IntegerVariable, 
+     * qint32>). It only determines which type a new value must have during a 
+     * Set operation; it is not used to dispatch statically. The perform_*() 
+     * methods stay virtual, because applications override them in classes 
+     * derived from the concrete types (which Self does not know). Therefore 
+     * a Get request still costs a virtual call of handle_get() and of 
+     * perform_get().
+     *
+     * \tparam Self The concrete variable class.
+     *
+     * \tparam T The type of the value: qint32, quint32 or quint64.
+     */
+    template<class Self, typename T>
+    class ScalarVariable : public AbstractVariable
+    {
+        protected:
+            /**
+             * \brief The current value.
+             *
+             * This is the value which is sent to the master agent on SNMP Get 
+             * requests. The value can be obtained with value() and set with 
+             * setValue().
+             *
+             * The perform_get() method should update this member.
+             *
+             * The methods perform_testset(), perform_commitset(), 
+             * perform_cleanupset() and/or perform_undoset() may update this 
+             * member, but it is not needed for proper function.
+             */
+            T v;
+
+        private:
+            /**
+             * \brief The new value for the variable. Used during a Set 
+             *        operation.
+             *
+             * The Set operation is performed in up to four steps (TestSet, 
+             * CommitSet, CleanupSet, UndoSet). Only the TestSet step actually 
+             * receives the new value. This value is stored here so that it can 
+             * be delivered to perform_commitset(), perform_undoset() and 
+             * perform_cleanupset().
+             */
+            T new_value;
+
+            /**
+             * \brief Encode a value (always big endian).
+             */
+            static void write(binary& serialized, qint32 value)
+            {
+                write32(serialized, value);
+            }
+
+            /**
+             * \brief Encode a value (always big endian).
+             */
+            static void write(binary& serialized, quint32 value)
+            {
+                write32(serialized, value);
+            }
+
+            /**
+             * \brief Encode a value (always big endian).
+             */
+            static void write(binary& serialized, quint64 value)
+            {
+                write64(serialized, value);
+            }
+
+            /**
+             * \brief Encode a value (in the buffer's byte order).
+             */
+            static void write(SegmentedBuffer& out, qint32 value)
+            {
+                out.write32(value);
+            }
+
+            /**
+             * \brief Encode a value (in the buffer's byte order).
+             */
+            static void write(SegmentedBuffer& out, quint32 value)
+            {
+                out.write32(value);
+            }
+
+            /**
+             * \brief Encode a value (in the buffer's byte order).
+             */
+            static void write(SegmentedBuffer& out, quint64 value)
+            {
+                out.write64(value);
+            }
+
+            /**
+             * \brief Decode a value.
+             */
+            static void read(binary::const_iterator& pos, bool big_endian,
+                             qint32& value)
+            {
+                value = read32(pos, big_endian);
+            }
+
+            /**
+             * \brief Decode a value.
+             */
+            static void read(binary::const_iterator& pos, bool big_endian,
+                             quint32& value)
+            {
+                value = read32(pos, big_endian);
+            }
+
+            /**
+             * \brief Decode a value.
+             */
+            static void read(binary::const_iterator& pos, bool big_endian,
+                             quint64& value)
+            {
+                value = read64(pos, big_endian);
+            }
+
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * \param _value The initial value.
+             *
+             * \exception None.
+             */
+            ScalarVariable(T _value = T())
+            : v(_value), new_value()
+            {
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Parse Constructor.
+             *
+             * This constructor parses the serialized form of the object.
+             * It takes an iterator, starts parsing at the position of the 
+             * iterator and advances the iterator to the position right behind 
+             * the object.
+             * 
+             * The constructor expects valid data from the stream; if parsing 
+             * fails, parse_error is thrown. In this case, the iterator 
+             * position is undefined.
+             *
+             * \param pos Iterator pointing to the current stream position.
+             *            The iterator is advanced while parsing.
+             *
+             * \param end Iterator pointing one element past the end of the
+             *            current stream. This is needed to avoid buffer 
+             *            overrun.
+             *
+             * \param big_endian Whether the input stream is in big endian
+             *                   format.
+             */
+            ScalarVariable(binary::const_iterator& pos,
+                           const binary::const_iterator& end,
+                           bool big_endian)
+            : new_value()
+            {
+                // Are there enough bytes in the buffer?
+                if(end - pos < static_cast<int>(sizeof(T)))
+                {
+                    throw(parse_error());
+                }
+
+                // Get value
+                read(pos, big_endian, v);
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Encode the object as described in RFC 2741, section   
+             *        5.4.
+             *
+             * This function uses big endian.
+             */
+            virtual binary serialize() const
+            {
+                binary serialized;
+                write(serialized, v);
+                return serialized;
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Encode the object into a segmented buffer.
+             *
+             * The value is written directly into the buffer, without a
+             * temporary binary object, in the buffer's byte order.
+             */
+            virtual void serialize_to(SegmentedBuffer& out) const
+            {
+                write(out, v);
+            }
+
+            /**
+             * \brief Set the value.
+             * 
+             * \param _value The new value.
+             */
+            void setValue(T _value)
+            {
+                v = _value;
+            }
+
+            /**
+             * \brief Get the current value.
+             *
+             * \return The value.
+             */
+            virtual T value()
+            {
+                return v;
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Handle a Get Request.
+             *
+             * This function calls perform_get() to update the internal 
+             * value.
+             */
+            virtual void handle_get()
+            {
+                perform_get();
+            }
+
+            /**
+             * \brief Perform a Get request.
+             *
+             * This method is invoked when an SNMP Get request is received.
+             * It should update the internal value \ref v.
+             */
+            virtual void perform_get()
+            {
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Handle a TestSet request.
+             *
+             * This function converts the argument, stores its value in \ref 
+             * new_value and then calls perform_testset() with \ref new_value.  
+             * If conversion fails, \agentxcpp{AbstractVariable::wrongType} is 
+             * returned and perform_testset() is not called.
+             *
+             * The value is copied, so the argument is not referenced after 
+             * this call.
+             *
+             * \param _v The new value for the variable.
+             *
+             * \return \agentxcpp{AbstractVariable::wrongType}
+             *         if the conversion fails.  Otherwise, the result of
+             *         perform_testset() is returned.
+             */
+            virtual testset_result_t handle_testset(QSharedPointer<AbstractVariable> _v)
+            {
+                Self* value = dynamic_cast<Self*>(_v.data());
+                if (value)
+                {
+                    // Type matches variable
+                    new_value = static_cast<ScalarVariable*>(value)->v;
+                    return perform_testset(new_value);
+                }
+                else
+                {
+                    // Wrong type
+                    return wrongType;
+                }
+            }
+
+            /**
+             * \brief Perform an SNMP TestSet request.
+             *
+             * This method is invoked when an SNMP TestSet request is 
+             * received.
+             * It shall check whether a Set operation is possible for the
+             * variable.  It shall acquire the resources needed to perform the
+             * Set operation (but the Set operation shall not yet be 
+             * performed).
+             *
+             * The default implementation returns 
+             * \agentxcpp{AbstractVariable::noAccess} to indicate that
+             * this is a read-only variable. Thus, for read-only variables this
+             * method need not be overridden.
+             *
+             * \param _v The new value provided by the master agent.
+             *
+             * \return The result of the check (this is reported to the master 
+             *         agent).
+             */
+            virtual testset_result_t perform_testset(T _v)
+            {
+                return noAccess;
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Handle a CleanupSet request.
+             *
+             * This function calls perform_cleanupset() with \ref new_value 
+             * (which was updated by the last \ref handle_testset() 
+             * invocation).
+             */
+            virtual void handle_cleanupset()
+            {
+                perform_cleanupset(new_value);
+            }
+
+            /**
+             * \brief Perform an SNMP CleanupSet request.
+             *
+             * This method is invoked when an SNMP CleanupSet request is
+             * received. It shall release any resources allocated by 
+             * perform_testset().
+             *
+             * The default implementation does nothing. If no action is
+             * required to perform the CleanupSet operation, this method need
+             * not be overridden.
+             *
+             * \param _v The value to which the variable was (possibly) set.
+             */
+            virtual void perform_cleanupset(T _v)
+            {
+                return;
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Handle a CommitSet request.
+             *
+             * This function calls \ref perform_commitset() with \ref 
+             * new_value (which was updated by the last \ref handle_testset() 
+             * invocation).
+             *
+             * \return The return value of perform_commitset().
+             */
+            virtual bool handle_commitset()
+            {
+                return perform_commitset(new_value);
+            }
+
+            /**
+             * \brief Perform an SNMP CommitSet request.
+             *
+             * This method is invoked when an SNMP CommitSet request is
+             * received. It shall perform the actual write operation.
+             *
+             * The default implementation returns false to indicate that the
+             * operation failed. To implement a writeable SNMP variable this
+             * method must be overridden.
+             *
+             * \param _v The value which shall be written.
+             *
+             * \return True if the operation succeeded, false otherwise.
+             */
+            virtual bool perform_commitset(T _v)
+            {
+                return false;
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Handle an UndoSet request.
+             *
+             * This function calls perform_undoset() with \ref new_value 
+             * (which was updated by the last \ref handle_testset() 
+             * invocation).
+             *
+             * \return The return value of perform_undoset().
+             *
+             */
+            virtual bool handle_undoset()
+            {
+                return perform_undoset(new_value);
+            }
+
+            /**
+             * \brief Perform an SNMP UndoSet request.
+             *
+             * This method is invoked when an SNMP UndoSet request is 
+             * received.
+             * It shall undo whatever perform_commitset() performed. It shall 
+             * also release all resources allocated by perform_testset(), 
+             * because perform_cleanupset() \e will \e not be called 
+             * afterwards.
+             *
+             * The default implementation returns false to indicate that
+             * the operation failed. It is strongly recommended that writeable
+             * variables override this method.
+             *
+             * \param _v The value just set by perform_commitset().
+             *
+             * \return True on success, false otherwise.
+             */
+            virtual bool perform_undoset(T _v)
+            {
+                return false;
+            }
+    };
+}
+
+#endif  // _SCALARVARIABLE_HPP_
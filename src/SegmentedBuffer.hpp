@@ -0,0 +1,406 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#ifndef _SEGMENTEDBUFFER_HPP_
+#define _SEGMENTEDBUFFER_HPP_
+
+#include <cstring>
+#include <vector>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QList>
+
+#include "binary.hpp"
+#include "util.hpp"
+#include "RequestArena.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \internal
+     *
+     * \brief A byte stream made up of several segments.
+     *
+     * The serialized form of a %PDU is usually built in a single binary
+     * object, which is assembled from many temporary binary objects (one
+     * per varbind, OID and value). Variables holding large values (see
+     * ByteArrayVariable) have to copy their value into that object, and the
+     * whole object is copied once more into the socket's write buffer.
+     *
+     * A SegmentedBuffer avoids these copies and allocations: small pieces
+     * of data (headers, OID's, numbers) are written into memory taken from
+     * a RequestArena, while large values are appended as references to
+     * their QByteArray (which is implicitly shared, so that no bytes are
+     * copied). The segments are finally handed to the socket in a single
+     * sendmsg() call.
+     *
+     * The buffer is meant to be reused: clear() resets the arena, but keeps
+     * the arena's memory and the capacity of the segment list, so that
+     * serializing similar PDU's does not allocate heap memory anymore.
+     *
+     * Numbers are written in big endian format unless setBigEndian(false)
+     * was called (RFC 2741 lets the sender choose the byte order of each
+     * %PDU). If the chosen byte order is the host's, numbers and arrays of
+     * numbers are copied with memcpy() instead of being written byte by
+     * byte. Only PDU's which serialize themselves into the buffer (and not
+     * into a binary object) follow the byte order of the buffer; they set
+     * the NETWORK_BYTE_ORDER flag of their header accordingly.
+     */
+    class SegmentedBuffer
+    {
+        public:
+            /**
+             * \brief A segment.
+             */
+            struct Segment
+            {
+                const char* data;
+                quint32 size;
+            };
+
+            /**
+             * \brief Create an empty buffer.
+             *
+             * \exception None.
+             */
+            SegmentedBuffer()
+            : total(0),
+              last_owned(false),
+              big_endian(true)
+            {
+            }
+
+            /**
+             * \brief Set the byte order of the written numbers.
+             *
+             * The byte order is kept by clear().
+             *
+             * \exception None.
+             */
+            void setBigEndian(bool enabled)
+            {
+                big_endian = enabled;
+            }
+
+            /**
+             * \brief Get the byte order of the written numbers.
+             *
+             * \exception None.
+             */
+            bool bigEndian() const
+            {
+                return big_endian;
+            }
+
+            /**
+             * \brief Append uninitialized bytes.
+             *
+             * The bytes are contiguous to the previously appended bytes if
+             * possible, so that they don't start a new segment.
+             *
+             * \return The appended bytes, to be filled in by the caller.
+             *         They remain valid until clear() is called.
+             *
+             * \exception std::bad_alloc If memory is exhausted.
+             */
+            quint8* allocate(quint32 size)
+            {
+                char* p = static_cast<char*>(arena.allocate(size, 1));
+                if(   last_owned
+                   && segments.back().data + segments.back().size == p )
+                {
+                    // Extend the last segment
+                    segments.back().size += size;
+                }
+                else
+                {
+                    Segment s;
+                    s.data = p;
+                    s.size = size;
+                    segments.push_back(s);
+                    last_owned = true;
+                }
+                total += size;
+                return reinterpret_cast<quint8*>(p);
+            }
+
+            /**
+             * \brief Append data by copying it.
+             *
+             * \exception std::bad_alloc If memory is exhausted.
+             */
+            void append(const quint8* data, quint32 size)
+            {
+                if(size != 0)
+                {
+                    memcpy(allocate(size), data, size);
+                }
+            }
+
+            /**
+             * \brief Append data by copying it.
+             *
+             * \exception std::bad_alloc If memory is exhausted.
+             */
+            void append(const binary& data)
+            {
+                append(data.data(), data.size());
+            }
+
+            /**
+             * \brief Append data without copying it.
+             *
+             * The QByteArray is referenced by the buffer until clear() is
+             * called.
+             *
+             * \exception None.
+             */
+            void append(const QByteArray& data)
+            {
+                if(data.isEmpty())
+                {
+                    return;
+                }
+                refs.append(data);
+                Segment s;
+                s.data = refs.last().constData();
+                s.size = data.size();
+                segments.push_back(s);
+                last_owned = false;
+                total += data.size();
+            }
+
+            /**
+             * \brief Append a 16-bit value in the buffer's byte order.
+             *
+             * \exception std::bad_alloc If memory is exhausted.
+             */
+            void write16(quint16 value)
+            {
+                quint8* p = allocate(2);
+                if(big_endian == host_big_endian)
+                {
+                    memcpy(p, &value, 2);
+                }
+                else if(big_endian)
+                {
+                    p[0] = value >> 8 & 0xff;
+                    p[1] = value >> 0 & 0xff;
+                }
+                else
+                {
+                    p[0] = value >> 0 & 0xff;
+                    p[1] = value >> 8 & 0xff;
+                }
+            }
+
+            /**
+             * \brief Append a 32-bit value in the buffer's byte order.
+             *
+             * \exception std::bad_alloc If memory is exhausted.
+             */
+            void write32(quint32 value)
+            {
+                put32(allocate(4), value);
+            }
+
+            /**
+             * \brief Append a 64-bit value in the buffer's byte order.
+             *
+             * \exception std::bad_alloc If memory is exhausted.
+             */
+            void write64(quint64 value)
+            {
+                if(big_endian == host_big_endian)
+                {
+                    memcpy(allocate(8), &value, 8);
+                }
+                else if(big_endian)
+                {
+                    write32(value >> 32);
+                    write32(value & 0xffffffff);
+                }
+                else
+                {
+                    write32(value & 0xffffffff);
+                    write32(value >> 32);
+                }
+            }
+
+            /**
+             * \brief Store 32-bit values in the buffer's byte order.
+             *
+             * This is used for arrays of numbers (e.g. the subidentifiers
+             * of an OID), which are copied at once if the buffer uses the
+             * host's byte order.
+             *
+             * \param p The destination, e.g. obtained from allocate().
+             *
+             * \param values The values.
+             *
+             * \param count The number of values.
+             *
+             * \exception None.
+             */
+            void store32(quint8* p, const quint32* values, quint32 count) const
+            {
+                if(big_endian == host_big_endian)
+                {
+                    memcpy(p, values, 4 * count);
+                    return;
+                }
+                for(quint32 i = 0; i < count; i++)
+                {
+                    put32(p + 4 * i, values[i]);
+                }
+            }
+
+            /**
+             * \brief Remove all data.
+             *
+             * The memory is kept for reuse.
+             *
+             * \exception None.
+             */
+            void clear()
+            {
+                segments.clear();
+                refs.clear();
+                arena.reset();
+                total = 0;
+                last_owned = false;
+            }
+
+            /**
+             * \brief Get the total number of bytes.
+             *
+             * \exception None.
+             */
+            quint32 size() const
+            {
+                return total;
+            }
+
+            /**
+             * \brief Get the number of segments.
+             *
+             * \exception None.
+             */
+            int count() const
+            {
+                return segments.size();
+            }
+
+            /**
+             * \brief Get a segment.
+             *
+             * \exception None.
+             */
+            const Segment& segment(int i) const
+            {
+                return segments[i];
+            }
+
+            /**
+             * \brief Copy all segments into one binary object.
+             *
+             * \exception None.
+             */
+            binary toBinary() const
+            {
+                binary result;
+                result.reserve(total);
+                for(std::size_t i = 0; i < segments.size(); i++)
+                {
+                    result.append(reinterpret_cast<const quint8*>(
+                                segments[i].data), segments[i].size);
+                }
+                return result;
+            }
+
+        private:
+            /**
+             * \brief Store a 32-bit value in the buffer's byte order.
+             */
+            void put32(quint8* p, quint32 value) const
+            {
+                if(big_endian == host_big_endian)
+                {
+                    memcpy(p, &value, 4);
+                }
+                else if(big_endian)
+                {
+                    p[0] = value >> 24 & 0xff;
+                    p[1] = value >> 16 & 0xff;
+                    p[2] = value >> 8 & 0xff;
+                    p[3] = value >> 0 & 0xff;
+                }
+                else
+                {
+                    p[0] = value >> 0 & 0xff;
+                    p[1] = value >> 8 & 0xff;
+                    p[2] = value >> 16 & 0xff;
+                    p[3] = value >> 24 & 0xff;
+                }
+            }
+
+            /**
+             * \brief The memory of the copied data.
+             */
+            RequestArena arena;
+
+            /**
+             * \brief The segments.
+             */
+            std::vector<Segment> segments;
+
+            /**
+             * \brief The referenced QByteArray's.
+             */
+            QList<QByteArray> refs;
+
+            /**
+             * \brief The total number of bytes.
+             */
+            quint32 total;
+
+            /**
+             * \brief Whether the last segment lies in the arena.
+             */
+            bool last_owned;
+
+            /**
+             * \brief Whether numbers are written in big endian format.
+             */
+            bool big_endian;
+
+            /**
+             * \brief Copying is not allowed.
+             */
+            SegmentedBuffer(const SegmentedBuffer&);
+
+            /**
+             * \brief Assignment is not allowed.
+             */
+            SegmentedBuffer& operator=(const SegmentedBuffer&);
+    };
+}
+
+#endif /* _SEGMENTEDBUFFER_HPP_ */
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#include <cstring>
+
+#include <QThread>
+
+#include "ShardedCounter.hpp"
+
+using namespace agentxcpp;
+
+
+__thread int ShardedCounter::thread_shard = -1;
+
+
+ShardedCounter::ShardedCounter(int shards_wanted)
+{
+    if(shards_wanted <= 0)
+    {
+        // One shard per CPU
+        shards_wanted = QThread::idealThreadCount();
+    }
+
+    // Round up to a power of two
+    int shard_count = 1;
+    while(shard_count < shards_wanted && shard_count < 0x40000000)
+    {
+        shard_count *= 2;
+    }
+    shard_mask = shard_count - 1;
+
+    // Allocate shards, aligned to a cache line boundary
+    storage = new char[(shard_count + 1) * sizeof(Shard)];
+    quintptr address = reinterpret_cast<quintptr>(storage);
+    address = (address + cache_line_size - 1) & ~quintptr(cache_line_size - 1);
+    shards = reinterpret_cast<Shard*>(address);
+
+    memset(shards, 0, shard_count * sizeof(Shard));
+}
+
+
+ShardedCounter::~ShardedCounter()
+{
+    delete[] storage;
+}
+
+
+quint64 ShardedCounter::sum() const
+{
+    quint64 result = 0;
+    for(int i = 0; i <= shard_mask; i++)
+    {
+        result += __atomic_load_n(&shards[i].value, __ATOMIC_RELAXED);
+    }
+    return result;
+}
+
+
+int ShardedCounter::assign_shard()
+{
+    static int next_thread = 0;
+    thread_shard = __sync_fetch_and_add(&next_thread, 1) & 0x7fffffff;
+    return thread_shard;
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#ifndef _SHARDEDCOUNTER_HPP_
+#define _SHARDEDCOUNTER_HPP_
+
+#include <QtGlobal>
+
+namespace agentxcpp
+{
+    /**
+     * \brief A 64-bit counter which can be incremented concurrently from
+     *        many threads.
+     *
+     * A counter which is incremented by several threads at a high rate 
+     * suffers from two problems: plain increments are data races, and 
+     * atomic increments on a single memory location make the cache line 
+     * bounce between the CPU cores, so that the update rate does not scale 
+     * with the number of cores.
+     *
+     * The ShardedCounter avoids both problems. It consists of a number of 
+     * shards, each residing in its own cache line. Each thread is assigned 
+     * one shard (on its first update of any ShardedCounter) and only 
+     * updates this shard, using an atomic add without ordering constraints.  
+     * Thus, updates are wait-free and threads do not share cache lines as 
+     * long as there are not more threads than shards. The shards are summed 
+     * up only when the value is read.
+     *
+     * Each shard occupies a cache line of 64 bytes, and the shards of a 
+     * counter occupy one additional cache line for alignment. By default, 
+     * a counter has one shard per CPU (rounded up to a power of two), so 
+     * that it needs 576 bytes on a machine with 8 CPUs, or 4160 bytes with 
+     * 64 CPUs. Applications with many counters which are rarely updated 
+     * concurrently can pass a smaller number of shards to the constructor; 
+     * a counter with a single shard needs 128 bytes.
+     *
+     * The ShardedCounter is used by the ShardedCounter32Variable and 
+     * ShardedCounter64Variable classes.
+     */
+    class ShardedCounter
+    {
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * All shards are initialized to 0.
+             *
+             * \param shards The number of shards. It is rounded up to a 
+             *               power of two. 0 (the default) selects the 
+             *               number of CPUs.
+             *
+             * \exception None.
+             */
+            ShardedCounter(int shards = 0);
+
+            /**
+             * \brief Destructor.
+             */
+            ~ShardedCounter();
+
+            /**
+             * \brief Add a value to the counter.
+             *
+             * This method is wait-free and may be called from any thread.
+             *
+             * \param delta The value to add.
+             *
+             * \exception None.
+             */
+            void add(quint64 delta)
+            {
+                int index = thread_shard;
+                if(index < 0)
+                {
+                    index = assign_shard();
+                }
+                __atomic_fetch_add(&shards[index & shard_mask].value, delta,
+                                   __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Get the current value.
+             *
+             * The shards are summed up. Updates performed concurrently may 
+             * or may not be included in the result.
+             *
+             * \return The sum of all shards.
+             *
+             * \exception None.
+             */
+            quint64 sum() const;
+
+        private:
+            /**
+             * \brief Copy constructor (not implemented).
+             *
+             * A ShardedCounter cannot be copied.
+             */
+            ShardedCounter(const ShardedCounter&);
+
+            /**
+             * \brief Assignment operator (not implemented).
+             *
+             * A ShardedCounter cannot be copied.
+             */
+            ShardedCounter& operator=(const ShardedCounter&);
+
+            enum
+            {
+                /**
+                 * \brief The assumed size of a cache line, in bytes.
+                 */
+                cache_line_size = 64
+            };
+
+            /**
+             * \brief A shard, filling a whole cache line.
+             */
+            struct Shard
+            {
+                quint64 value;
+                char padding[cache_line_size - sizeof(quint64)];
+            };
+
+            /**
+             * \brief Memory for the shards.
+             *
+             * Allocated with one additional cache line, so that shards can
+             * be aligned to a cache line boundary.
+             */
+            char* storage;
+
+            /**
+             * \brief The shards (pointing into storage).
+             */
+            Shard* shards;
+
+            /**
+             * \brief The number of shards minus 1.
+             *
+             * The number of shards is a power of two, so that a thread's 
+             * shard is found by masking its thread_shard.
+             */
+            int shard_mask;
+
+            /**
+             * \brief The number of the current thread, or -1 if none was 
+             *        assigned yet.
+             *
+             * The thread updates the shard thread_shard & shard_mask of 
+             * each counter.
+             */
+            static __thread int thread_shard;
+
+            /**
+             * \brief Assign a number to the current thread.
+             *
+             * Numbers are assigned consecutively, so that threads are 
+             * distributed round-robin over the shards.
+             *
+             * \return The assigned number.
+             */
+            static int assign_shard();
+    };
+
+} /* namespace agentxcpp */
+#endif /* _SHARDEDCOUNTER_HPP_ */
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#ifndef _SHARDEDCOUNTER64VARIABLE_HPP_
+#define _SHARDEDCOUNTER64VARIABLE_HPP_
+
+#include "Counter64Variable.hpp"
+#include "ShardedCounter.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \brief A Counter64 variable for counters which are updated from many
+     *        threads at a high rate.
+     *
+     * The counter is incremented with increment(), which is wait-free and 
+     * may be called from any thread (e.g. from packet processing threads) 
+     * without further locking. The increments are collected in a 
+     * ShardedCounter, i.e. each thread updates its own cache line. The 
+     * shards are summed up only when the value is requested by the master 
+     * agent or by calling value().
+     *
+     * \note Use increment() instead of setValue(): the value set with 
+     *       setValue() is replaced by the sum of the increments on the next 
+     *       Get request.
+     */
+    class ShardedCounter64Variable : public Counter64Variable
+    {
+        private:
+
+            /**
+             * \brief The counter shards.
+             */
+            ShardedCounter counter;
+
+        public:
+
+            /**
+             * \brief Constructor.
+             *
+             * The counter starts at 0.
+             *
+             * \param shards The number of shards of the counter (see 
+             *               ShardedCounter::ShardedCounter()).
+             *
+             * \exception None.
+             */
+            ShardedCounter64Variable(int shards = 0)
+            : counter(shards)
+            {
+            }
+
+            /**
+             * \brief Increment the counter.
+             *
+             * This method is wait-free and may be called from any thread.
+             *
+             * \param delta The value to add.
+             *
+             * \exception None.
+             */
+            void increment(quint64 delta = 1)
+            {
+                counter.add(delta);
+            }
+
+            /**
+             * \brief Get the current value.
+             *
+             * \return The sum of all increments.
+             */
+            virtual quint64 value()
+            {
+                return counter.sum();
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Handle a Get request.
+             *
+             * Sums up the shards, then calls perform_get().
+             */
+            virtual void handle_get()
+            {
+                v = value();
+                perform_get();
+            }
+    };
+
+} /* namespace agentxcpp */
+#endif /* _SHARDEDCOUNTER64VARIABLE_HPP_ */
@@ -0,0 +1,390 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#ifndef _SHAREDSTATSPRODUCER_HPP_
+#define _SHAREDSTATSPRODUCER_HPP_
+
+/*
+ * This header is used by processes which publish statistics for an agentXcpp 
+ * subagent. It depends neither on Qt nor on the agentXcpp library, so that it 
+ * can be included by data plane code without further dependencies.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace agentxcpp
+{
+    /**
+     * \brief The header of a shared statistics region.
+     *
+     * A shared statistics region is a POSIX shared memory object consisting 
+     * of this header, followed by slot_count 64-bit values (the "slots").  
+     * The region is written by a single producer (see SharedStatsProducer) 
+     * and read by the subagent (see SharedStatsRegion).
+     *
+     * The slots are protected by a sequence lock: the producer increments 
+     * the sequence number before and after an update, so that it is odd 
+     * while the update is in progress. A reader reads the sequence number, 
+     * then the slots, then the sequence number again. If both numbers are 
+     * equal and even, the values read are a consistent snapshot; otherwise 
+     * the reader retries.
+     *
+     * A region is never resized in place, because readers which mapped the 
+     * old size would crash when accessing slots beyond the new end. Instead, 
+     * SharedStatsProducer::create() retires the old region by clearing its 
+     * magic, removes it and creates a new one with the next generation 
+     * number. Readers detect the cleared magic and re-open the region by 
+     * name.
+     *
+     * The header occupies a whole cache line, so that the slots start at a 
+     * cache line boundary.
+     */
+    struct SharedStatsHeader
+    {
+        /**
+         * \brief Identifies a shared statistics region.
+         *
+         * Written last when the region is created, so that a reader never 
+         * sees a partially initialized header. Cleared when the region is 
+         * retired.
+         */
+        uint32_t magic;
+
+        /**
+         * \brief The layout version (currently 2).
+         */
+        uint32_t layout_version;
+
+        /**
+         * \brief The number of slots following the header.
+         */
+        uint32_t slot_count;
+
+        /**
+         * \brief The sequence number (odd while an update is in progress).
+         */
+        uint32_t sequence;
+
+        /**
+         * \brief Incremented each time the region is re-created.
+         */
+        uint32_t generation;
+
+        /**
+         * \brief Unused, fills the header up to 64 bytes.
+         */
+        char padding[44];
+
+        enum
+        {
+            /**
+             * \brief The value of the magic member ("AXSS").
+             */
+            magic_value = 0x41585353,
+
+            /**
+             * \brief The current value of the layout_version member.
+             */
+            current_layout_version = 2
+        };
+    };
+
+    /**
+     * \brief Publish statistics in a shared statistics region.
+     *
+     * This class is used by the process which produces the statistics (e.g.  
+     * a data plane process). It creates the shared memory object and writes 
+     * the slots. The subagent reads them using SharedStatsRegion and the 
+     * shared variable types (e.g. SharedCounter64Variable) or a ColumnarTable 
+     * with shared columns.
+     *
+     * Only a single producer may write to a region. Updates are grouped by 
+     * begin_update() and end_update(); all slots written in between become 
+     * visible to readers at once:
+     * \code
+     * SharedStatsProducer stats;
+     * stats.create("/myapp-stats", 16);
+     * ...
+     * stats.begin_update();
+     * stats.add(0, packets);
+     * stats.add(1, bytes);
+     * stats.end_update();
+     * \endcode
+     *
+     * This class is implemented completely in this header and does not 
+     * depend on Qt or on the agentXcpp library.
+     */
+    class SharedStatsProducer
+    {
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * The producer is not connected to a region until create() is 
+             * called.
+             */
+            SharedStatsProducer()
+            : header(0), slot_values(0), size(0)
+            {
+            }
+
+            /**
+             * \brief Destructor.
+             *
+             * Unmaps the region. The shared memory object is not removed.
+             */
+            ~SharedStatsProducer()
+            {
+                close();
+            }
+
+            /**
+             * \brief Create (or re-create) a shared statistics region.
+             *
+             * An existing shared memory object with the same name is 
+             * retired and removed (see SharedStatsHeader), and a new object 
+             * is created. Readers keep their mapping of the old object until 
+             * they re-open the region. All slots are set to 0.
+             *
+             * \param name The name of the shared memory object (see 
+             *             shm_open(3)), e.g. "/myapp-stats".
+             *
+             * \param slot_count The number of slots.
+             *
+             * \return true on success, false otherwise.
+             */
+            bool create(const char* name, uint32_t slot_count)
+            {
+                close();
+
+                uint32_t generation = retire(name);
+                int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+                if(fd == -1)
+                {
+                    return false;
+                }
+                size_t length = sizeof(SharedStatsHeader)
+                                + slot_count * sizeof(uint64_t);
+                if(ftruncate(fd, length) == -1)
+                {
+                    ::close(fd);
+                    shm_unlink(name);
+                    return false;
+                }
+                void* address = mmap(0, length, PROT_READ | PROT_WRITE,
+                                     MAP_SHARED, fd, 0);
+                ::close(fd);
+                if(address == MAP_FAILED)
+                {
+                    shm_unlink(name);
+                    return false;
+                }
+
+                header = static_cast<SharedStatsHeader*>(address);
+                slot_values = reinterpret_cast<uint64_t*>(header + 1);
+                size = length;
+
+                // Initialize header (the new object is zero-filled); the 
+                // magic is written last
+                header->layout_version = SharedStatsHeader::current_layout_version;
+                header->slot_count = slot_count;
+                header->sequence = 0;
+                header->generation = generation;
+                __atomic_store_n(&header->magic,
+                                 static_cast<uint32_t>(SharedStatsHeader::magic_value),
+                                 __ATOMIC_RELEASE);
+
+                return true;
+            }
+
+            /**
+             * \brief Unmap the region.
+             *
+             * The shared memory object is not removed, see remove().
+             */
+            void close()
+            {
+                if(header)
+                {
+                    munmap(header, size);
+                    header = 0;
+                    slot_values = 0;
+                    size = 0;
+                }
+            }
+
+            /**
+             * \brief Remove a shared memory object.
+             *
+             * Readers which mapped the region keep their mapping.
+             *
+             * \param name The name given to create().
+             *
+             * \return true on success, false otherwise.
+             */
+            static bool remove(const char* name)
+            {
+                return shm_unlink(name) == 0;
+            }
+
+            /**
+             * \brief Get the number of slots.
+             *
+             * \return The number of slots, or 0 if no region was created.
+             */
+            uint32_t slot_count() const
+            {
+                return header ? header->slot_count : 0;
+            }
+
+            /**
+             * \brief Start an update.
+             *
+             * Readers retry while an update is in progress, so updates 
+             * should be short.
+             */
+            void begin_update()
+            {
+                uint32_t seq = __atomic_load_n(&header->sequence,
+                                               __ATOMIC_RELAXED);
+                __atomic_store_n(&header->sequence, seq + 1,
+                                 __ATOMIC_RELAXED);
+                __atomic_thread_fence(__ATOMIC_RELEASE);
+            }
+
+            /**
+             * \brief Finish an update.
+             */
+            void end_update()
+            {
+                uint32_t seq = __atomic_load_n(&header->sequence,
+                                               __ATOMIC_RELAXED);
+                __atomic_store_n(&header->sequence, seq + 1,
+                                 __ATOMIC_RELEASE);
+            }
+
+            /**
+             * \brief Set a slot.
+             *
+             * Must be called between begin_update() and end_update().
+             *
+             * \param slot The slot number (must be less than slot_count()).
+             *
+             * \param value The new value.
+             */
+            void set(uint32_t slot, uint64_t value)
+            {
+                __atomic_store_n(&slot_values[slot], value, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Add a value to a slot.
+             *
+             * Must be called between begin_update() and end_update().
+             *
+             * \param slot The slot number (must be less than slot_count()).
+             *
+             * \param delta The value to add.
+             */
+            void add(uint32_t slot, uint64_t delta)
+            {
+                uint64_t value = __atomic_load_n(&slot_values[slot],
+                                                 __ATOMIC_RELAXED);
+                __atomic_store_n(&slot_values[slot], value + delta,
+                                 __ATOMIC_RELAXED);
+            }
+
+        private:
+            /**
+             * \brief Retire and remove an existing region.
+             *
+             * The magic of the existing region is cleared, so that readers 
+             * re-open the region. The object itself is left intact, because 
+             * readers may still access it.
+             *
+             * \param name The name of the shared memory object.
+             *
+             * \return The generation number for the new region.
+             */
+            static uint32_t retire(const char* name)
+            {
+                uint32_t generation = 0;
+                int fd = shm_open(name, O_RDWR, 0);
+                if(fd == -1)
+                {
+                    return generation;
+                }
+                struct stat st;
+                if(fstat(fd, &st) == 0
+                   && static_cast<size_t>(st.st_size) >= sizeof(SharedStatsHeader))
+                {
+                    void* address = mmap(0, sizeof(SharedStatsHeader),
+                                         PROT_READ | PROT_WRITE,
+                                         MAP_SHARED, fd, 0);
+                    if(address != MAP_FAILED)
+                    {
+                        SharedStatsHeader* h
+                            = static_cast<SharedStatsHeader*>(address);
+                        if(__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE)
+                           == SharedStatsHeader::magic_value)
+                        {
+                            generation = h->generation + 1;
+                        }
+                        __atomic_store_n(&h->magic, 0, __ATOMIC_RELEASE);
+                        munmap(address, sizeof(SharedStatsHeader));
+                    }
+                }
+                ::close(fd);
+                shm_unlink(name);
+                return generation;
+            }
+
+            /**
+             * \brief Copy constructor (not implemented).
+             */
+            SharedStatsProducer(const SharedStatsProducer&);
+
+            /**
+             * \brief Assignment operator (not implemented).
+             */
+            SharedStatsProducer& operator=(const SharedStatsProducer&);
+
+            /**
+             * \brief The mapped region, or 0.
+             */
+            SharedStatsHeader* header;
+
+            /**
+             * \brief The slots (behind the header).
+             */
+            uint64_t* slot_values;
+
+            /**
+             * \brief The size of the mapped region.
+             */
+            size_t size;
+    };
+
+} /* namespace agentxcpp */
+#endif /* _SHAREDSTATSPRODUCER_HPP_ */
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#include "SharedStatsRegion.hpp"
+
+using namespace agentxcpp;
+
+
+/**
+ * \brief How often a read is retried while the producer is updating.
+ */
+static const int max_read_attempts = 1000;
+
+
+SharedStatsRegion::SharedStatsRegion(const char* name)
+: header(0), slot_values(0), slot_count(0), region_generation(0), size(0)
+{
+    open(name);
+}
+
+
+SharedStatsRegion::~SharedStatsRegion()
+{
+    close();
+}
+
+
+void SharedStatsRegion::close()
+{
+    if(header)
+    {
+        munmap(const_cast<SharedStatsHeader*>(header), size);
+        header = 0;
+        slot_values = 0;
+        slot_count = 0;
+        region_generation = 0;
+        size = 0;
+    }
+}
+
+
+bool SharedStatsRegion::open(const char* name)
+{
+    close();
+    this->name = name;
+    return map();
+}
+
+
+bool SharedStatsRegion::map()
+{
+    int fd = shm_open(name.constData(), O_RDONLY, 0);
+    if(fd == -1)
+    {
+        return false;
+    }
+
+    // The region must at least contain the header
+    struct stat st;
+    if(fstat(fd, &st) == -1
+       || static_cast<size_t>(st.st_size) < sizeof(SharedStatsHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t length = st.st_size;
+    void* address = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(address == MAP_FAILED)
+    {
+        return false;
+    }
+    const SharedStatsHeader* h = static_cast<const SharedStatsHeader*>(address);
+
+    // Check header (the magic is read first, it is written last)
+    if(__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != SharedStatsHeader::magic_value)
+    {
+        munmap(address, length);
+        return false;
+    }
+    quint32 count = h->slot_count;
+    if(   h->layout_version != SharedStatsHeader::current_layout_version
+       || sizeof(SharedStatsHeader) + count * sizeof(quint64) > length )
+    {
+        munmap(address, length);
+        return false;
+    }
+
+    // Replace the current mapping (if any)
+    close();
+    header = h;
+    slot_values = reinterpret_cast<const quint64*>(h + 1);
+    slot_count = count;
+    region_generation = h->generation;
+    size = length;
+    return true;
+}
+
+
+bool SharedStatsRegion::read(quint32 first, quint32 count, quint64* values)
+{
+    if(header && __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE)
+                 != SharedStatsHeader::magic_value)
+    {
+        // The producer retired the region: map the new one. Until the 
+        // producer has finished creating it, this fails and is retried with 
+        // the next read.
+        if(! map())
+        {
+            // Stay on the retired region (which is still mapped), so that 
+            // the next read retries
+            return false;
+        }
+    }
+
+    if(! header || first > slot_count || count > slot_count - first)
+    {
+        // Region not open or slots out of range
+        return false;
+    }
+
+    for(int attempt = 0; attempt < max_read_attempts; attempt++)
+    {
+        quint32 before = __atomic_load_n(&header->sequence, __ATOMIC_ACQUIRE);
+        if(before & 1)
+        {
+            // Update in progress
+            continue;
+        }
+
+        for(quint32 i = 0; i < count; i++)
+        {
+            values[i] = __atomic_load_n(&slot_values[first + i], __ATOMIC_RELAXED);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        quint32 after = __atomic_load_n(&header->sequence, __ATOMIC_RELAXED);
+        if(before == after)
+        {
+            // Consistent snapshot
+            return true;
+        }
+    }
+
+    // The producer seems to be stuck within an update
+    return false;
+}
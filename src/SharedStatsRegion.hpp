@@ -0,0 +1,202 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#ifndef _SHAREDSTATSREGION_HPP_
+#define _SHAREDSTATSREGION_HPP_
+
+#include <QtGlobal>
+#include <QByteArray>
+
+#include "SharedStatsProducer.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \brief Read-only access to a shared statistics region.
+     *
+     * A shared statistics region is written by another process using 
+     * SharedStatsProducer (see SharedStatsHeader for the layout). This class 
+     * maps the region read-only into the subagent's address space, so that 
+     * values can be read without copying them through IPC.
+     *
+     * The values are usually not read directly, but by the shared variable 
+     * types (e.g. SharedCounter64Variable) or by shared columns of a 
+     * ColumnarTable. Several variables may share one SharedStatsRegion 
+     * object.
+     *
+     * If the producer re-creates the region (e.g. after a restart, possibly 
+     * with a different number of slots), the old region is retired. read() 
+     * detects this and re-opens the region by name; see generation().
+     */
+    class SharedStatsRegion
+    {
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * Opens the region, see open().
+             *
+             * \param name The name of the shared memory object, as given to 
+             *             SharedStatsProducer::create().
+             *
+             * \exception None.
+             */
+            SharedStatsRegion(const char* name);
+
+            /**
+             * \brief Destructor.
+             *
+             * Unmaps the region.
+             */
+            ~SharedStatsRegion();
+
+            /**
+             * \brief (Re-)open the region.
+             *
+             * \param name The name of the shared memory object.
+             *
+             * \return true on success, false if the object does not exist, 
+             *         cannot be mapped or is not a valid shared statistics 
+             *         region.
+             *
+             * \exception None.
+             */
+            bool open(const char* name);
+
+            /**
+             * \brief Check whether the region is mapped.
+             *
+             * \exception None.
+             */
+            bool isOpen() const
+            {
+                return header != 0;
+            }
+
+            /**
+             * \brief Get the number of slots.
+             *
+             * \return The number of slots, or 0 if the region is not open.
+             *
+             * \exception None.
+             */
+            quint32 slotCount() const
+            {
+                return header ? slot_count : 0;
+            }
+
+            /**
+             * \brief Get the generation of the mapped region.
+             *
+             * The generation is incremented each time the producer 
+             * re-creates the region. A changed generation indicates that the 
+             * slots were reset and their number may have changed.
+             *
+             * \return The generation, or 0 if the region is not open.
+             *
+             * \exception None.
+             */
+            quint32 generation() const
+            {
+                return header ? region_generation : 0;
+            }
+
+            /**
+             * \brief Read a consistent snapshot of consecutive slots.
+             *
+             * The values are read directly from the shared memory. If the 
+             * producer is updating the region at the same time, the read is 
+             * retried, so that all values stem from the same update. If the 
+             * producer re-created the region, it is re-opened first.
+             *
+             * \param first The first slot to read.
+             *
+             * \param count The number of slots to read.
+             *
+             * \param values Receives count values.
+             *
+             * \return true on success, false if the region is not open or 
+             *         was retired and cannot be re-opened (yet), the slots do 
+             *         not exist, or no consistent snapshot could be read 
+             *         (e.g. because the producer died in the middle of an 
+             *         update).
+             *
+             * \exception None.
+             */
+            bool read(quint32 first, quint32 count, quint64* values);
+
+        private:
+            /**
+             * \brief Copy constructor (not implemented).
+             */
+            SharedStatsRegion(const SharedStatsRegion&);
+
+            /**
+             * \brief Assignment operator (not implemented).
+             */
+            SharedStatsRegion& operator=(const SharedStatsRegion&);
+
+            /**
+             * \brief Unmap the region.
+             */
+            void close();
+
+            /**
+             * \brief Map the region named by the name member.
+             *
+             * \return true on success, false otherwise.
+             */
+            bool map();
+
+            /**
+             * \brief The mapped region, or 0.
+             */
+            const SharedStatsHeader* header;
+
+            /**
+             * \brief The slots (behind the header).
+             */
+            const quint64* slot_values;
+
+            /**
+             * \brief The number of slots, as read when mapping the region.
+             *
+             * The header is writable by the producer, so the slot count is 
+             * not re-read from it.
+             */
+            quint32 slot_count;
+
+            /**
+             * \brief The generation, as read when mapping the region.
+             */
+            quint32 region_generation;
+
+            /**
+             * \brief The name of the shared memory object.
+             */
+            QByteArray name;
+
+            /**
+             * \brief The size of the mapped region.
+             */
+            size_t size;
+    };
+
+} /* namespace agentxcpp */
+#endif /* _SHAREDSTATSREGION_HPP_ */
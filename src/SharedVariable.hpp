@@ -0,0 +1,139 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#ifndef _SHAREDVARIABLE_HPP_
+#define _SHAREDVARIABLE_HPP_
+
+#include <QSharedPointer>
+
+#include "SharedStatsRegion.hpp"
+#include "IntegerVariable.hpp"
+#include "Counter32Variable.hpp"
+#include "Counter64Variable.hpp"
+#include "Gauge32Variable.hpp"
+#include "TimeTicksVariable.hpp"
+#include "exceptions.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \brief A variable whose value is read from a shared statistics region.
+     *
+     * The value of the variable is published by another process in a slot 
+     * of a shared statistics region (see SharedStatsProducer). On each Get 
+     * request, handle_get() reads the slot directly from the shared memory, 
+     * so no copying through setValue() is required in the subagent.
+     *
+     * This template is not used directly; use one of the typedefs 
+     * SharedIntegerVariable, SharedCounter32Variable, 
+     * SharedCounter64Variable, SharedGauge32Variable or 
+     * SharedTimeTicksVariable:
+     * \code
+     * QSharedPointer<SharedStatsRegion> region(
+     *         new SharedStatsRegion("/myapp-stats"));
+     * QSharedPointer<SharedCounter64Variable> packets(
+     *         new SharedCounter64Variable(region, 0));
+     * master.add_variable(packets_oid, packets);
+     * \endcode
+     *
+     * The slot value is converted to the variable's type by truncation.
+     *
+     * \tparam Base The variable class (e.g. Counter64Variable).
+     *
+     * \tparam T The type of the variable's value (e.g. quint64).
+     */
+    template<class Base, typename T>
+    class SharedVariable : public Base
+    {
+        private:
+
+            /**
+             * \brief The region containing the value.
+             */
+            QSharedPointer<SharedStatsRegion> region;
+
+            /**
+             * \brief The slot containing the value.
+             */
+            quint32 slot;
+
+        public:
+
+            /**
+             * \brief Constructor.
+             *
+             * \param r The region containing the value.
+             *
+             * \param s The slot within the region.
+             *
+             * \exception None.
+             */
+            SharedVariable(QSharedPointer<SharedStatsRegion> r, quint32 s)
+            : region(r), slot(s)
+            {
+            }
+
+            /**
+             * \internal
+             *
+             * \brief Handle a Get request.
+             *
+             * Reads the slot, then calls perform_get().
+             *
+             * \exception generic_error If the slot cannot be read.
+             */
+            virtual void handle_get()
+            {
+                quint64 value;
+                if(! region || ! region->read(slot, 1, &value))
+                {
+                    throw(generic_error());
+                }
+                this->setValue(static_cast<T>(value));
+                this->perform_get();
+            }
+    };
+
+    /**
+     * \brief An Integer variable read from a shared statistics region.
+     */
+    typedef SharedVariable<IntegerVariable, qint32> SharedIntegerVariable;
+
+    /**
+     * \brief A Counter32 variable read from a shared statistics region.
+     */
+    typedef SharedVariable<Counter32Variable, quint32> SharedCounter32Variable;
+
+    /**
+     * \brief A Counter64 variable read from a shared statistics region.
+     */
+    typedef SharedVariable<Counter64Variable, quint64> SharedCounter64Variable;
+
+    /**
+     * \brief A Gauge32 variable read from a shared statistics region.
+     */
+    typedef SharedVariable<Gauge32Variable, quint32> SharedGauge32Variable;
+
+    /**
+     * \brief A TimeTicks variable read from a shared statistics region.
+     */
+    typedef SharedVariable<TimeTicksVariable, quint32> SharedTimeTicksVariable;
+
+} /* namespace agentxcpp */
+#endif /* _SHAREDVARIABLE_HPP_ */
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#include "StatisticsHandler.hpp"
+
+using namespace agentxcpp;
+
+
+/**
+ * \brief How long collected values are served, in microseconds.
+ */
+static const quint64 max_age = 1000000;
+
+
+StatisticsHandler::StatisticsHandler(const Oid& oid,
+                                     const AgentStatistics& statistics)
+: myOid(oid),
+  stats(statistics),
+  values(oid),
+  collected(0)
+{
+}
+
+
+/**
+ * \brief Build the OID of a cell of a statistics table.
+ */
+static Oid cell(const Oid& subtree, quint32 table, quint32 column,
+                const Oid& index)
+{
+    Oid name(subtree, table);
+    name.push_back(1);
+    name.push_back(column);
+    name += index;
+    return name;
+}
+
+
+/**
+ * \brief Clamp a latency to the range of a Gauge32.
+ */
+static quint64 gauge(quint64 microseconds)
+{
+    return microseconds > 0xffffffffu ? 0xffffffffu : microseconds;
+}
+
+
+/**
+ * \brief Add the columns of a histogram to a statistics table.
+ */
+static void add_histogram(CompactVariables& values, const Oid& subtree,
+                          quint32 table, const Oid& index,
+                          const LatencyHistogram& histogram)
+{
+    values.add(cell(subtree, table, 4, index),
+               ColumnarTable::Counter64, histogram.sum());
+    for(int i = 0; i < LatencyHistogram::bucket_count; i++)
+    {
+        values.add(cell(subtree, table, 10 + i, index),
+                   ColumnarTable::Counter64, histogram.bucket(i));
+    }
+}
+
+
+void StatisticsHandler::collect()
+{
+    quint64 now = AgentStatistics::now();
+    if(collected != 0 && now - collected < max_age)
+    {
+        // The cached values are recent enough
+        return;
+    }
+    collected = now;
+    values.clear();
+
+    // Scalars
+    Oid scalars(myOid, 1);
+    ColumnarTable::column_type_t c64 = ColumnarTable::Counter64;
+    values.add(Oid(Oid(scalars, 1), 0), c64, stats.connects());
+    values.add(Oid(Oid(scalars, 2), 0), c64, stats.reconnects());
+    values.add(Oid(Oid(scalars, 3), 0), c64, stats.pdusSent());
+    values.add(Oid(Oid(scalars, 4), 0), c64, stats.pdusReceived());
+    values.add(Oid(Oid(scalars, 5), 0), c64, stats.bytesSent());
+    values.add(Oid(Oid(scalars, 6), 0), c64, stats.bytesReceived());
+    values.add(Oid(Oid(scalars, 7), 0), c64, stats.parseErrors());
+    values.add(Oid(Oid(scalars, 8), 0),
+               ColumnarTable::Gauge32, stats.sendQueueDepth());
+    values.add(Oid(Oid(scalars, 9), 0),
+               ColumnarTable::Gauge32, stats.receiveQueueDepth());
+    values.add(Oid(Oid(scalars, 10), 0), c64, stats.deadlineCutoffs());
+    values.add(Oid(Oid(scalars, 11), 0),
+               ColumnarTable::Gauge32, gauge(stats.timeToService()));
+
+    // PDU table
+    for(int t = PDU::agentxOpenPDU; t <= PDU::agentxResponsePDU; t++)
+    {
+        PDU::type_t type = static_cast<PDU::type_t>(t);
+        if(stats.pdusHandled(type) == 0)
+        {
+            continue;
+        }
+        Oid index;
+        index.push_back(t);
+        values.add(cell(myOid, 2, 1, index), ColumnarTable::Integer, t);
+        values.add(cell(myOid, 2, 2, index), c64, stats.pdusHandled(type));
+        values.add(cell(myOid, 2, 3, index), c64, stats.pduErrors(type));
+        add_histogram(values, myOid, 2, index, stats.pduLatency(type));
+    }
+
+    // Subtree table
+    QList<Oid> subtrees = stats.subtrees();
+    for(int s = 0; s < subtrees.size(); s++)
+    {
+        QSharedPointer<SubtreeStatistics> st = stats.subtree(subtrees[s]);
+        Oid index;
+        index.push_back(subtrees[s].size());
+        index += subtrees[s];
+        values.add(cell(myOid, 3, 2, index), c64, st->callbacks());
+        values.add(cell(myOid, 3, 3, index), c64, st->failures());
+        add_histogram(values, myOid, 3, index, st->latency());
+    }
+
+    // Slow callback table
+    QList<SlowCallback> slow = stats.slowCallbacks();
+    for(int s = 0; s < slow.size(); s++)
+    {
+        Oid index;
+        index.push_back(slow[s].name.size());
+        index += slow[s].name;
+        ColumnarTable::column_type_t g32 = ColumnarTable::Gauge32;
+        values.add(cell(myOid, 4, 2, index), c64, slow[s].count);
+        values.add(cell(myOid, 4, 3, index), g32, gauge(slow[s].maxLatency));
+        values.add(cell(myOid, 4, 4, index), g32, gauge(slow[s].lastLatency));
+    }
+}
+
+
+Varbind StatisticsHandler::get(const Oid& name)
+{
+    collect();
+    return values.get(name);
+}
+
+
+bool StatisticsHandler::next(const Oid& starting_oid,
+                             const Oid& ending_oid,
+                             Oid& name,
+                             QSharedPointer<AbstractVariable>& var)
+{
+    collect();
+    return values.next(starting_oid, ending_oid, name, var);
+}
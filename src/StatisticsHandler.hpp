@@ -0,0 +1,143 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#ifndef _STATISTICSHANDLER_HPP_
+#define _STATISTICSHANDLER_HPP_
+
+#include <QSharedPointer>
+
+#include "Oid.hpp"
+#include "AbstractVariable.hpp"
+#include "Varbind.hpp"
+#include "SubtreeHandler.hpp"
+#include "CompactVariables.hpp"
+#include "AgentStatistics.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \internal
+     *
+     * \brief Serves the AgentStatistics of a subagent as a MIB subtree.
+     *
+     * The handler is installed by MasterProxy::exportStatistics(). The
+     * subtree has the following layout (all counters are Counter64):
+     *
+     * - \<subtree\>.1: Scalars
+     *   - .1.0 connects
+     *   - .2.0 reconnects
+     *   - .3.0 pdusSent
+     *   - .4.0 pdusReceived
+     *   - .5.0 bytesSent
+     *   - .6.0 bytesReceived
+     *   - .7.0 parseErrors
+     *   - .8.0 sendQueueDepth (Gauge32)
+     *   - .9.0 receiveQueueDepth (Gauge32)
+     *   - .10.0 deadlineCutoffs
+     *   - .11.0 timeToService (Gauge32, microseconds)
+     * - \<subtree\>.2.1.\<column\>.\<pduType\>: One row per PDU type
+     *   which was handled at least once, indexed by the type code of RFC
+     *   2741, 6.1.
+     *   - column 1: pduType (Integer)
+     *   - column 2: handled
+     *   - column 3: errors
+     *   - column 4: latencySum (microseconds)
+     *   - column 10+i: latency bucket i (see LatencyHistogram)
+     * - \<subtree\>.3.1.\<column\>.\<subtreeIndex\>: One row per
+     *   registered subtree, indexed by the subtree's OID (encoded as OBJECT
+     *   IDENTIFIER index, i.e. preceded by its length).
+     *   - column 2: callbacks
+     *   - column 3: failures
+     *   - column 4: latencySum (microseconds)
+     *   - column 10+i: latency bucket i (see LatencyHistogram)
+     * - \<subtree\>.4.1.\<column\>.\<oidIndex\>: The slow callback log
+     *   (see AgentStatistics::slowCallbacks()), one row per OID, indexed
+     *   like the subtree table.
+     *   - column 2: count
+     *   - column 3: maxLatency (Gauge32, microseconds)
+     *   - column 4: lastLatency (Gauge32, microseconds)
+     *
+     * Collecting the values builds all cells, so they are cached for a 
+     * short time (see collect()). All varbinds of a walk within that time 
+     * see the same snapshot.
+     */
+    class StatisticsHandler : public SubtreeHandler
+    {
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * \param oid The subtree.
+             *
+             * \param statistics The statistics to serve. They must live
+             *                   longer than the handler.
+             *
+             * \exception None.
+             */
+            StatisticsHandler(const Oid& oid,
+                              const AgentStatistics& statistics);
+
+            /**
+             * \brief Serve a Get request.
+             *
+             * See SubtreeHandler::get().
+             */
+            virtual Varbind get(const Oid& name);
+
+            /**
+             * \brief Serve a GetNext request.
+             *
+             * See SubtreeHandler::next().
+             */
+            virtual bool next(const Oid& starting_oid,
+                              const Oid& ending_oid,
+                              Oid& name,
+                              QSharedPointer<AbstractVariable>& var);
+
+        private:
+            /**
+             * \brief The subtree.
+             */
+            Oid myOid;
+
+            /**
+             * \brief The statistics.
+             */
+            const AgentStatistics& stats;
+
+            /**
+             * \brief The values, collected by collect().
+             */
+            CompactVariables values;
+
+            /**
+             * \brief When the values were collected (see 
+             *        AgentStatistics::now()), or 0 if never.
+             */
+            quint64 collected;
+
+            /**
+             * \brief Collect the current values, unless the cached values 
+             *        are recent enough.
+             */
+            void collect();
+    };
+}
+
+#endif /* _STATISTICSHANDLER_HPP_ */
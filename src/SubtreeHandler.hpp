@@ -0,0 +1,124 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which
+ * consists of the GNU General Public License and some additional
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package
+ * for more details.
+ */
+
+#ifndef _SUBTREEHANDLER_H_
+#define _SUBTREEHANDLER_H_
+
+#include <QSharedPointer>
+
+#include "Oid.hpp"
+#include "Varbind.hpp"
+#include "AbstractVariable.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \brief Base class for objects serving a whole OID subtree.
+     *
+     * Normally, each variable is added to the MasterProxy using 
+     * MasterProxy::add_variable(), and the MasterProxy keeps track of every 
+     * single instance OID. This does not fit well to data sources whose 
+     * instances come and go all the time (e.g. an ARP cache), because the 
+     * variables would have to be added and removed constantly.
+     *
+     * A SubtreeHandler is added for a whole subtree instead, using 
+     * MasterProxy::add_subtree_handler(). The MasterProxy forwards each Get, 
+     * GetNext and GetBulk request which concerns the subtree to the handler, 
+     * which produces the values on demand. Variables added with 
+     * MasterProxy::add_variable() take precedence over a handler. If the 
+     * subtrees of several handlers are nested, the handler with the longest 
+     * matching OID is responsible for a given OID.
+     *
+     * The ColumnarTable class is an example of a SubtreeHandler.
+     *
+     * Set requests are not forwarded to subtree handlers; OID's served by a 
+     * handler are not writable.
+     */
+    class SubtreeHandler
+    {
+        public:
+
+            /**
+             * \brief Virtual destructor.
+             */
+            virtual ~SubtreeHandler()
+            {
+            }
+
+            /**
+             * \brief Serve a Get request.
+             *
+             * This method is called by the MasterProxy when a Get request is 
+             * received for an OID within the handler's subtree.
+             *
+             * \param name The requested OID.
+             *
+             * \return A varbind containing the name and the value. If the 
+             *         object does not exist, the varbind shall contain 
+             *         Varbind::noSuchObject or Varbind::noSuchInstance (see 
+             *         RFC 2741, 7.2.3.1 "Subagent Processing of the 
+             *         agentx-Get-PDU").
+             *
+             * \exception generic_error If obtaining the value fails. This 
+             *                          results in a genErr response. No 
+             *                          other exception shall be thrown.
+             */
+            virtual Varbind get(const Oid& name) = 0;
+
+            /**
+             * \brief Serve a GetNext request (or one repetition of a GetBulk
+             *        request).
+             *
+             * This method is called by the MasterProxy to find the object 
+             * following starting_oid within the handler's subtree. Objects 
+             * are ordered lexicographically by their OID.
+             *
+             * \param starting_oid The OID to start at. If 
+             *                     starting_oid.include() is true, the object 
+             *                     starting_oid itself is a candidate. 
+             *                     Otherwise, only objects following 
+             *                     starting_oid are considered. starting_oid 
+             *                     may lie outside the handler's subtree.
+             *
+             * \param ending_oid The object must precede ending_oid. A null 
+             *                   OID means "no upper bound". The MasterProxy 
+             *                   checks the bound itself, so a handler may 
+             *                   ignore it; it is provided to avoid needless 
+             *                   work.
+             *
+             * \param name Receives the object's OID if an object was found.
+             *
+             * \param var Receives the object's value if an object was found.
+             *            The MasterProxy calls handle_get() on it before 
+             *            serializing it.
+             *
+             * \return true if an object was found, false otherwise.
+             *
+             * \exception generic_error If obtaining the value fails. This 
+             *                          results in a genErr response. No 
+             *                          other exception shall be thrown.
+             */
+            virtual bool next(const Oid& starting_oid,
+                              const Oid& ending_oid,
+                              Oid& name,
+                              QSharedPointer<AbstractVariable>& var) = 0;
+    };
+}
+
+#endif /* _SUBTREEHANDLER_H_ */
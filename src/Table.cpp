@@ -17,32 +17,78 @@
  * for more details.
  */
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "Table.hpp"
+#include "exceptions.hpp"
 
 using namespace agentxcpp;
+using namespace std;
 
-bool Table::contains(QSharedPointer<TableEntry> entry) const
+
+/**
+ * \brief A row of a table: the index and the TableEntry.
+ */
+typedef pair< Oid, QSharedPointer<TableEntry> > row_t;
+
+/**
+ * \brief Compare two rows by their index.
+ */
+static bool lessByIndex(const row_t& a, const row_t& b)
 {
-    return entries.contains(entry);
+    return a.first < b.first;
 }
 
-bool Table::addEntry(QSharedPointer<TableEntry> entry)
+/**
+ * \brief Check whether two entries have the same columns and values.
+ *
+ * The values are compared in their serialized form.
+ */
+static bool sameValues(QSharedPointer<TableEntry> a,
+                       QSharedPointer<TableEntry> b)
 {
-    // Check for MasterProxy object
-    if(! myMasterProxy)
+    if(a->subid != b->subid)
     {
         return false;
     }
 
-    // Ensure that index is not registered
-    if(entries.contains(entry))
+    QMap< quint32, QSharedPointer<AbstractVariable> > va = a->variables();
+    QMap< quint32, QSharedPointer<AbstractVariable> > vb = b->variables();
+    if(va.size() != vb.size())
     {
-        // The entry was already added
         return false;
     }
+    QMapIterator< quint32, QSharedPointer<AbstractVariable> > i(va);
+    QMapIterator< quint32, QSharedPointer<AbstractVariable> > j(vb);
+    while(i.hasNext())
+    {
+        i.next();
+        j.next();
+        if(i.key() != j.key() || ! i.value() || ! j.value())
+        {
+            return false;
+        }
+        if(i.value()->serialize() != j.value()->serialize())
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
-    // Calculate entry's index
-    Oid entryIndex;
+
+bool Table::calculateIndex(QSharedPointer<TableEntry> entry, Oid& entryIndex)
+{
+    // Does the entry provide the index itself?
+    entryIndex = entry->index();
+    if(! entryIndex.empty())
+    {
+        return true;
+    }
+
+    // Calculate index from index variables
     QVector< QSharedPointer<AbstractVariable> > indexVariables = entry->indexVariables();
     QVectorIterator< QSharedPointer<AbstractVariable> > iter(indexVariables);
     while(iter.hasNext())
@@ -66,9 +112,52 @@ bool Table::addEntry(QSharedPointer<TableEntry> entry)
             entryIndex += variableIndex;
         }
     }
+    return true;
+}
+
+bool Table::contains(QSharedPointer<TableEntry> entry) const
+{
+    return entries.contains(entry);
+}
+
+QSharedPointer<TableEntry> Table::entry(const Oid& index) const
+{
+    return rows.value(index);
+}
+
+bool Table::addEntry(QSharedPointer<TableEntry> entry)
+{
+    // Check for MasterProxy object
+    if(! myMasterProxy)
+    {
+        return false;
+    }
+
+    // Ensure that index is not registered
+    if(entries.contains(entry))
+    {
+        // The entry was already added
+        return false;
+    }
+
+    // Calculate entry's index
+    Oid entryIndex;
+    if(! calculateIndex(entry, entryIndex))
+    {
+        // Index cannot be calculated
+        return false;
+    }
+
+    // Ensure that the index is unique
+    if(rows.contains(entryIndex))
+    {
+        // Another entry has the same index
+        return false;
+    }
 
     // Register entry
     entries[entry] = entryIndex;
+    rows.insert(entryIndex, entry);
 
     // Register all variables of the entry with the MasterProxy object
     QMap< quint32, QSharedPointer<AbstractVariable> > variables = entry->variables();
@@ -81,6 +170,7 @@ bool Table::addEntry(QSharedPointer<TableEntry> entry)
         {
             // No variable given -> fail
             entries.remove(entry);
+            rows.remove(entryIndex);
             return false;
         }
         // Add variable to list
@@ -122,8 +212,148 @@ bool Table::removeEntry(QSharedPointer<TableEntry> entry)
     myMasterProxy->removeVariables(toUnregister);
 
     // Remove entry from local storage
+    rows.remove(entryIndex);
     entries.remove(entry);
 
     // All went well, as far as we can tell.
     return true;
 }
+
+
+bool Table::sync(const QVector< QSharedPointer<TableEntry> >& snapshot,
+                 SyncResult* result)
+{
+    // Check for MasterProxy object
+    if(! myMasterProxy)
+    {
+        return false;
+    }
+
+    // The current rows, sorted by index
+    vector<row_t> current;
+    current.reserve(entries.size());
+    QMapIterator< QSharedPointer<TableEntry>, Oid > e(entries);
+    while(e.hasNext())
+    {
+        e.next();
+        current.push_back(row_t(e.value(), e.key()));
+    }
+    sort(current.begin(), current.end(), lessByIndex);
+
+    // The new rows, sorted by index. The index of each entry is calculated 
+    // only once.
+    vector<row_t> wanted;
+    wanted.reserve(snapshot.size());
+    for(int i = 0; i < snapshot.size(); i++)
+    {
+        Oid entryIndex;
+        if(! snapshot[i] || ! calculateIndex(snapshot[i], entryIndex))
+        {
+            // Invalid entry
+            return false;
+        }
+        wanted.push_back(row_t(entryIndex, snapshot[i]));
+    }
+    sort(wanted.begin(), wanted.end(), lessByIndex);
+    for(size_t i = 1; i < wanted.size(); i++)
+    {
+        if(wanted[i-1].first == wanted[i].first)
+        {
+            // Index is not unique
+            return false;
+        }
+    }
+
+    // Merge both lists and collect the changes
+    SyncResult counts;
+    QMap< QSharedPointer<TableEntry>, Oid > newEntries;
+    QHash< Oid, QSharedPointer<TableEntry> > newRows;
+    newRows.reserve(static_cast<int>(wanted.size()));
+    QVector<Oid> toUnregister;
+    QVector< QPair< Oid,QSharedPointer<AbstractVariable> > > toRegister;
+    vector<row_t>::const_iterator c = current.begin();
+    vector<row_t>::const_iterator w = wanted.begin();
+    while(c != current.end() || w != wanted.end())
+    {
+        const row_t* removed = 0;
+        const row_t* added = 0;
+        if(w == wanted.end() || (c != current.end() && c->first < w->first))
+        {
+            // Row vanished
+            removed = &*c++;
+            counts.removed++;
+        }
+        else if(c == current.end() || w->first < c->first)
+        {
+            // Row appeared
+            added = &*w++;
+            counts.added++;
+        }
+        else
+        {
+            // Row exists in both
+            if(c->second == w->second || sameValues(c->second, w->second))
+            {
+                // Unchanged: keep the current entry and its variables
+                newEntries.insert(c->second, c->first);
+                newRows.insert(c->first, c->second);
+            }
+            else
+            {
+                // Changed: replace the entry
+                removed = &*c;
+                added = &*w;
+                counts.changed++;
+            }
+            c++;
+            w++;
+        }
+
+        if(removed)
+        {
+            QMap< quint32, QSharedPointer<AbstractVariable> > variables = removed->second->variables();
+            QMapIterator< quint32, QSharedPointer<AbstractVariable> > iter(variables);
+            while(iter.hasNext())
+            {
+                iter.next();
+                toUnregister.append(myOid + removed->second->subid + iter.key() + removed->first);
+            }
+        }
+        if(added)
+        {
+            QMap< quint32, QSharedPointer<AbstractVariable> > variables = added->second->variables();
+            QMapIterator< quint32, QSharedPointer<AbstractVariable> > iter(variables);
+            while(iter.hasNext())
+            {
+                iter.next();
+                if(! iter.value())
+                {
+                    // No variable given -> fail
+                    return false;
+                }
+                toRegister.append(qMakePair(myOid + added->second->subid + iter.key() + added->first, iter.value()));
+            }
+            newEntries.insert(added->second, added->first);
+            newRows.insert(added->first, added->second);
+        }
+    }
+
+    // Apply all changes at once
+    try
+    {
+        myMasterProxy->updateVariables(myOid, toUnregister, toRegister);
+    }
+    catch(unknown_registration)
+    {
+        // Nothing was changed
+        return false;
+    }
+    entries = newEntries;
+    rows = newRows;
+
+    if(result)
+    {
+        *result = counts;
+    }
+    return true;
+}
@@ -21,6 +21,8 @@
 #define _TABLE_HPP_
 
 #include <QMap>
+#include <QHash>
+#include <QVector>
 #include <QSharedPointer>
 
 #include "Oid.hpp"
@@ -165,7 +167,9 @@ class Table
          *
          * This function fails in the following cases:
          * - no MasterProxy is currently associated with the table
-         * - the entry was already added.
+         * - the entry was already added
+         * - the entry's index cannot be calculated
+         * - another entry with the same index was already added.
          *
          * \param entry The TableEntry object to add.
          *
@@ -186,6 +190,29 @@ class Table
          */
         bool contains(QSharedPointer<TableEntry> entry) const;
 
+        /**
+         * \brief Find an entry by its index.
+         *
+         * The lookup uses a hash of the index, so it does not depend on the
+         * number of entries.
+         *
+         * \note The MasterProxy does not use this lookup: it serves Get 
+         *       requests for the table's cells from its own variable map, 
+         *       like for all other variables added with 
+         *       MasterProxy::addVariables(). Serving the rows through a 
+         *       SubtreeHandler instead would make them read-only, because 
+         *       Set requests are not forwarded to subtree handlers.
+         *
+         * \param index The index of the entry, as calculated when the entry
+         *              was added (see TableEntry::index() and \ref
+         *              how_tables_work).
+         *
+         * \return The entry, or a NULL pointer if no entry has this index.
+         *
+         * \exception None.
+         */
+        QSharedPointer<TableEntry> entry(const Oid& index) const;
+
         /**
          * \brief Remove an entry from the table.
          *
@@ -205,7 +232,92 @@ class Table
          */
         bool removeEntry(QSharedPointer<TableEntry> entry);
 
+        /**
+         * \brief The outcome of a sync() operation.
+         */
+        struct SyncResult
+        {
+            /**
+             * \brief Default constructor, sets all counts to 0.
+             */
+            SyncResult()
+            : added(0), removed(0), changed(0)
+            {
+            }
+
+            /**
+             * \brief Number of rows which were added.
+             */
+            int added;
+
+            /**
+             * \brief Number of rows which were removed.
+             */
+            int removed;
+
+            /**
+             * \brief Number of rows whose entry was replaced.
+             */
+            int changed;
+        };
+
+        /**
+         * \brief Replace the table's contents with a complete new set of
+         *        entries.
+         *
+         * This method is intended for mirroring an external table. It
+         * compares the given entries with the current ones (by their index)
+         * and applies only the differences:
+         * - Entries whose index is not present in the table are added.
+         * - Entries of the table whose index is not present in snapshot are
+         *   removed.
+         * - If an index is present in both, and the snapshot contains a
+         *   different TableEntry object with different values (compared
+         *   in serialized form), the table's entry is replaced. If the
+         *   values are equal, the table keeps its current entry object.
+         *
+         * An entry whose index changed since it was added is treated like
+         * a removed entry plus an added entry.
+         *
+         * The indexes of the entries are calculated once per call, and all
+         * variable changes are applied to the MasterProxy in a single
+         * batch using MasterProxy::updateVariables(). The cost is O(N log N)
+         * for N entries.
+         *
+         * This function fails (and leaves the table unchanged) in the
+         * following cases:
+         * - no MasterProxy is currently associated with the table
+         * - an entry's index cannot be calculated or an entry has a NULL
+         *   variable
+         * - two entries of the snapshot have the same index
+         * - the table's variables do not reside within a registered MIB
+         *   region.
+         *
+         * \param snapshot All entries which shall be contained in the
+         *                 table.
+         *
+         * \param result If not NULL, receives the number of added, removed
+         *               and changed rows on success.
+         *
+         * \return true on success, false otherwise.
+         *
+         * \exception None.
+         */
+        bool sync(const QVector< QSharedPointer<TableEntry> >& snapshot,
+                  SyncResult* result = 0);
+
     private:
+        /**
+         * \brief Calculate the index of an entry from its index variables.
+         *
+         * \param entry The entry.
+         *
+         * \param entryIndex Receives the index.
+         *
+         * \return false if the index cannot be calculated, true otherwise.
+         */
+        bool calculateIndex(QSharedPointer<TableEntry> entry, Oid& entryIndex);
+
         /**
          * \brief The managed TableEntry objects.
          *
@@ -215,6 +327,13 @@ class Table
          */
         QMap< QSharedPointer<TableEntry>, Oid > entries;
 
+        /**
+         * \brief The managed TableEntry objects, accessed by their index.
+         *
+         * This is the reverse of the entries member.
+         */
+        QHash< Oid, QSharedPointer<TableEntry> > rows;
+
         /**
          * \brief The used MasterProxy object.
          *
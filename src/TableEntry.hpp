@@ -57,6 +57,31 @@ namespace agentxcpp
              */
             virtual QVector< QSharedPointer<AbstractVariable> > indexVariables() = 0;
 
+            /**
+             * \brief Get the index of this entry.
+             *
+             * If this method returns a non-empty OID, the Table uses it as
+             * index of the entry and does not call indexVariables(). This
+             * allows to build the index with an \agentxcpp{Index} schema,
+             * which supports fixed-length and IMPLIED index objects:
+             * \code
+             * Oid index()
+             * {
+             *     return Index<Int32, ImpliedString>::encode(number, name);
+             * }
+             * \endcode
+             *
+             * The default implementation returns an empty OID.
+             *
+             * \return The index of the entry, or an empty OID.
+             *
+             * \exception This method shall not throw.
+             */
+            virtual Oid index()
+            {
+                return Oid();
+            }
+
             /**
              * \brief Get the variables of this entry.
              *
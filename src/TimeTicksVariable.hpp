@@ -21,7 +21,7 @@
 
 #include <QtGlobal>
 
-#include "AbstractVariable.hpp"
+#include "ScalarVariable.hpp"
 #include "exceptions.hpp"
 
 
@@ -30,170 +30,30 @@ namespace agentxcpp
     /**
      * \brief Represents a TimeTicks as described in RFC 2741
      */
-    class TimeTicksVariable : public AbstractVariable
+    class TimeTicksVariable : public ScalarVariable<TimeTicksVariable, quint32>
     {
-	protected:
-            /**
-	     * \brief The TimeTicks value.
-	     *
-	     * According to RFC 2578, TimeTicks is a non-negative 32-bit
-	     * number.
-	     */
-	    quint32 v;
-
-	private:
+        public:
 
             /**
-             * \copydoc agentxcpp::IntegerVariable::new_value
-             */
-            QSharedPointer<TimeTicksVariable> new_value;
-
-	public:
-
-	    /**
-	     * \brief (Default) constructor.
-             *
-	     * \param initial_value The initial value of the object.
-	     */
-	    TimeTicksVariable(quint32 initial_value = 0)
-	    : v(initial_value)
-	    {
-	    }
-
-            /**
-             * \internal
-             *
-             * \copydoc agentxcpp::IntegerVariable::IntegerVariable(binary::const_iterator&, const binary::const_iterator&, bool)
+             * \brief (Default) constructor.
              *
+             * \param initial_value The initial value of the object.
              */
-            TimeTicksVariable(binary::const_iterator& pos,
-		      const binary::const_iterator& end,
-		      bool big_endian=true);
-	    
-	    /**
-	     * \internal
-	     *
-	     * \brief Encode the object as described in RFC 2741, section 5.4
-	     *
-	     * This function uses big endian.
-	     */
-	    virtual binary serialize() const;
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::setValue()
-             */
-            void setValue(quint32 _value)
-            {
-	        v = _value;
-	    }
-
-            /**
-             * \brief Get the current value.
-             *
-             * \return The value.
-             */
-            quint32 value()
-            {
-                return v;
-	    }
-
-            /**
-             * \internal
-             *
-             * \copydoc agentxcpp::IntegerVariable::handle_get()
-             */
-            virtual void handle_get()
-            {
-                perform_get();
-            }
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::perform_get()
-             */
-            virtual void perform_get()
+            TimeTicksVariable(quint32 initial_value = 0)
+            : ScalarVariable<TimeTicksVariable, quint32>(initial_value)
             {
             }
 
             /**
              * \internal
              *
-             * \copydoc agentxcpp::IntegerVariable::handle_testset()
+             * \copydoc agentxcpp::ScalarVariable::ScalarVariable(binary::const_iterator&, const binary::const_iterator&, bool)
              */
-            virtual testset_result_t handle_testset(QSharedPointer<AbstractVariable> _v)
-            {
-                new_value = qSharedPointerDynamicCast<TimeTicksVariable>(_v);
-                if (new_value)
-                {
-                    // Type matches variable
-                    return perform_testset(new_value->value());
-                }
-                else
-                {
-                    // Wrong type
-                    return wrongType;
-                }
-
-            }
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::perform_testset()
-             */
-            virtual testset_result_t perform_testset(quint32 _v)
-            {
-                return noAccess;
-            }
-
-            /**
-             * \internal
-             *
-             * \copydoc agentxcpp::IntegerVariable::handle_cleanupset()
-             */
-            virtual void handle_cleanupset()
-            {
-                perform_cleanupset(new_value->value());
-            }
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::perform_cleanupset()
-             */
-            virtual void perform_cleanupset(quint32 _v)
-            {
-                return;
-            }
-
-            /**
-             * \internal
-             *
-             * \copydoc agentxcpp::IntegerVariable::handle_commitset()
-             */
-            virtual bool handle_commitset()
-            {
-                return perform_commitset(new_value->value());
-            }
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::perform_commitset()
-             */ virtual bool perform_commitset(quint32 _v)
-            {
-                return false;
-            }
-
-            /**
-             * \internal
-             *
-             * \copydoc agentxcpp::IntegerVariable::handle_undoset()
-             */
-            virtual bool handle_undoset()
-            {
-                return perform_undoset(new_value->value());
-            }
-
-            /**
-             * \copydoc agentxcpp::IntegerVariable::perform_undoset()
-             */
-            virtual bool perform_undoset(quint32 _v)
+            TimeTicksVariable(binary::const_iterator& pos,
+                              const binary::const_iterator& end,
+                              bool big_endian=true)
+            : ScalarVariable<TimeTicksVariable, quint32>(pos, end, big_endian)
             {
-                return false;
             }
 
 	    /**
@@ -215,7 +75,6 @@ namespace agentxcpp
 	        oid.push_back(v);
 	        return oid;
             }
-
     };
 }
 
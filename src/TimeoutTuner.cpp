@@ -0,0 +1,92 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#include "TimeoutTuner.hpp"
+
+using namespace agentxcpp;
+
+
+TimeoutTuner::TimeoutTuner()
+{
+    for(int i = 0; i < LatencyHistogram::bucket_count; i++)
+    {
+        baseline[i] = 0;
+    }
+}
+
+
+quint8 TimeoutTuner::update(const LatencyHistogram& histogram, quint8 current)
+{
+    // The latencies of the window, per bucket
+    quint64 window[LatencyHistogram::bucket_count];
+    quint64 total = 0;
+    for(int i = 0; i < LatencyHistogram::bucket_count; i++)
+    {
+        window[i] = histogram.bucket(i) - baseline[i];
+        total += window[i];
+    }
+    if(total < min_samples)
+    {
+        // Too few latencies: wait for more
+        return 0;
+    }
+    for(int i = 0; i < LatencyHistogram::bucket_count; i++)
+    {
+        baseline[i] += window[i];
+    }
+
+    // Find the bucket containing the 99th percentile
+    quint64 rank = total - total / 100;
+    quint64 seen = 0;
+    int bucket = 0;
+    while(bucket < LatencyHistogram::bucket_count - 1)
+    {
+        seen += window[bucket];
+        if(seen >= rank)
+        {
+            break;
+        }
+        bucket++;
+    }
+
+    // Propose twice the upper bound of the bucket (bucket i holds
+    // latencies below 2^i microseconds). The last bucket is unbounded.
+    quint32 proposal = 255;
+    if(bucket < LatencyHistogram::bucket_count - 1)
+    {
+        quint64 limit = quint64(2) << bucket;
+        proposal = (limit + 999999) / 1000000;
+        if(proposal < 1)
+        {
+            proposal = 1;
+        }
+        if(proposal > 255)
+        {
+            proposal = 255;
+        }
+    }
+
+    // Raise at once, lower with hysteresis
+    if(proposal > current || proposal * 2 <= current)
+    {
+        return static_cast<quint8>(proposal);
+    }
+    return 0;
+}
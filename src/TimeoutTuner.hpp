@@ -0,0 +1,84 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#ifndef _TIMEOUTTUNER_HPP_
+#define _TIMEOUTTUNER_HPP_
+
+#include <QtGlobal>
+
+#include "AgentStatistics.hpp"
+
+namespace agentxcpp
+{
+    /**
+     * \internal
+     *
+     * \brief Derives the timeout of a registration from the measured
+     *        callback latencies.
+     *
+     * The tuner is used by MasterProxy::setAdaptiveTimeouts(). Each time
+     * update() is called, it computes the 99th percentile of the latencies
+     * recorded since the previous call and proposes a timeout of twice that
+     * percentile (rounded up to whole seconds, at least 1 second). To avoid
+     * re-registering back and forth, the timeout is raised as soon as the
+     * proposal exceeds it, but lowered only if the proposal is at most half
+     * of it. Windows with less than min_samples latencies are not
+     * evaluated; their latencies are carried over to the next window.
+     */
+    class TimeoutTuner
+    {
+        public:
+            /**
+             * \brief The minimum number of latencies in a window.
+             */
+            static const quint64 min_samples = 50;
+
+            /**
+             * \brief Constructor.
+             *
+             * \exception None.
+             */
+            TimeoutTuner();
+
+            /**
+             * \brief Evaluate the latencies recorded since the last call.
+             *
+             * \param histogram The latencies of the registration's callbacks.
+             *                  The same histogram must be given on each call.
+             *
+             * \param current The timeout currently in effect, in seconds.
+             *
+             * \return The new timeout in seconds, or 0 if the timeout should
+             *         stay unchanged.
+             *
+             * \exception None.
+             */
+            quint8 update(const LatencyHistogram& histogram, quint8 current);
+
+        private:
+            /**
+             * \brief The bucket counts at the end of the last evaluated
+             *        window.
+             */
+            quint64 baseline[LatencyHistogram::bucket_count];
+    };
+}
+
+#endif /* _TIMEOUTTUNER_HPP_ */
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#include "Trace.hpp"
+#include "GetPDU.hpp"
+#include "GetNextPDU.hpp"
+#include "GetBulkPDU.hpp"
+#include "TestSetPDU.hpp"
+#include "ResponsePDU.hpp"
+#include "NotifyPDU.hpp"
+#include "IndexAllocatePDU.hpp"
+#include "IndexDeallocatePDU.hpp"
+
+using namespace agentxcpp;
+
+
+trace_hook_t agentxcpp::trace_hook = 0;
+
+
+#ifdef AGENTXCPP_TRACE_USDT
+/*
+ * The probe semaphores (see AGENTXCPP_TRACE). They live in the ".probes"
+ * section, where tracers expect them.
+ */
+#define AGENTXCPP_SEMAPHORE(stage) \
+    volatile unsigned short agentxcpp_##stage##_semaphore \
+        __attribute__((section(".probes"))) = 0
+AGENTXCPP_SEMAPHORE(receive);
+AGENTXCPP_SEMAPHORE(parsed);
+AGENTXCPP_SEMAPHORE(dispatch_begin);
+AGENTXCPP_SEMAPHORE(callback_begin);
+AGENTXCPP_SEMAPHORE(callback_end);
+AGENTXCPP_SEMAPHORE(dispatch_end);
+AGENTXCPP_SEMAPHORE(serialized);
+AGENTXCPP_SEMAPHORE(written);
+#undef AGENTXCPP_SEMAPHORE
+#endif
+
+
+void agentxcpp::setTraceHook(trace_hook_t hook)
+{
+    __atomic_store_n(&trace_hook, hook, __ATOMIC_RELEASE);
+}
+
+
+quint32 agentxcpp::trace_varbind_count(PDU& pdu)
+{
+    PDU* p = &pdu;
+    if(GetPDU* get = dynamic_cast<GetPDU*>(p))
+        return get->get_sr().size();
+    if(GetNextPDU* getnext = dynamic_cast<GetNextPDU*>(p))
+        return getnext->get_sr().size();
+    if(GetBulkPDU* getbulk = dynamic_cast<GetBulkPDU*>(p))
+        return getbulk->get_sr().size();
+    if(TestSetPDU* testset = dynamic_cast<TestSetPDU*>(p))
+        return testset->get_vb().size();
+    if(ResponsePDU* response = dynamic_cast<ResponsePDU*>(p))
+        return response->varbindlist.size();
+    if(NotifyPDU* notify = dynamic_cast<NotifyPDU*>(p))
+        return notify->get_vb().size();
+    if(IndexAllocatePDU* allocate = dynamic_cast<IndexAllocatePDU*>(p))
+        return allocate->get_vb().size();
+    if(IndexDeallocatePDU* deallocate = dynamic_cast<IndexDeallocatePDU*>(p))
+        return deallocate->get_vb().size();
+    return 0;
+}
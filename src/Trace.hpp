@@ -0,0 +1,185 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+
+#ifndef _TRACE_HPP_
+#define _TRACE_HPP_
+
+#include <QtGlobal>
+
+namespace agentxcpp
+{
+    class PDU;
+
+    /**
+     * \brief The stages of the PDU lifecycle at which tracepoints are
+     *        placed.
+     *
+     * The stages are passed in the order in which a request from the master
+     * agent passes them:
+     *
+     * - trace_receive: readyRead() was signalled. The varbind count is the
+     *   number of bytes available on the socket; the other values are 0.
+     * - trace_parsed: A PDU was parsed by PDU::parse_pdu().
+     * - trace_dispatch_begin: The MasterProxy starts to handle the PDU.
+     * - trace_callback_begin, trace_callback_end: A variable callback (or a
+     *   SubtreeHandler) is invoked for a varbind. The varbind count is the
+     *   1-based index of the varbind within the request.
+     * - trace_dispatch_end: The MasterProxy finished handling the PDU and
+     *   hands the response (if any) to the connector. The varbind count is
+     *   the count of the response, or 0 if no response is sent.
+     * - trace_serialized: A PDU was serialized for sending.
+     * - trace_written: A serialized PDU was written to the socket (or
+     *   handed over to the socket's write buffer).
+     *
+     * PDU's sent by the subagent itself (e.g. RegisterPDU's) only pass the
+     * trace_serialized and trace_written stages.
+     */
+    enum trace_stage_t
+    {
+        trace_receive,
+        trace_parsed,
+        trace_dispatch_begin,
+        trace_callback_begin,
+        trace_callback_end,
+        trace_dispatch_end,
+        trace_serialized,
+        trace_written
+    };
+
+    /**
+     * \brief A function which is called at each tracepoint.
+     *
+     * \param stage The stage of the tracepoint.
+     *
+     * \param packetID The packetID of the PDU.
+     *
+     * \param transactionID The transactionID of the PDU.
+     *
+     * \param type The PDU type (see RFC 2741, 6.1. "AgentX PDU Header").
+     *
+     * \param varbinds The number of varbinds (or searchRanges) of the PDU.
+     *                 Some stages use this value differently, see
+     *                 trace_stage_t.
+     *
+     * The function is invoked from the thread which passes the tracepoint,
+     * which is either the connector's thread or the thread running the
+     * MasterProxy. It must be thread-safe and should return quickly.
+     */
+    typedef void (*trace_hook_t)(trace_stage_t stage,
+                                 quint32 packetID,
+                                 quint32 transactionID,
+                                 quint8 type,
+                                 quint32 varbinds);
+
+    /**
+     * \brief Install a trace hook.
+     *
+     * The hook is only invoked if the library was built with the tracing
+     * hooks enabled (<tt>scons --with-tracing=hooks</tt>). Otherwise the
+     * tracepoints are compiled out and the hook is never called.
+     *
+     * \param hook The new hook, or 0 to remove the current hook.
+     *
+     * \exception None.
+     */
+    void setTraceHook(trace_hook_t hook);
+
+    /**
+     * \internal
+     *
+     * \brief The currently installed trace hook (or 0).
+     */
+    extern trace_hook_t trace_hook;
+
+    /**
+     * \internal
+     *
+     * \brief Get the number of varbinds (or searchRanges) of a PDU.
+     *
+     * \return The count, or 0 for PDU types without varbinds.
+     *
+     * \exception None.
+     */
+    quint32 trace_varbind_count(PDU& pdu);
+}
+
+
+/**
+ * \internal
+ *
+ * \brief Place a tracepoint.
+ *
+ * The tracepoint is selected at build time:
+ *
+ * - With AGENTXCPP_TRACE_USDT defined, it is a SystemTap/USDT static probe
+ *   named "agentxcpp:<stage>" with the four values as arguments. Each probe
+ *   has a semaphore, which a tracer (e.g. bpftrace, SystemTap or perf)
+ *   increments while it is attached. The arguments are only evaluated if
+ *   the semaphore is set.
+ * - With AGENTXCPP_TRACE_HOOKS defined, it calls the hook installed with
+ *   setTraceHook(). The arguments are only evaluated if a hook is
+ *   installed.
+ * - Otherwise it expands to nothing; the arguments are not evaluated.
+ *
+ * \param stage The stage without the "trace_" prefix, e.g. parsed.
+ */
+#if defined(AGENTXCPP_TRACE_USDT)
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+/*
+ * The probe semaphores (defined in Trace.cpp). sys/sdt.h refers to them by
+ * their unmangled name "<provider>_<name>_semaphore", so they are declared
+ * outside of the namespace.
+ */
+extern volatile unsigned short agentxcpp_receive_semaphore;
+extern volatile unsigned short agentxcpp_parsed_semaphore;
+extern volatile unsigned short agentxcpp_dispatch_begin_semaphore;
+extern volatile unsigned short agentxcpp_callback_begin_semaphore;
+extern volatile unsigned short agentxcpp_callback_end_semaphore;
+extern volatile unsigned short agentxcpp_dispatch_end_semaphore;
+extern volatile unsigned short agentxcpp_serialized_semaphore;
+extern volatile unsigned short agentxcpp_written_semaphore;
+#define AGENTXCPP_TRACE(stage, packetID, transactionID, type, varbinds) \
+    do \
+    { \
+        if(__builtin_expect(agentxcpp_##stage##_semaphore != 0, 0)) \
+        { \
+            DTRACE_PROBE4(agentxcpp, stage, packetID, transactionID, \
+                          type, varbinds); \
+        } \
+    } while(0)
+#elif defined(AGENTXCPP_TRACE_HOOKS)
+#define AGENTXCPP_TRACE(stage, packetID, transactionID, type, varbinds) \
+    do \
+    { \
+        agentxcpp::trace_hook_t trace_hook_ = \
+            __atomic_load_n(&agentxcpp::trace_hook, __ATOMIC_ACQUIRE); \
+        if(__builtin_expect(trace_hook_ != 0, 0)) \
+        { \
+            trace_hook_(agentxcpp::trace_##stage, packetID, transactionID, \
+                        type, varbinds); \
+        } \
+    } while(0)
+#else
+#define AGENTXCPP_TRACE(stage, packetID, transactionID, type, varbinds) \
+    do { } while(0)
+#endif
+
+#endif /* _TRACE_HPP_ */
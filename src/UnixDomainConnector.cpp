@@ -26,6 +26,8 @@
 #include <QScopedArrayPointer>
 
 #include "util.hpp"
+#include "PingPDU.hpp"
+#include "Trace.hpp"
 
 using namespace agentxcpp;
 using namespace std;
@@ -34,17 +36,31 @@ using namespace std;
 UnixDomainConnector::UnixDomainConnector(
         const std::string& _unix_domain_socket,
         unsigned _timeout)
-: QObject(),
+: Connector(_timeout),
   m_socket(this),
   m_filename(QString::fromStdString(_unix_domain_socket)),
-  m_timeout(_timeout),
-  m_is_connected(false)
+  m_is_connected(false),
+  m_keepalive_timer(this),
+  m_keepalive_interval(0),
+  m_keepalive_timeout(0),
+  m_keepalive_session(0),
+  m_ping_outstanding(false),
+  m_reconnect_timer(this),
+  m_auto_reconnect(false),
+  m_backoff_min(1000),
+  m_backoff_max(60000),
+  m_backoff(1000)
 {
-    // We want to deliver this types within a signal:
-    qRegisterMetaType< QSharedPointer<PDU> >("QSharedPointer<PDU>");
-    qRegisterMetaType< QSharedPointer<PDU> >("QSharedPointer<PDU>");
-
     QObject::connect(&m_socket, SIGNAL(readyRead()), this, SLOT(do_receive()));
+    QObject::connect(&m_socket, SIGNAL(disconnected()),
+                     this, SLOT(do_connection_lost()));
+
+    m_keepalive_timer.setSingleShot(true);
+    QObject::connect(&m_keepalive_timer, SIGNAL(timeout()),
+                     this, SLOT(do_keepalive()));
+    m_reconnect_timer.setSingleShot(true);
+    QObject::connect(&m_reconnect_timer, SIGNAL(timeout()),
+                     this, SLOT(do_reconnect()));
 }
 
 
@@ -108,6 +124,15 @@ bool UnixDomainConnector::connect()
 
 void UnixDomainConnector::do_disconnect()
 {
+    // Update the connection state first, so that do_connection_lost()
+    // ignores the disconnection
+    {
+        QMutexLocker locker(&m_mutex_is_connected);
+        m_is_connected = false;
+    }
+    m_keepalive_timer.stop();
+    m_reconnect_timer.stop();
+
     // Disconnect
     m_socket.disconnectFromServer();
     if(!m_socket.waitForDisconnected(m_timeout))
@@ -157,6 +182,16 @@ void UnixDomainConnector::do_receive()
     // more data arrived:
     static binary last_header;
 
+    AGENTXCPP_TRACE(receive, 0, 0, 0, m_socket.bytesAvailable());
+
+    // The master agent is alive: the next PingPDU is due after the keepalive
+    // interval
+    if(m_keepalive_interval != 0)
+    {
+        m_ping_outstanding = false;
+        m_keepalive_timer.start(m_keepalive_interval);
+    }
+
     // Read all PDUs into distinct buffers
     std::list<binary> queue;
     do
@@ -210,103 +245,272 @@ void UnixDomainConnector::do_receive()
             last_header = buf;
             break;
         }
-        QScopedArrayPointer<char> payload(new char[payload_length]);
-        qint64 bytes_read = m_socket.read(payload.data(), payload_length);
+        // (read the payload directly behind the header)
+        buf.resize(20 + payload_length);
+        qint64 bytes_read = 0;
+        if(payload_length > 0)
+        {
+            bytes_read = m_socket.read(
+                    reinterpret_cast<char*>(&buf[20]), payload_length);
+        }
         if(bytes_read != payload_length)
         {
             disconnect();
             return;
         }
-        buf.append(reinterpret_cast<quint8*>(payload.data()), payload_length);
 
-        queue.push_back(buf);
+        if(m_stats)
+        {
+            m_stats->record_received(buf.size());
+        }
+        queue.push_back(binary());
+        queue.back().swap(buf);
     }
     while(m_socket.bytesAvailable() >= 20); // still enough data for next header
 
     // Process all received PDU's
     for(list<binary>::const_iterator i = queue.begin(); i != queue.end(); i++)
     {
-        // Parse PDU
-        QSharedPointer<PDU> pdu;
-        try
-        {
-            pdu = PDU::parse_pdu(*i);
-        }
-        catch(version_error)
+        if( ! dispatch(*i) )
         {
             return;
         }
-        catch(parse_error)
+    }
+}
+
+
+void UnixDomainConnector::do_send(QSharedPointer<PDU> pdu)
+{
+    // The buffer is reused for each PDU (see m_send_buffer)
+    SegmentedBuffer& data = m_send_buffer;
+    pdu->serialize_to(data);
+    if(m_stats)
+    {
+        m_stats->add_send_queue(-1);
+        m_stats->record_sent(data.size());
+    }
+    AGENTXCPP_TRACE(serialized, pdu->get_packetID(), pdu->get_transactionID(),
+                    data.segment(0).data[1], trace_varbind_count(*pdu));
+
+    // Position of the first byte not yet written
+    int segment = 0;
+    int offset = 0;
+
+    // Write the segments directly to the socket, without copying them into
+    // the write buffer of m_socket. This is only done while that buffer is
+    // empty; otherwise the data would overtake the buffered data.
+    if(m_socket.state() == QLocalSocket::ConnectedState
+       && m_socket.bytesToWrite() == 0)
+    {
+        write_segments(static_cast<int>(m_socket.socketDescriptor()),
+                       data, segment, offset);
+    }
+
+    // Hand the rest over to m_socket, which buffers it until the socket is
+    // writable
+    for(; segment < data.count(); segment++)
+    {
+        const SegmentedBuffer::Segment& s = data.segment(segment);
+        m_socket.write(s.data + offset, s.size - offset);
+        offset = 0;
+    }
+    AGENTXCPP_TRACE(written, pdu->get_packetID(), pdu->get_transactionID(),
+                    data.segment(0).data[1], trace_varbind_count(*pdu));
+
+    // The PDU is sent (or copied by m_socket): release the memory for the
+    // next PDU
+    data.clear();
+}
+
+
+void UnixDomainConnector::send(QSharedPointer<PDU> pdu)
+{
+    // Start do_send()
+    if(m_stats) m_stats->add_send_queue(1);
+    QMetaObject::invokeMethod(this, "do_send", Q_ARG(QSharedPointer<PDU>, pdu));
+}
+
+
+void UnixDomainConnector::startKeepalive(quint32 sessionID,
+                                         unsigned interval, unsigned timeout)
+{
+    // Start do_set_keepalive()
+    QMetaObject::invokeMethod(this, "do_set_keepalive",
+                              Q_ARG(uint, sessionID),
+                              Q_ARG(uint, interval),
+                              Q_ARG(uint, timeout));
+}
+
+
+void UnixDomainConnector::stopKeepalive()
+{
+    // Start do_set_keepalive()
+    QMetaObject::invokeMethod(this, "do_set_keepalive",
+                              Q_ARG(uint, 0),
+                              Q_ARG(uint, 0),
+                              Q_ARG(uint, 0));
+}
+
+
+void UnixDomainConnector::do_set_keepalive(uint sessionID,
+                                           uint interval, uint timeout)
+{
+    m_keepalive_session = sessionID;
+    m_keepalive_interval = interval;
+    m_keepalive_timeout = timeout;
+    m_ping_outstanding = false;
+    if(interval != 0 && is_connected())
+    {
+        m_keepalive_timer.start(interval);
+    }
+    else
+    {
+        m_keepalive_timer.stop();
+    }
+}
+
+
+void UnixDomainConnector::do_keepalive()
+{
+    if(m_ping_outstanding)
+    {
+        // Nothing received since the last PingPDU was sent
+        do_connection_lost();
+        return;
+    }
+
+    // Send PingPDU and wait for the answer
+    QSharedPointer<PingPDU> ping(new PingPDU);
+    ping->set_sessionID(m_keepalive_session);
+    if(m_stats) m_stats->add_send_queue(1);
+    do_send(ping);
+    m_ping_outstanding = true;
+    m_keepalive_timer.start(m_keepalive_timeout);
+}
+
+
+void UnixDomainConnector::do_connection_lost()
+{
+    {
+        QMutexLocker locker(&m_mutex_is_connected);
+        if(! m_is_connected)
         {
+            // Deliberate disconnect, or loss already handled
             return;
         }
+        m_is_connected = false;
+    }
 
-        // Special case: ResponsePDU's
-        QSharedPointer<ResponsePDU> response;
-        response = qSharedPointerDynamicCast<ResponsePDU>(pdu);
-        if(response)
-        {
-            m_response_mutex.lock();
-            // Was a response
-            std::map< quint32, QSharedPointer<ResponsePDU> >::iterator i;
-            i = this->m_responses.find( response->get_packetID() );
-            if(i != this->m_responses.end())
-            {
-                // Someone is waiting for this response
-                i->second = response;
-                m_response_mutex.unlock();
-                m_response_arrived.wakeAll();
-            }
-            else
-            {
-                // Nobody was waiting for the response
-                // -> ignore it
-                m_response_mutex.unlock();
-            }
-        }
-        else
-        {
-            // Was not a Response
-            // -> emit signal
-            emit pduArrived(pdu);
-        }
+    // Close the socket (this emits disconnected() again, which is ignored)
+    m_keepalive_timer.stop();
+    m_ping_outstanding = false;
+    m_socket.abort();
+
+    // Wake threads waiting for responses. They notice that the connection
+    // is lost.
+    wake_waiters();
+
+    emit connectionLost();
+
+    if(m_auto_reconnect)
+    {
+        m_backoff = m_backoff_min;
+        m_reconnect_timer.start(m_backoff);
     }
 }
 
-QSharedPointer<ResponsePDU> UnixDomainConnector::request(QSharedPointer<PDU> pdu)
+
+void UnixDomainConnector::setAutoReconnect(bool enabled,
+                                           unsigned min_delay,
+                                           unsigned max_delay)
 {
-    m_response_mutex.lock();
-    m_responses[pdu->get_packetID()] = QSharedPointer<ResponsePDU>();
-    QMetaObject::invokeMethod(this, "do_send", Q_ARG(QSharedPointer<PDU>, pdu));
+    // Start do_set_auto_reconnect()
+    QMetaObject::invokeMethod(this, "do_set_auto_reconnect",
+                              Q_ARG(bool, enabled),
+                              Q_ARG(uint, min_delay),
+                              Q_ARG(uint, max_delay));
+}
 
-    std::map<quint32, QSharedPointer<ResponsePDU> >::iterator i;
-    m_responses[pdu->get_packetID()] = QSharedPointer<ResponsePDU>();
-    do
+
+void UnixDomainConnector::do_set_auto_reconnect(bool enabled,
+                                                uint min_delay,
+                                                uint max_delay)
+{
+    m_auto_reconnect = enabled;
+    m_backoff_min = (min_delay == 0) ? 1 : min_delay;
+    m_backoff_max = (max_delay < m_backoff_min) ? m_backoff_min : max_delay;
+    if(! enabled)
     {
-        m_response_arrived.wait(&m_response_mutex);
+        m_reconnect_timer.stop();
     }
-    while ( ! (m_responses[pdu->get_packetID()]) );
+}
 
-    QSharedPointer<ResponsePDU> response = m_responses[pdu->get_packetID()];
-    m_responses.erase(m_responses.find(pdu->get_packetID()));
-    m_response_mutex.unlock();
 
-    return response;
+void UnixDomainConnector::setByteOrder(bool big_endian)
+{
+    // Start do_set_byte_order()
+    QMetaObject::invokeMethod(this, "do_set_byte_order",
+                              Q_ARG(bool, big_endian));
 }
 
 
+void UnixDomainConnector::do_set_byte_order(bool big_endian)
+{
+    // Kept by m_send_buffer.clear()
+    m_send_buffer.setBigEndian(big_endian);
+}
 
-void UnixDomainConnector::do_send(QSharedPointer<PDU> pdu)
+
+void UnixDomainConnector::schedule_reconnect()
+{
+    if(! m_auto_reconnect)
+    {
+        return;
+    }
+    m_backoff = (m_backoff > m_backoff_max / 2) ? m_backoff_max
+                                                 : m_backoff * 2;
+    m_reconnect_timer.start(m_backoff);
+}
+
+
+void UnixDomainConnector::do_reconnect()
 {
-    binary data = pdu->serialize();
+    if(! m_auto_reconnect || is_connected())
+    {
+        return;
+    }
+
+    // Try to connect (blocks this thread only)
+    m_socket.abort();
+    m_socket.connectToServer(m_filename);
+    if(m_socket.waitForConnected(m_timeout))
+    {
+        {
+            QMutexLocker locker(&m_mutex_is_connected);
+            m_is_connected = true;
+        }
+        emit reconnected();
+        return;
+    }
 
-    m_socket.write(reinterpret_cast<const char*>(data.c_str()),
-            data.size());
+    schedule_reconnect();
 }
 
 
-void UnixDomainConnector::send(QSharedPointer<PDU> pdu)
+void UnixDomainConnector::reconnectFailed()
 {
-    // Start do_disconnect()
-    QMetaObject::invokeMethod(this, "do_send", Q_ARG(QSharedPointer<PDU>, pdu));
+    // Start do_reconnect_failed()
+    QMetaObject::invokeMethod(this, "do_reconnect_failed");
+}
+
+
+void UnixDomainConnector::do_reconnect_failed()
+{
+    {
+        QMutexLocker locker(&m_mutex_is_connected);
+        m_is_connected = false;
+    }
+    m_keepalive_timer.stop();
+    m_socket.abort();
+    schedule_reconnect();
 }
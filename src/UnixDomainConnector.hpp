@@ -28,9 +28,10 @@
 #include <QWaitCondition>
 #include <QMutex>
 #include <QString>
+#include <QList>
+#include <QTimer>
 
-#include "PDU.hpp"
-#include "ResponsePDU.hpp"
+#include "Connector.hpp"
 
 
 namespace agentxcpp
@@ -38,17 +39,9 @@ namespace agentxcpp
     /**
      * \internal
      *
-     * \brief Connect to a unix domain socket.
+     * \brief Connect to a unix domain socket using Qt.
      *
-     * This class connects to a unix domain socket and provides the following 
-     * services:
-     * - Methods to connect and disconnect to the unix domain socket, and
-     *   a method to obtain the current state,
-     * - A QT signal which is emitted when a PDU arrives (with an exception, 
-     *   see below),
-     * - A request service which sends a PDU and then blocks until the 
-     *   corresponding ResponsePDU arrived,
-     * - A send service which just sends a PDU.
+     * This class implements the Connector interface with a QLocalSocket.
      *
      * An object of this class is intended to run in its own thread, like so:
      * \code
@@ -96,22 +89,12 @@ namespace agentxcpp
      * separately. Sending is done using the do_send() slot, which works for 
      * all types of PDU: all request-PDU's (such as OpenPDU) can be send 
      * without considering special cases, and ResponsePDU's also are no 
-     * exception. Received PDU's are forwarded using the pduArrived() signal to 
-     * whoever is listening, which works for PDU's \e except ResponsePDU's: 
-     * these are the answer to a sent request-PDU and must be routed 
-     * differently.
-     *
-     * Received ResponsePDU's are transmitted via the m_responses map. This map 
-     * assigns a packetID a ResponsePDU. Each time a request is sent, do_send() 
-     * adds an entry to the map with the packetID of the request and a NULL 
-     * ResponsePDU (i.e. a NULL pointer). This entry indicates that a 
-     * ResponsePDU with the same packetID is awaited. The do_receive() slot 
-     * then adds the ResponsePDU to the map, when it arrived. However, when a 
-     * ResponsePDU arrives which is \e not awaited, it is discarded.
+     * exception. Received PDU's are passed to Connector::dispatch() by the 
+     * do_receive() slot.
      * 
      * \todo Improve error handling in all functions.
      */
-    class UnixDomainConnector  : public QObject
+    class UnixDomainConnector  : public Connector
     {
         Q_OBJECT
 
@@ -122,16 +105,19 @@ namespace agentxcpp
              */
 	    QLocalSocket m_socket;
 
+            /**
+             * \brief The buffer into which do_send() serializes the PDU's.
+             *
+             * It is cleared after each PDU, but keeps its memory, so that
+             * sending a PDU usually doesn't allocate heap memory.
+             */
+            SegmentedBuffer m_send_buffer;
+
             /**
              * \brief The filename of the unix domain socket.
              */
 	    QString m_filename;
 
-	    /**
-	     * \brief The timeout in milliseconds.
-	     */
-	    unsigned m_timeout;
-
             /**
              * \brief Needed for m_connection_waitcondition.
 	     */
@@ -159,27 +145,66 @@ namespace agentxcpp
             QMutex m_mutex_is_connected;
 
             /**
-             * \brief Storage for ResponsePDU's.
-             *
-             * This map contains entries with packetID as key and 
-             * %ResponsePDU's as values. An entry with a NULL pointer value 
-             * means that a %ResponsePDU with the given packetID is awaited.
-             *
-             * This member is protected by m_response_mutex.
+             * \brief Triggers do_keepalive() (see startKeepalive()).
              */
-	    std::map< quint32, QSharedPointer<ResponsePDU> > m_responses;
+            QTimer m_keepalive_timer;
 
             /**
-             * \brief Used to protect m_responses and for m_response_arrived.
+             * \brief The keepalive interval in milliseconds, or 0 if the
+             *        keepalive is disabled.
              */
-	    QMutex m_response_mutex;
+            unsigned m_keepalive_interval;
 
             /**
-             * \brief A waitcondition to inform waiters of ResponsePDU's.
-             *
-             * The m_response_mutex is used for synchronization.
+             * \brief The time to wait for the response to a PingPDU, in
+             *        milliseconds.
+             */
+            unsigned m_keepalive_timeout;
+
+            /**
+             * \brief The sessionID put into the PingPDU's.
+             */
+            quint32 m_keepalive_session;
+
+            /**
+             * \brief Whether a PingPDU was sent and nothing was received
+             *        since.
+             */
+            bool m_ping_outstanding;
+
+            /**
+             * \brief Triggers do_reconnect() (see setAutoReconnect()).
+             */
+            QTimer m_reconnect_timer;
+
+            /**
+             * \brief Whether to reconnect automatically.
+             */
+            bool m_auto_reconnect;
+
+            /**
+             * \brief The delay before the first reconnect attempt, in
+             *        milliseconds.
              */
-	    QWaitCondition m_response_arrived;
+            unsigned m_backoff_min;
+
+            /**
+             * \brief The maximum delay between two reconnect attempts, in
+             *        milliseconds.
+             */
+            unsigned m_backoff_max;
+
+            /**
+             * \brief The delay before the next reconnect attempt, in
+             *        milliseconds.
+             */
+            unsigned m_backoff;
+
+            /**
+             * \brief Schedule the next reconnect attempt, doubling the
+             *        delay (up to m_backoff_max).
+             */
+            void schedule_reconnect();
 
         private slots:
 
@@ -189,13 +214,8 @@ namespace agentxcpp
              * This slot is connected to QLocalSocket::readyRead() and thus 
              * called when data arrives on the socket.
              *
-             * The function reads as many complete %PDU's from the socket, 
-             * parses them and invokes the pduArrived() signal for each %PDU, 
-             * except for ResponsePDU's.
-             *
-             * %ResponsePDU's are stored to the m_responses map, if the map has 
-             * an entry for the packetID of the received %ResponsePDU.  
-             * Otherwise, the %ResponsePDU is discarded.
+             * The function reads as many complete %PDU's from the socket 
+             * and passes them to Connector::dispatch().
              *
              * Certain errors cause the UnixDomainConnector object to 
              * disconnect. Other errors are ignored and the respective PDU is 
@@ -209,7 +229,10 @@ namespace agentxcpp
              * \brief Internal slot to send data.
              *
              * This slot is invoked when data must be sent. It serializes the 
-             * given %PDU and sends it. Errors are ignored.
+             * given %PDU into a SegmentedBuffer and sends it. While the write 
+             * buffer of the socket is empty, the segments are written to the 
+             * socket in a single sendmsg() call, so that large values (see 
+             * ByteArrayVariable) are not copied. Errors are ignored.
              *
              * \note Don't invoke this slot from outside the object!
              */
@@ -257,14 +280,80 @@ namespace agentxcpp
              */
             void do_disconnect();
 
-	signals:
-	    /**
-	     * \brief Emitted when a PDU arrived.
+            /**
+             * \brief Start or stop the keepalive.
              *
-             * This signal is emitted once for every arrived PDU, except for 
-             * %ResponsePDU's.
-	     */
-	    void pduArrived(QSharedPointer<PDU>);
+             * See startKeepalive() and stopKeepalive().
+             *
+             * \note Don't invoke this slot from outside the object!
+             */
+            void do_set_keepalive(uint sessionID, uint interval, uint timeout);
+
+            /**
+             * \brief Configure the automatic reconnect.
+             *
+             * See setAutoReconnect().
+             *
+             * \note Don't invoke this slot from outside the object!
+             */
+            void do_set_auto_reconnect(bool enabled,
+                                       uint min_delay, uint max_delay);
+
+            /**
+             * \brief Set the byte order of the sent PDU's.
+             *
+             * See setByteOrder().
+             *
+             * \note Don't invoke this slot from outside the object!
+             */
+            void do_set_byte_order(bool big_endian);
+
+            /**
+             * \brief Send a PingPDU, or detect a dead master agent.
+             *
+             * Called by m_keepalive_timer. If the previous PingPDU was not 
+             * answered (i.e. nothing was received since it was sent), the 
+             * connection is regarded as lost. Otherwise a PingPDU is sent 
+             * and the timer is set to the keepalive timeout.
+             *
+             * \note Don't invoke this slot from outside the object!
+             */
+            void do_keepalive();
+
+            /**
+             * \brief Handle the loss of the connection.
+             *
+             * Called when the socket was disconnected by the remote side or 
+             * when the keepalive detected a dead master agent. Closes the 
+             * socket, wakes all threads waiting in request() or 
+             * request_batch() (which then throw disconnected), emits 
+             * connectionLost() and schedules a reconnect attempt if enabled.
+             *
+             * Does nothing if the connector is not connected.
+             *
+             * \note Don't invoke this slot from outside the object!
+             */
+            void do_connection_lost();
+
+            /**
+             * \brief Try to reconnect the socket.
+             *
+             * Called by m_reconnect_timer. On success, reconnected() is 
+             * emitted. Otherwise the next attempt is scheduled.
+             *
+             * \note Don't invoke this slot from outside the object!
+             */
+            void do_reconnect();
+
+            /**
+             * \brief Close the socket and schedule the next reconnect
+             *        attempt.
+             *
+             * See reconnectFailed().
+             *
+             * \note Don't invoke this slot from outside the object!
+             */
+            void do_reconnect_failed();
 
         public:
             /**
@@ -305,7 +394,7 @@ namespace agentxcpp
              * \return True on success (i.e. if the object is in connected
              *         state), false otherwise.
              */
-            bool connect();
+            virtual bool connect();
 
             /**
              * \brief Disconnect from the remote entity.
@@ -321,14 +410,14 @@ namespace agentxcpp
              * The object will be in disconnected state after this method, no 
              * matter whether disconnecting times out or not.
              */
-            void disconnect();
+            virtual void disconnect();
 
             /**
 	     * \brief Find out whether the object is currently connected.
 	     *
 	     * \return True if the object is connected, false otherwise.
 	     */
-	    bool is_connected();
+	    virtual bool is_connected();
 
             /**
              * \brief Send a %PDU.
@@ -339,19 +428,76 @@ namespace agentxcpp
              *
              * \note Don't invoke do_send() yourself.
              */
-	    void send(QSharedPointer<PDU> pdu);
+	    virtual void send(QSharedPointer<PDU> pdu);
 
             /**
-             * \brief Send a PDU and wait for the response.
+             * \brief Start sending PingPDU's to detect a dead master agent.
+             *
+             * When nothing was received from the master agent for the 
+             * given interval, a PingPDU is sent (RFC 2741, 7.1.11. 
+             * "Processing the agentx-Ping-PDU"). If nothing is received 
+             * within the given timeout after that, the master agent is 
+             * regarded as dead and the connection as lost (see 
+             * connectionLost()). A dead master agent is thus detected 
+             * within interval + timeout milliseconds.
+             *
+             * The PingPDU's are sent from the connector's thread; this 
+             * function returns immediately.
+             *
+             * \param sessionID The session to ping.
+             *
+             * \param interval The idle time before a PingPDU is sent, in 
+             *                 milliseconds.
              *
-             * This method sends a %PDU. Then, it adds an entry to m_responses 
-             * to indicate that a ResponsePDU is awaited. Finally, it waits 
-             * until that ResponsePDU arrives and returns it (it is removed 
-             * from m_responses).
+             * \param timeout The time to wait for an answer, in 
+             *                milliseconds.
+             */
+            virtual void startKeepalive(quint32 sessionID,
+                                unsigned interval, unsigned timeout);
+
+            /**
+             * \brief Stop sending PingPDU's.
+             */
+            virtual void stopKeepalive();
+
+            /**
+             * \brief Reconnect automatically after a connection loss.
+             *
+             * If enabled, the connector tries to reconnect the socket after 
+             * a connection loss, first after min_delay milliseconds. The 
+             * delay is doubled after each failed attempt, up to max_delay 
+             * milliseconds. The attempts are made in the connector's 
+             * thread; when the socket is connected, reconnected() is 
+             * emitted. Automatic reconnect is disabled by default.
+             *
+             * \param enabled Whether to reconnect automatically.
+             *
+             * \param min_delay The delay before the first attempt.
+             *
+             * \param max_delay The maximum delay between two attempts.
+             */
+            virtual void setAutoReconnect(bool enabled,
+                                  unsigned min_delay, unsigned max_delay);
+
+            /**
+             * \brief Set the byte order of the sent PDU's.
+             *
+             * The OpenPDU and the ResponsePDU's are encoded in the given 
+             * byte order; the other PDU's always use big endian. By 
+             * default, big endian is used.
+             *
+             * \param big_endian Whether to use big endian.
+             */
+            virtual void setByteOrder(bool big_endian);
+
+            /**
+             * \brief Report that a new session could not be opened after 
+             *        reconnected() was emitted.
              *
-             * \todo Add timeout. Currently, the method does not time out.
+             * The socket is closed again and the next reconnect attempt is 
+             * scheduled with the doubled delay.
              */
-	    QSharedPointer<ResponsePDU> request(QSharedPointer<PDU> pdu);
+            virtual void reconnectFailed();
 
     };
 
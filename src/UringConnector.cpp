@@ -0,0 +1,542 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#include "UringConnector.hpp"
+
+#ifdef AGENTXCPP_IO_URING
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+
+#include <QMutexLocker>
+
+#include "Trace.hpp"
+
+using namespace agentxcpp;
+
+
+// The number of submission queue entries
+static const unsigned ring_entries = 64;
+
+// The number and the size of the receive buffers. The number must be a
+// power of 2.
+static const unsigned buffer_count = 16;
+static const unsigned buffer_size = 16384;
+
+// The ID of our provided buffer group
+static const unsigned short buffer_group = 0;
+
+// The kinds of requests, stored in the lower 8 bits of the user_data. The
+// upper bits contain the socket generation.
+enum
+{
+    kindReceive = 1,
+    kindSend = 2,
+    kindWakeup = 3
+};
+
+
+// There is no wrapper for these system calls in the C library
+static int uring_setup(unsigned entries, struct io_uring_params* params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(int ring, unsigned to_submit, unsigned min_complete,
+                       unsigned flags, void* arg, size_t argsz)
+{
+    return syscall(__NR_io_uring_enter, ring, to_submit, min_complete,
+                   flags, arg, argsz);
+}
+
+static int uring_register(int ring, unsigned opcode, void* arg,
+                          unsigned nr_args)
+{
+    return syscall(__NR_io_uring_register, ring, opcode, arg, nr_args);
+}
+
+
+UringConnector::UringConnector(const std::string& unix_domain_socket,
+                               unsigned timeout)
+: EpollConnector(unix_domain_socket, timeout),
+  m_ring(-1),
+  m_rings(MAP_FAILED),
+  m_rings_size(0),
+  m_sqes(0),
+  m_sqes_size(0),
+  m_sq_local_tail(0),
+  m_buf_ring(0),
+  m_buf_ring_size(0),
+  m_buffers(0),
+  m_buf_tail(0),
+  m_multishot(true),
+  m_generation(0),
+  m_in_flight_sent(0),
+  m_sending(false)
+{
+    // Create the ring. We need a single mapping for both queues and a 
+    // timeout for io_uring_enter().
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ring = uring_setup(ring_entries, &params);
+    if(m_ring == -1
+       || ! (params.features & IORING_FEAT_SINGLE_MMAP)
+       || ! (params.features & IORING_FEAT_EXT_ARG))
+    {
+        release();
+        throw(network_error());
+    }
+
+    // Map the queues
+    m_rings_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes
+                     + params.cq_entries * sizeof(struct io_uring_cqe);
+    if(cq_size > m_rings_size)
+    {
+        m_rings_size = cq_size;
+    }
+    m_rings = mmap(0, m_rings_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+    m_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(0, m_sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES);
+    if(m_rings == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        if(sqes != MAP_FAILED) munmap(sqes, m_sqes_size);
+        release();
+        throw(network_error());
+    }
+    m_sqes = static_cast<struct io_uring_sqe*>(sqes);
+    char* rings = static_cast<char*>(m_rings);
+    m_sq_head = reinterpret_cast<unsigned*>(rings + params.sq_off.head);
+    m_sq_tail = reinterpret_cast<unsigned*>(rings + params.sq_off.tail);
+    m_sq_array = reinterpret_cast<unsigned*>(rings + params.sq_off.array);
+    m_sq_mask = *reinterpret_cast<unsigned*>(rings + params.sq_off.ring_mask);
+    m_sq_entries = params.sq_entries;
+    m_sq_local_tail = *m_sq_tail;
+    m_cq_head = reinterpret_cast<unsigned*>(rings + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned*>(rings + params.cq_off.tail);
+    m_cqes = reinterpret_cast<struct io_uring_cqe*>(rings + params.cq_off.cqes);
+    m_cq_mask = *reinterpret_cast<unsigned*>(rings + params.cq_off.ring_mask);
+
+    // Register the receive buffers. The ring must be page aligned, the 
+    // buffers follow it in the same mapping.
+    m_buf_ring_size = buffer_count * sizeof(struct io_uring_buf)
+                      + buffer_count * buffer_size;
+    void* buf_ring = mmap(0, m_buf_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(buf_ring == MAP_FAILED)
+    {
+        release();
+        throw(network_error());
+    }
+    m_buf_ring = static_cast<struct io_uring_buf_ring*>(buf_ring);
+    m_buffers = static_cast<char*>(buf_ring)
+                + buffer_count * sizeof(struct io_uring_buf);
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<unsigned long>(buf_ring);
+    reg.ring_entries = buffer_count;
+    reg.bgid = buffer_group;
+    if(uring_register(m_ring, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        // Linux < 5.19
+        release();
+        throw(network_error());
+    }
+    for(unsigned short id = 0; id < buffer_count; id++)
+    {
+        recycle(id);
+    }
+
+    // Let wake() interrupt the I/O thread (submitted by the I/O thread)
+    QMutexLocker locker(&m_mutex);
+    arm_wakeup();
+    publish();
+}
+
+
+UringConnector::~UringConnector()
+{
+    // The I/O thread uses our members
+    stop_loop();
+    release();
+}
+
+
+void UringConnector::release()
+{
+    // Closing the ring cancels the outstanding requests
+    if(m_ring != -1)
+    {
+        ::close(m_ring);
+        m_ring = -1;
+    }
+    if(m_rings != MAP_FAILED)
+    {
+        munmap(m_rings, m_rings_size);
+        m_rings = MAP_FAILED;
+    }
+    if(m_sqes)
+    {
+        munmap(m_sqes, m_sqes_size);
+        m_sqes = 0;
+    }
+    if(m_buf_ring)
+    {
+        munmap(m_buf_ring, m_buf_ring_size);
+        m_buf_ring = 0;
+    }
+}
+
+
+struct io_uring_sqe* UringConnector::get_sqe()
+{
+    unsigned head = *static_cast<volatile unsigned*>(m_sq_head);
+    __sync_synchronize();
+    if(m_sq_local_tail - head >= m_sq_entries)
+    {
+        // Full. Can't happen: we have at most one receive, one send and
+        // one poll outstanding.
+        return 0;
+    }
+
+    unsigned index = m_sq_local_tail & m_sq_mask;
+    struct io_uring_sqe* sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    m_sq_array[index] = index;
+    m_sq_local_tail++;
+    return sqe;
+}
+
+
+unsigned UringConnector::publish()
+{
+    // The entries must be written before the kernel sees the new tail
+    __sync_synchronize();
+    *static_cast<volatile unsigned*>(m_sq_tail) = m_sq_local_tail;
+
+    return m_sq_local_tail - *static_cast<volatile unsigned*>(m_sq_head);
+}
+
+
+void UringConnector::submit()
+{
+    unsigned pending = publish();
+    if(pending != 0)
+    {
+        uring_enter(m_ring, pending, 0, 0, 0, 0);
+    }
+}
+
+
+void UringConnector::arm_receive()
+{
+    struct io_uring_sqe* sqe = get_sqe();
+    if(sqe == 0)
+    {
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = m_fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = buffer_group;
+    if(m_multishot)
+    {
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+    }
+    sqe->user_data = (quint64(m_generation) << 8) | kindReceive;
+}
+
+
+void UringConnector::arm_wakeup()
+{
+    struct io_uring_sqe* sqe = get_sqe();
+    if(sqe == 0)
+    {
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = m_wakeup;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = kindWakeup;
+}
+
+
+void UringConnector::queue_send()
+{
+    struct io_uring_sqe* sqe = get_sqe();
+    if(sqe == 0)
+    {
+        return;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = m_fd;
+    sqe->addr = reinterpret_cast<unsigned long>(m_in_flight.data()
+                                                + m_in_flight_sent);
+    sqe->len = m_in_flight.size() - m_in_flight_sent;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = (quint64(m_generation) << 8) | kindSend;
+    m_sending = true;
+}
+
+
+void UringConnector::recycle(unsigned short id)
+{
+    // (bufs is not usable in C++: the empty struct of __DECLARE_FLEX_ARRAY 
+    // has a size there, which moves it.)
+    struct io_uring_buf* bufs = reinterpret_cast<struct io_uring_buf*>(
+                                                                m_buf_ring);
+    struct io_uring_buf* buf = &bufs[m_buf_tail & (buffer_count - 1)];
+    buf->addr = reinterpret_cast<unsigned long>(m_buffers
+                                                + id * buffer_size);
+    buf->len = buffer_size;
+    buf->bid = id;
+    m_buf_tail++;
+
+    // The entry must be written before the kernel sees the new tail
+    __sync_synchronize();
+    *static_cast<volatile unsigned short*>(&m_buf_ring->tail) = m_buf_tail;
+}
+
+
+void UringConnector::socket_opened()
+{
+    // Completions of the previous socket are ignored from now on
+    m_generation++;
+
+    // Submitted by the I/O thread (woken by connect()), so that the
+    // completions are processed in its context rather than in the
+    // connecting thread
+    arm_receive();
+    publish();
+}
+
+
+void UringConnector::socket_closing()
+{
+    // Terminate the outstanding receive and send. Closing the socket 
+    // wouldn't do this, because they hold a reference to it.
+    shutdown(m_fd, SHUT_RDWR);
+    m_batch.clear();
+}
+
+
+void UringConnector::send(QSharedPointer<PDU> pdu)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // The buffer is reused for each PDU (see m_send_buffer)
+    SegmentedBuffer& data = m_send_buffer;
+    pdu->serialize_to(data);
+    if(m_stats)
+    {
+        m_stats->record_sent(data.size());
+    }
+    AGENTXCPP_TRACE(serialized, pdu->get_packetID(), pdu->get_transactionID(),
+                    data.segment(0).data[1], trace_varbind_count(*pdu));
+    if(m_fd == -1)
+    {
+        // Not connected: discard the PDU
+        data.clear();
+        return;
+    }
+
+    // Add the PDU to the batch
+    for(int i = 0; i < data.count(); i++)
+    {
+        const SegmentedBuffer::Segment& s = data.segment(i);
+        m_batch.append(reinterpret_cast<const quint8*>(s.data), s.size);
+    }
+    AGENTXCPP_TRACE(written, pdu->get_packetID(), pdu->get_transactionID(),
+                    data.segment(0).data[1], trace_varbind_count(*pdu));
+    data.clear();
+
+    if( ! m_sending )
+    {
+        // Send it now. Otherwise the I/O thread sends the batch when the 
+        // send in flight completed.
+        m_in_flight.swap(m_batch);
+        m_in_flight_sent = 0;
+        queue_send();
+        submit();
+    }
+}
+
+
+void UringConnector::sent(const struct io_uring_cqe& cqe)
+{
+    QMutexLocker locker(&m_mutex);
+
+    bool current = (cqe.user_data >> 8) == m_generation && m_fd != -1;
+    if(current && cqe.res > 0)
+    {
+        m_in_flight_sent += cqe.res;
+        if(m_in_flight_sent < m_in_flight.size())
+        {
+            // Partial send: send the rest
+            queue_send();
+            return;
+        }
+    }
+    else if(current && (cqe.res == -EINTR || cqe.res == -EAGAIN))
+    {
+        queue_send();
+        return;
+    }
+    // Otherwise the data is lost with the connection, which is detected
+    // by the receive.
+
+    // Send the PDU's collected meanwhile, if any
+    m_in_flight.clear();
+    m_in_flight_sent = 0;
+    m_sending = false;
+    if( ! m_batch.empty() && m_fd != -1 )
+    {
+        m_in_flight.swap(m_batch);
+        queue_send();
+    }
+}
+
+
+void UringConnector::received(const struct io_uring_cqe& cqe)
+{
+    bool has_buffer = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+    unsigned short id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+    bool lost = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if((cqe.user_data >> 8) != m_generation || ! begin_receive())
+        {
+            // A completion for a previous (or closed) socket
+            if(has_buffer) recycle(id);
+            return;
+        }
+
+        if(cqe.res > 0 && has_buffer)
+        {
+            m_input.append(reinterpret_cast<const quint8*>(m_buffers
+                                                    + id * buffer_size),
+                           cqe.res);
+        }
+        else if(cqe.res == -EINVAL && m_multishot)
+        {
+            // Linux < 6.0: receive one buffer at a time
+            m_multishot = false;
+        }
+        else if(cqe.res != -ENOBUFS
+                && cqe.res != -EINTR && cqe.res != -EAGAIN)
+        {
+            // Connection closed by the master agent, or error
+            lost = true;
+        }
+        if(has_buffer)
+        {
+            recycle(id);
+        }
+
+        // The kernel stops a multishot receive e.g. when it ran out of 
+        // buffers
+        if( ! lost && ! (cqe.flags & IORING_CQE_F_MORE) )
+        {
+            arm_receive();
+        }
+    }
+
+    process_input(lost);
+}
+
+
+bool UringConnector::run_once(int timeout)
+{
+    // Submit the entries queued by the previous iteration and wait for
+    // completions in a single system call. (If another thread submits 
+    // some of them meanwhile, io_uring_enter() submits fewer entries than 
+    // requested and returns without waiting. The next iteration waits 
+    // then.)
+    unsigned pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending = publish();
+    }
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if(timeout >= 0)
+    {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000L;
+        arg.ts = reinterpret_cast<unsigned long>(&ts);
+    }
+    uring_enter(m_ring, pending, 1,
+                IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                &arg, sizeof(arg));
+
+    // Handle the completions
+    bool happened = false;
+    unsigned head = *m_cq_head;
+    while(true)
+    {
+        unsigned tail = *static_cast<volatile unsigned*>(m_cq_tail);
+        __sync_synchronize();
+        if(head == tail)
+        {
+            break;
+        }
+        struct io_uring_cqe cqe = m_cqes[head & m_cq_mask];
+        head++;
+
+        // The kernel may reuse the entry now
+        __sync_synchronize();
+        *static_cast<volatile unsigned*>(m_cq_head) = head;
+        happened = true;
+
+        switch(cqe.user_data & 0xff)
+        {
+            case kindReceive:
+                received(cqe);
+                break;
+            case kindSend:
+                sent(cqe);
+                break;
+            case kindWakeup:
+            {
+                // Reset the eventfd; the loop re-reads the configuration
+                quint64 value;
+                ssize_t result = ::read(m_wakeup, &value, sizeof(value));
+                (void)result;
+                QMutexLocker locker(&m_mutex);
+                arm_wakeup();
+                break;
+            }
+        }
+    }
+
+    run_timers();
+
+    return happened;
+}
+
+#endif /* AGENTXCPP_IO_URING */
@@ -0,0 +1,327 @@
+/*
+ * Copyright 2011-2016 Tanjeff-Nicolai Moos <tanjeff@cccmz.de>
+ *
+ * This file is part of the agentXcpp library.
+ *
+ * AgentXcpp is free software: you can redistribute it and/or modify
+ * it under the terms of the AgentXcpp library license, version 1, which 
+ * consists of the GNU General Public License and some additional 
+ * permissions.
+ *
+ * AgentXcpp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * See the AgentXcpp library license in the LICENSE file of this package 
+ * for more details.
+ */
+
+#ifndef _URINGCONNECTOR_HPP_
+#define _URINGCONNECTOR_HPP_
+
+#ifdef AGENTXCPP_IO_URING
+
+#include <string>
+
+#include <linux/io_uring.h>
+
+#include "EpollConnector.hpp"
+
+
+namespace agentxcpp
+{
+    /**
+     * \internal
+     *
+     * \brief Connect to a unix domain socket using io_uring.
+     *
+     * This connector behaves like the EpollConnector (whose connection 
+     * handling, keepalive and reconnect it reuses), but performs the I/O 
+     * with an io_uring instance instead of one system call per read and 
+     * write:
+     *
+     * - A multishot receive is kept armed on the socket. The kernel puts 
+     *   the received data into buffers registered in advance (a provided 
+     *   buffer ring), so that no system call is needed to read. On kernels 
+     *   without multishot receives (before Linux 6.0), the receive is armed 
+     *   again after each completion.
+     * - send() copies the serialized %PDU into a batch. If no send is in 
+     *   flight, the batch is submitted immediately (one system call). 
+     *   Otherwise it is submitted by the I/O thread when the previous send 
+     *   completed, together with its next wait for completions, so that 
+     *   all %PDU's sent meanwhile go out in a single send without an 
+     *   additional system call.
+     * - The I/O thread waits for completions with io_uring_enter(), using 
+     *   its timeout for the keepalive and reconnect timers. It is woken by 
+     *   a poll request on the eventfd of the EpollConnector.
+     *
+     * This class is only available if the library was built with 
+     * <tt>--with-io-uring</tt> (which defines AGENTXCPP_IO_URING). The 
+     * constructor throws if io_uring is not available at runtime (e.g. on 
+     * kernels before 5.19, or if it is disabled by the system 
+     * administrator); the MasterProxy then uses an EpollConnector instead.
+     *
+     * \par Ring Access
+     *
+     * The submission queue is written by the thread calling send() and by 
+     * the I/O thread, always with m_mutex locked. The completion queue is 
+     * only read by the I/O thread. Completions carry the kind of the 
+     * request and a socket generation in their user_data, so that 
+     * completions of a previous connection are recognized and ignored.
+     */
+    class UringConnector : public EpollConnector
+    {
+        private:
+            /**
+             * \brief The io_uring instance.
+             */
+            int m_ring;
+
+            /**
+             * \brief The mapping of the submission and completion queues.
+             */
+            void* m_rings;
+
+            /**
+             * \brief The size of m_rings.
+             */
+            size_t m_rings_size;
+
+            /**
+             * \brief The submission queue entries (mapped).
+             */
+            struct io_uring_sqe* m_sqes;
+
+            /**
+             * \brief The size of the m_sqes mapping.
+             */
+            size_t m_sqes_size;
+
+            /**
+             * \brief The head of the submission queue (mapped).
+             */
+            unsigned* m_sq_head;
+
+            /**
+             * \brief The tail of the submission queue (mapped).
+             */
+            unsigned* m_sq_tail;
+
+            /**
+             * \brief The index array of the submission queue (mapped).
+             */
+            unsigned* m_sq_array;
+
+            /**
+             * \brief The mask for indexes into the submission queue.
+             */
+            unsigned m_sq_mask;
+
+            /**
+             * \brief The number of submission queue entries.
+             */
+            unsigned m_sq_entries;
+
+            /**
+             * \brief The tail of the submission queue, including the 
+             *        entries not yet published.
+             */
+            unsigned m_sq_local_tail;
+
+            /**
+             * \brief The head of the completion queue (mapped).
+             */
+            unsigned* m_cq_head;
+
+            /**
+             * \brief The tail of the completion queue (mapped).
+             */
+            unsigned* m_cq_tail;
+
+            /**
+             * \brief The completion queue entries (mapped).
+             */
+            struct io_uring_cqe* m_cqes;
+
+            /**
+             * \brief The mask for indexes into the completion queue.
+             */
+            unsigned m_cq_mask;
+
+            /**
+             * \brief The provided buffer ring and the buffers (one 
+             *        mapping).
+             */
+            struct io_uring_buf_ring* m_buf_ring;
+
+            /**
+             * \brief The size of the m_buf_ring mapping.
+             */
+            size_t m_buf_ring_size;
+
+            /**
+             * \brief The receive buffers, behind the ring in the same 
+             *        mapping.
+             */
+            char* m_buffers;
+
+            /**
+             * \brief The tail of the provided buffer ring (only accessed 
+             *        by the I/O thread).
+             */
+            unsigned short m_buf_tail;
+
+            /**
+             * \brief Whether the kernel supports multishot receives.
+             *
+             * Cleared when the first multishot receive fails with EINVAL.
+             */
+            bool m_multishot;
+
+            /**
+             * \brief The generation of the socket.
+             *
+             * Incremented each time a socket is opened.
+             */
+            unsigned m_generation;
+
+            /**
+             * \brief The %PDU's sent while another send was in flight.
+             */
+            binary m_batch;
+
+            /**
+             * \brief The data of the send in flight.
+             *
+             * Must not be modified until the send completed.
+             */
+            binary m_in_flight;
+
+            /**
+             * \brief The number of bytes of m_in_flight already sent.
+             */
+            size_t m_in_flight_sent;
+
+            /**
+             * \brief Whether a send is in flight.
+             *
+             * This may also be a send on a previous socket, whose 
+             * completion is still outstanding.
+             */
+            bool m_sending;
+
+            /**
+             * \brief Get a free submission queue entry.
+             *
+             * Must be called with m_mutex locked.
+             *
+             * \return The entry (cleared), or 0 if the queue is full.
+             */
+            struct io_uring_sqe* get_sqe();
+
+            /**
+             * \brief Make the entries obtained by get_sqe() visible to the 
+             *        kernel.
+             *
+             * They are submitted by the next io_uring_enter(). Must be 
+             * called with m_mutex locked.
+             *
+             * \return The number of entries not yet submitted.
+             */
+            unsigned publish();
+
+            /**
+             * \brief Publish the entries obtained by get_sqe() and submit 
+             *        them.
+             *
+             * Must be called with m_mutex locked.
+             */
+            void submit();
+
+            /**
+             * \brief Queue a receive on the socket.
+             *
+             * Must be called with m_mutex locked.
+             */
+            void arm_receive();
+
+            /**
+             * \brief Queue a poll request for the eventfd.
+             *
+             * Must be called with m_mutex locked.
+             */
+            void arm_wakeup();
+
+            /**
+             * \brief Queue a send of the rest of m_in_flight.
+             *
+             * Must be called with m_mutex locked.
+             */
+            void queue_send();
+
+            /**
+             * \brief Return a receive buffer to the provided buffer ring.
+             */
+            void recycle(unsigned short id);
+
+            /**
+             * \brief Handle the completion of a receive.
+             *
+             * Called by the I/O thread.
+             */
+            void received(const struct io_uring_cqe& cqe);
+
+            /**
+             * \brief Handle the completion of a send.
+             *
+             * Called by the I/O thread.
+             */
+            void sent(const struct io_uring_cqe& cqe);
+
+            /**
+             * \brief Release the ring and the buffers.
+             */
+            void release();
+
+        protected:
+            // Hooks of the EpollConnector (documented there)
+            virtual bool run_once(int timeout);
+            virtual void socket_opened();
+            virtual void socket_closing();
+
+        public:
+            /**
+             * \brief Constructor.
+             *
+             * Creates the io_uring instance and registers the receive 
+             * buffers.
+             *
+             * \param unix_domain_socket The path to the unix_domain_socket.
+             *
+             * \param timeout The timeout, in milliseconds, used for for
+             *                connecting and for waiting for responses.
+             *
+             * \exception network_error If io_uring or one of the required 
+             *                          features is not available.
+             */
+            UringConnector(const std::string& unix_domain_socket
+                                              = "/var/agentx/master",
+                           unsigned timeout = 1000);
+
+            /**
+             * \brief Destructor.
+             *
+             * Stops the I/O thread and closes the socket and the ring.
+             */
+            virtual ~UringConnector();
+
+            // The Connector interface (documented there)
+            virtual void send(QSharedPointer<PDU> pdu);
+    };
+
+}
+
+#endif /* AGENTXCPP_IO_URING */
+
+#endif /* _URINGCONNECTOR_HPP_ */
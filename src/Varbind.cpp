@@ -29,6 +29,7 @@
 #include "IpAddressVariable.hpp"
 #include "util.hpp"
 #include "OidVariable.hpp"
+#include "ByteArrayVariable.hpp"
 
 using namespace agentxcpp;
 
@@ -54,13 +55,32 @@ binary Varbind::serialize() const
 }
 
 
+void Varbind::serialize_to(SegmentedBuffer& out) const
+{
+    // encode type
+    out.write16(type);
+
+    // reserved field
+    out.write16(0);
+
+    // encode name
+    OidVariable(name).serialize_to(out);
+
+    // encode data if needed
+    if (var) var->serialize_to(out);
+}
+
+
 Varbind::Varbind(const Oid& o, QSharedPointer<AbstractVariable> v)
 {
     name = o;
     var = v;
 
     // Determine type of variable and fill type field.
-    if( qSharedPointerDynamicCast<IntegerVariable>(var) ) type = 2;
+    QSharedPointer<ByteArrayVariable> bytes;
+    bytes = qSharedPointerDynamicCast<ByteArrayVariable>(var);
+    if( bytes ) type = bytes->type();
+    else if( qSharedPointerDynamicCast<IntegerVariable>(var) ) type = 2;
     else if( qSharedPointerDynamicCast<OctetStringVariable>(var) ) type = 4;
     else if( qSharedPointerDynamicCast<OidVariable>(var) ) type = 6;
     else if( qSharedPointerDynamicCast<IpAddressVariable>(var) ) type = 64;
@@ -153,6 +153,16 @@ namespace agentxcpp
 	     */
 	    binary serialize() const;
 
+	    /**
+	     * \internal
+	     *
+	     * \brief Serialize the varbind into a segmented buffer.
+	     *
+	     * The variable is serialized using
+	     * AbstractVariable::serialize_to().
+	     */
+	    void serialize_to(SegmentedBuffer& out) const;
+
     };
 
 }
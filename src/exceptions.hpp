@@ -109,6 +109,35 @@ namespace agentxcpp
      */
     class unsupported_context : public std::exception { };
 
+    /**
+     * \brief Exception to indicate that an index value has the wrong type.
+     *
+     * This error occurs if an index value is allocated with a type which 
+     * differs from the type used by earlier allocations for the same index.
+     */
+    class index_wrong_type : public std::exception { };
+
+    /**
+     * \brief Exception to indicate that an index value is already 
+     *        allocated.
+     */
+    class index_already_allocated : public std::exception { };
+
+    /**
+     * \brief Exception to indicate that no index value is available for 
+     *        allocation.
+     *
+     * This error occurs if a new or any index value is requested, but the 
+     * master agent has none left.
+     */
+    class index_none_available : public std::exception { };
+
+    /**
+     * \brief Exception to indicate that an index value to be released was 
+     *        not allocated (by this subagent).
+     */
+    class index_not_allocated : public std::exception { };
+
 } // namespace agentxcpp
 
 #endif
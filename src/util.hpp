@@ -20,6 +20,8 @@
 #ifndef _HELPER_H_
 #define _HELPER_H_
 
+#include <cstring>
+
 #include <QtGlobal>
 
 #include "binary.hpp"
@@ -27,11 +29,24 @@
 
 namespace agentxcpp
 {
+    /**
+     * \brief Whether the host stores numbers in big endian format.
+     *
+     * Data in the host's byte order can be copied with memcpy() instead of 
+     * being assembled byte by byte.
+     */
+    const bool host_big_endian = (Q_BYTE_ORDER == Q_BIG_ENDIAN);
 
     inline quint64 read64(binary::const_iterator& pos, bool big_endian)
     {
         quint64 value;
-        if( big_endian )
+        if( big_endian == host_big_endian )
+        {
+            // Host byte order: copy
+            std::memcpy(&value, &*pos, sizeof(value));
+            pos += sizeof(value);
+        }
+        else if( big_endian )
         {
             value =  static_cast<quint64>(*pos++) << 56;
             value |= static_cast<quint64>(*pos++) << 48;
@@ -81,7 +96,13 @@ namespace agentxcpp
     inline quint32 read32(binary::const_iterator& pos, bool big_endian)
     {
         quint32 value;
-        if( big_endian )
+        if( big_endian == host_big_endian )
+        {
+            // Host byte order: copy
+            std::memcpy(&value, &*pos, sizeof(value));
+            pos += sizeof(value);
+        }
+        else if( big_endian )
         {
             value =  *pos++ << 24;
             value |= *pos++ << 16;
@@ -118,7 +139,13 @@ namespace agentxcpp
     inline quint16 read16(binary::const_iterator& pos, bool big_endian)
     {
         quint16 value = 0;
-        if( big_endian )
+        if( big_endian == host_big_endian )
+        {
+            // Host byte order: copy
+            std::memcpy(&value, &*pos, sizeof(value));
+            pos += sizeof(value);
+        }
+        else if( big_endian )
         {
             value |= *pos++ << 8;
             value |= *pos++ << 0;